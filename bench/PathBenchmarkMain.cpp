@@ -0,0 +1,239 @@
+// Pathfinding benchmark, run from the bin directory:
+//     pathbench [--queries N] [--seed S] [map ...]
+// Every map is searched with the scenarios of <map>.scen when that file exists, random connected pairs otherwise.
+// Without maps it runs the MovingAI maps in bin/maps plus a Perlin sand grid the size of the sandbox.
+
+#include "BatchPathfinder.h"
+#include "FlowField.h"
+#include "MovingAI.h"
+#include "PathBenchmark.h"
+#include "Perlin.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // hills like the sand, heights in [0, 1]
+    Grid<float> sandHeights(size_t width, size_t height, int seed)
+    {
+        Perlin2DNew perlin(1024, 512, seed);
+        Grid<float> noise = perlin.GeneratePerlinNoise(5, 0.5f);
+
+        Grid<float> heights(width, height, 0.0f);
+        for (size_t y = 0; y < height; y++)
+        {
+            for (size_t x = 0; x < width; x++)
+            {
+                heights.set(x, y, noise.get(x, y));
+            }
+        }
+        return heights;
+    }
+
+    // random pairs of cells that can be entered, unreachable goals are part of what is measured on the sand
+    std::vector<Scenario> sandScenarios(const Grid<float> & heights, const TraversalCosts & costs, size_t count, unsigned int seed)
+    {
+        Grid<uint8_t> passable(heights.width(), heights.height(), 0);
+        for (size_t i = 0; i < heights.width() * heights.height(); i++)
+        {
+            passable.set(i, heights.get(i) >= costs.minHeight ? 1 : 0);
+        }
+        return MovingAI::randomScenarios(passable, count, seed);
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // the heights after a hand dug a 32x32 hole where the most cells could be entered,
+    // a hole in a wall or a lake would leave every cluster as it was
+    Grid<float> digHole(Grid<float> heights, const TraversalCosts & costs)
+    {
+        const size_t size = std::min({ (size_t)32, heights.width(), heights.height() });
+        size_t bestX = 0, bestY = 0, best = 0;
+        for (size_t y0 = 0; y0 + size <= heights.height(); y0 += 8)
+        {
+            for (size_t x0 = 0; x0 + size <= heights.width(); x0 += 8)
+            {
+                size_t count = 0;
+                for (size_t y = y0; y < y0 + size; y++)
+                {
+                    for (size_t x = x0; x < x0 + size; x++) { count += heights.get(x, y) >= costs.minHeight ? 1 : 0; }
+                }
+                if (count > best) { best = count; bestX = x0; bestY = y0; }
+            }
+        }
+
+        for (size_t y = bestY; y < bestY + size; y++)
+        {
+            for (size_t x = bestX; x < bestX + size; x++)
+            {
+                heights.set(x, y, costs.minHeight - 1.0f);
+            }
+        }
+        return heights;
+    }
+
+    // what keeping the hierarchical graph up to date costs when the hole is dug
+    void printRepair(HierarchicalPathfinder & pathfinder, const Grid<float> & dug, const TraversalCosts & costs)
+    {
+        auto start = std::chrono::steady_clock::now();
+        size_t rebuilt = pathfinder.update(dug, costs);
+        double repair = secondsSince(start);
+
+        HierarchicalPathfinder fresh;
+        start = std::chrono::steady_clock::now();
+        fresh.update(dug, costs);
+        double full = secondsSince(start);
+
+        char line[256];
+        snprintf(line, sizeof(line), "32x32 change: %zu clusters rebuilt in %.2f ms, full rebuild %.2f ms\n", rebuilt, repair * 1e3, full * 1e3);
+        std::cout << line;
+    }
+
+    // one field towards the goal of the first scenario, computed from scratch and repaired after the hole is dug
+    void printFlowField(const Grid<float> & heights, const Grid<float> & dug, const std::vector<Scenario> & scenarios, const TraversalCosts & costs)
+    {
+        if (scenarios.empty()) { return; }
+
+        FlowField field;
+        field.setGoals({ scenarios.front().goal });
+        auto start = std::chrono::steady_clock::now();
+        field.update(heights, costs);
+        double full = secondsSince(start);
+        size_t settled = field.settled();
+
+        start = std::chrono::steady_clock::now();
+        size_t reset = field.update(dug, costs);
+        double repair = secondsSince(start);
+
+        char line[256];
+        snprintf(line, sizeof(line), "Flow field: %zu cells settled in %.2f ms, 32x32 change reset %zu cells in %.2f ms\n", settled, full * 1e3, reset, repair * 1e3);
+        std::cout << line;
+    }
+
+    // throughput of the whole scenario list as one batch, from one thread up to every core
+    void printBatchScaling(const Grid<float> & heights, const std::vector<Scenario> & scenarios, const TraversalCosts & costs)
+    {
+        std::vector<PathQuery> queries;
+        for (auto & scenario : scenarios) { queries.push_back({ scenario.start, scenario.goal }); }
+
+        std::vector<size_t> threadCounts;
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t threads = 1; threads < cores; threads *= 2) { threadCounts.push_back(threads); }
+        threadCounts.push_back(cores);
+
+        double single = 0.0;
+        for (size_t threads : threadCounts)
+        {
+            // the first batch grows the arenas, the second one is timed
+            BatchPathfinder batch(threads);
+            batch.solve(heights, queries, costs);
+            auto start = std::chrono::steady_clock::now();
+            batch.solve(heights, queries, costs);
+            double seconds = secondsSince(start);
+            if (threads == 1) { single = seconds; }
+
+            char line[256];
+            snprintf(line, sizeof(line), "Batch %2zu threads: %10.0f queries/s, speedup %5.2f, %zu cells, %zu KB\n",
+                threads, queries.size() / seconds, single / seconds, batch.cells().size(), batch.memoryUsage() / 1024);
+            std::cout << line;
+        }
+    }
+
+    void runMap(const std::string & name, const Grid<float> & heights, const std::vector<Scenario> & scenarios, const TraversalCosts & costs)
+    {
+        std::cout << "\n" << name << " (" << heights.width() << "x" << heights.height() << ", " << scenarios.size() << " queries)\n";
+
+        // plain A* runs first, it is the reference the other engines are checked against
+        PathBenchmark benchmark(scenarios);
+        benchmark.runAStar("A*", heights, costs);
+        benchmark.runAStar<AStarNodeArena>("A* (Node arena)", heights, costs);
+        benchmark.runAStar("Weighted A* 1.5", heights, costs, SearchMode::AStar, 1.5f);
+        benchmark.runAStar("Weighted A* 3", heights, costs, SearchMode::AStar, 3.0f);
+
+        // what the hikers use on the sand, the regions are labelled once per frame
+        RegionMap regions;
+        auto start = std::chrono::steady_clock::now();
+        regions.update(heights, costs);
+        double labelling = secondsSince(start);
+        benchmark.runAStar("Weighted A* 3, regions", heights, costs, SearchMode::AStar, 3.0f, &regions);
+
+        // jump point search only finds the same paths when every step costs the same
+        if (AStar::uniformCost(heights, costs))
+        {
+            benchmark.runAStar("Jump Point Search", heights, costs, SearchMode::JumpPoint);
+        }
+
+        HierarchicalPathfinder hierarchical;
+        start = std::chrono::steady_clock::now();
+        hierarchical.update(heights, costs);
+        double build = secondsSince(start);
+        benchmark.runHierarchical("Hierarchical", hierarchical);
+        benchmark.print(std::cout);
+
+        char line[256];
+        snprintf(line, sizeof(line), "Regions: %zu labelled in %.2f ms\n", regions.regionCount(), labelling * 1e3);
+        std::cout << line;
+        snprintf(line, sizeof(line), "Hierarchical graph: %zu clusters, %zu entrances, built in %.2f ms\n", hierarchical.clusterCount(), hierarchical.nodeCount(), build * 1e3);
+        std::cout << line;
+        Grid<float> dug = digHole(heights, costs);
+        printRepair(hierarchical, dug, costs);
+        printFlowField(heights, dug, scenarios, costs);
+        printBatchScaling(heights, scenarios, costs);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    size_t queries = 1000;
+    unsigned int seed = 1;
+    std::vector<std::string> maps;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--queries" && i + 1 < argc)   { queries = std::stoul(argv[++i]); }
+        else if (arg == "--seed" && i + 1 < argc) { seed = (unsigned int)std::stoul(argv[++i]); }
+        else                                      { maps.push_back(arg); }
+    }
+
+    bool defaults = maps.empty();
+    if (defaults)
+    {
+        maps = { "maps/Default.map", "maps/WheelofWar.map", "maps/swampofsorrows.map" };
+    }
+
+    for (auto & map : maps)
+    {
+        Grid<uint8_t> passable;
+        if (!MovingAI::loadMap(map, passable)) { continue; }
+
+        std::vector<Scenario> scenarios;
+        if (!MovingAI::loadScenarios(map + ".scen", scenarios))
+        {
+            scenarios = MovingAI::randomScenarios(passable, queries, seed);
+        }
+
+        runMap(map, MovingAI::toHeights(passable), scenarios, TraversalCosts());
+    }
+
+    if (defaults)
+    {
+        // the sand with slope costs, cells below the water line can't be entered
+        TraversalCosts costs;
+        costs.minHeight = 0.3f;
+        Grid<float> heights = sandHeights(534, 276, (int)seed);
+        runMap("Perlin sand", heights, sandScenarios(heights, costs, queries, seed), costs);
+    }
+
+    return 0;
+}
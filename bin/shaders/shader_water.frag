@@ -0,0 +1,18 @@
+#version 130
+uniform sampler2D currentTexture;
+
+void main()
+{
+	vec2 coord = gl_TexCoord[0].xy;
+	float depth = texture2D(currentTexture, coord)[0];
+
+	// dry sand stays untouched, shallow water is light and see-through, deep water dark and opaque
+	if (depth < 0.01)
+	{
+		discard;
+	}
+
+	vec3 shallow = vec3(0.45, 0.75, 1.0);
+	vec3 deep = vec3(0.0, 0.15, 0.55);
+	gl_FragColor = vec4(mix(shallow, deep, depth), 0.35 + 0.55 * depth);
+}
@@ -0,0 +1,264 @@
+#include "AStar.h"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+template <class Store>
+BasicAStar<Store>::BasicAStar(bool diagonal, SearchMode mode)
+    : m_actions(diagonal ? Actions8() : Actions4())
+    , m_diagonal(diagonal)
+{
+    setMode(mode);
+}
+
+template <class Store>
+void BasicAStar<Store>::setMode(SearchMode mode)
+{
+    m_mode = mode;
+    if (mode == SearchMode::JumpPoint)
+    {
+        m_diagonal = true;
+        m_actions = Actions8();
+    }
+}
+
+template <class Store>
+void BasicAStar<Store>::setWeight(float weight)
+{
+    m_weight = std::max(100, (int32_t)std::lround(weight * 100.0f));
+}
+
+template <class Store>
+bool BasicAStar<Store>::passable(const Grid<float> & heights, State s, const TraversalCosts & costs)
+{
+    if (s.x < 0 || s.y < 0 || s.x >= (int)heights.width() || s.y >= (int)heights.height()) { return false; }
+    return heights.get(s) >= costs.minHeight;
+}
+
+template <class Store>
+int32_t BasicAStar<Store>::stepCost(const Grid<float> & heights, State a, const Action & action, const TraversalCosts & costs)
+{
+    State b = a + action.dir;
+    if (!passable(heights, b, costs)) { return -1; }
+
+    // diagonal steps can't cut the corner of a blocked cell
+    if (action.dir.x != 0 && action.dir.y != 0)
+    {
+        if (!passable(heights, State(a.x + action.dir.x, a.y), costs) || !passable(heights, State(a.x, a.y + action.dir.y), costs)) { return -1; }
+    }
+
+    float climb = std::abs(heights.get(b) - heights.get(a));
+    if (climb > costs.maxStep) { return -1; }
+    return action.cost + (int32_t)(costs.slopePenalty * climb + 0.5f);
+}
+
+template <class Store>
+bool BasicAStar<Store>::uniformCost(const Grid<float> & heights, const TraversalCosts & costs)
+{
+    float lowest = 0.0f, highest = 0.0f;
+    bool any = false;
+    for (size_t i = 0; i < heights.width() * heights.height(); i++)
+    {
+        float h = heights.get(i);
+        if (h < costs.minHeight) { continue; }
+        lowest = any ? std::min(lowest, h) : h;
+        highest = any ? std::max(highest, h) : h;
+        any = true;
+    }
+
+    float range = highest - lowest;
+    return range == 0.0f || (range <= costs.maxStep && (int32_t)(costs.slopePenalty * range + 0.5f) == 0);
+}
+
+template <class Store>
+int32_t BasicAStar<Store>::heuristic(State a, State b) const
+{
+    State d = a.absdiff(b);
+    if (!m_diagonal) { return 100 * (d.x + d.y); }
+
+    int32_t straight = std::max(d.x, d.y);
+    int32_t diagonal = std::min(d.x, d.y);
+    return 100 * (straight - diagonal) + 141 * diagonal;
+}
+
+template <class Store>
+bool BasicAStar<Store>::search(const Grid<float> & heights, State start, State goal, const TraversalCosts & costs, std::vector<State> & path)
+{
+    PROFILE_FUNCTION();
+
+    path.clear();
+    m_stats = SearchStats();
+    m_width = heights.width();
+    m_height = heights.height();
+    m_store.prepare(m_width * m_height);
+    if (!passable(heights, start, costs) || !passable(heights, goal, costs)) { return false; }
+
+    m_store.open(cellIndex(start), 0, weightedHeuristic(start, goal), NoParent);
+
+    const uint32_t goalCell = cellIndex(goal);
+    while (!m_store.empty())
+    {
+        uint32_t cell = m_store.pop();
+        m_stats.expanded++;
+        if (cell == goalCell) { break; }
+
+        if (m_mode == SearchMode::JumpPoint)
+        {
+            expandJumpPoints(heights, cell, goal, costs);
+            continue;
+        }
+
+        State s = cellState(cell);
+        for (const Action & action : m_actions)
+        {
+            int32_t cost = stepCost(heights, s, action, costs);
+            if (cost >= 0) { relax(cell, s + action.dir, cost, goal); }
+        }
+    }
+
+    if (!m_store.seen(goalCell) || m_store.isOpen(goalCell)) { return false; }
+
+    // jump point parents can be many cells away, the cells in between lie on a straight or diagonal line
+    m_stats.cost = m_store.g(goalCell);
+    for (uint32_t cell = goalCell; cell != NoParent; cell = m_store.parent(cell))
+    {
+        State s = cellState(cell);
+        path.push_back(s);
+
+        uint32_t parentCell = m_store.parent(cell);
+        if (parentCell == NoParent) { break; }
+
+        State p = cellState(parentCell);
+        State step(p.x > s.x ? 1 : (p.x < s.x ? -1 : 0), p.y > s.y ? 1 : (p.y < s.y ? -1 : 0));
+        for (s = s + step; !(s == p); s = s + step)
+        {
+            path.push_back(s);
+        }
+    }
+    std::reverse(path.begin(), path.end());
+    return true;
+}
+
+template <class Store>
+void BasicAStar<Store>::relax(uint32_t cell, State next, int32_t cost, State goal)
+{
+    uint32_t child = cellIndex(next);
+    int32_t g = m_store.g(cell) + cost;
+
+    // a node that was seen but isn't open any more was expanded already
+    if (m_store.seen(child))
+    {
+        if (!m_store.isOpen(child) || g >= m_store.g(child)) { return; }
+        m_store.improve(child, g, cell);
+    }
+    else
+    {
+        m_store.open(child, g, weightedHeuristic(next, goal), cell);
+    }
+    m_stats.generated++;
+}
+
+template <class Store>
+bool BasicAStar<Store>::jump(const Grid<float> & heights, State s, State dir, State goal, const TraversalCosts & costs, State & jumpPoint) const
+{
+    auto open = [&](int x, int y) { return passable(heights, State(x, y), costs); };
+
+    while (true)
+    {
+        // the same step rules as stepCost, diagonal steps can't cut corners
+        if (!open(s.x + dir.x, s.y + dir.y)) { return false; }
+        if (dir.x != 0 && dir.y != 0 && (!open(s.x + dir.x, s.y) || !open(s.x, s.y + dir.y))) { return false; }
+        s = s + dir;
+
+        if (s == goal) { jumpPoint = s; return true; }
+
+        if (dir.x != 0 && dir.y != 0)
+        {
+            // a diagonal line stops where one of its straight lines finds something
+            State found;
+            if (jump(heights, s, State(dir.x, 0), goal, costs, found) || jump(heights, s, State(0, dir.y), goal, costs, found))
+            {
+                jumpPoint = s;
+                return true;
+            }
+        }
+        else if (dir.x != 0)
+        {
+            // a wall beside the line ended, the cell next to its end can only be reached well from here
+            if ((open(s.x, s.y - 1) && !open(s.x - dir.x, s.y - 1)) || (open(s.x, s.y + 1) && !open(s.x - dir.x, s.y + 1)))
+            {
+                jumpPoint = s;
+                return true;
+            }
+        }
+        else
+        {
+            if ((open(s.x - 1, s.y) && !open(s.x - 1, s.y - dir.y)) || (open(s.x + 1, s.y) && !open(s.x + 1, s.y - dir.y)))
+            {
+                jumpPoint = s;
+                return true;
+            }
+        }
+    }
+}
+
+template <class Store>
+void BasicAStar<Store>::expandJumpPoints(const Grid<float> & heights, uint32_t cell, State goal, const TraversalCosts & costs)
+{
+    // directions worth following given where the node was reached from, all of them for the start
+    const State s = cellState(cell);
+    const uint32_t parentCell = m_store.parent(cell);
+    State dirs[8];
+    int count = 0;
+    if (parentCell == NoParent)
+    {
+        for (const Action & action : m_actions) { dirs[count++] = action.dir; }
+    }
+    else
+    {
+        // the parent lies on a straight or diagonal line behind the node
+        State p = cellState(parentCell);
+        State d(s.x > p.x ? 1 : (s.x < p.x ? -1 : 0), s.y > p.y ? 1 : (s.y < p.y ? -1 : 0));
+        if (d.x != 0 && d.y != 0)
+        {
+            dirs[count++] = State(d.x, 0);
+            dirs[count++] = State(0, d.y);
+            dirs[count++] = d;
+        }
+        else if (d.x != 0)
+        {
+            dirs[count++] = d;
+            dirs[count++] = State(0, 1);
+            dirs[count++] = State(0, -1);
+            dirs[count++] = State(d.x, 1);
+            dirs[count++] = State(d.x, -1);
+        }
+        else
+        {
+            dirs[count++] = d;
+            dirs[count++] = State(1, 0);
+            dirs[count++] = State(-1, 0);
+            dirs[count++] = State(1, d.y);
+            dirs[count++] = State(-1, d.y);
+        }
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        State jumpPoint;
+        if (!jump(heights, s, dirs[i], goal, costs, jumpPoint)) { continue; }
+
+        // every step of the line costs the same, so the segment costs its octile distance
+        relax(cell, jumpPoint, heuristic(s, jumpPoint), goal);
+    }
+}
+
+template <class Store>
+size_t BasicAStar<Store>::memoryUsage() const
+{
+    return m_store.memoryUsage();
+}
+
+template class BasicAStar<CompactNodeStore>;
+template class BasicAStar<NodeArenaStore>;
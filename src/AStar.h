@@ -0,0 +1,105 @@
+#pragma once
+
+#include "Action.hpp"
+#include "Grid.hpp"
+#include "NodeStore.hpp"
+
+#include <vector>
+
+// How expensive it is to walk over the sand
+// A step costs its Action cost plus a penalty for the height difference it crosses,
+// so paths prefer to follow contour lines and go around hills instead of over them.
+struct TraversalCosts
+{
+    float   slopePenalty = 5000.0f;     // extra cost per unit of height difference, heights are in [0, 1]
+    float   maxStep = 0.05f;            // height difference between two cells that can't be climbed
+    float   minHeight = 0.0f;           // cells lower than this can't be entered (water, no data, walls)
+};
+
+enum class SearchMode
+{
+    AStar,          // every neighbour of every expanded cell, works with any costs
+    JumpPoint,      // Jump Point Search, only for grids where every cell that can be entered costs the same
+};
+
+struct SearchStats
+{
+    size_t  expanded = 0;               // nodes taken out of the open list
+    size_t  generated = 0;              // nodes put into the open list or improved in it
+    int32_t cost = -1;                  // cost of the path found, -1 when there is none
+};
+
+// A* over a height grid
+// Every cell has one node in a store that is allocated once per grid size and reused by every search.
+// Store decides how the nodes are laid out (NodeStore.hpp), AStar uses the compact one and AStarNodeArena
+// the one with a Node object per cell, which is kept to benchmark against. The open list is a binary heap
+// with decrease-key ordered by lowest f and then lowest g. The octile heuristic is consistent with the step costs,
+// so a node never has to be opened again once it was expanded.
+// With a weight above 1 the heuristic is scaled up (weighted A*), the search then heads for the goal and trades
+// path cost for expansions, a node is still never opened again which keeps the cost within the weight.
+// In JumpPoint mode symmetric paths are pruned: straight and diagonal lines are followed without putting
+// the cells on them into the open list, only cells with forced neighbours become nodes (Harabor and Grastien 2011,
+// in the variant where diagonal steps can't cut corners). Slopes are ignored, so it gives the same costs as A*
+// only on uniform grids, uniformCost() tells whether a grid is one.
+// One instance must not be used by two threads at once, give every thread its own.
+template <class Store>
+class BasicAStar
+{
+    Store               m_store;
+    std::vector<Action> m_actions;
+    bool                m_diagonal = true;
+    SearchMode          m_mode = SearchMode::AStar;
+    int32_t             m_weight = 100;         // heuristic weight in hundredths
+    size_t              m_width = 0;
+    size_t              m_height = 0;
+    SearchStats         m_stats;
+
+    inline uint32_t cellIndex(State s) const { return (uint32_t)(s.y * m_width + s.x); }
+    inline State cellState(uint32_t cell) const { return State((uint32_t)(cell % m_width), (uint32_t)(cell / m_width)); }
+
+    // puts next into the open list through cell, or improves it when it is already there
+    void relax(uint32_t cell, State next, int32_t cost, State goal);
+
+    // the next jump point from s in direction dir, false when the line runs into a wall first
+    bool jump(const Grid<float> & heights, State s, State dir, State goal, const TraversalCosts & costs, State & jumpPoint) const;
+    void expandJumpPoints(const Grid<float> & heights, uint32_t cell, State goal, const TraversalCosts & costs);
+
+public:
+
+    BasicAStar(bool diagonal = true, SearchMode mode = SearchMode::AStar);
+
+    // Jump Point Search always moves diagonally
+    void setMode(SearchMode mode);
+    inline SearchMode mode() const { return m_mode; }
+
+    // weighted A*, nodes are ordered by g + weight * h
+    // above 1 far fewer nodes are expanded and paths cost at most weight times the cheapest one
+    void setWeight(float weight);
+    inline float weight() const { return m_weight / 100.0f; }
+
+    // finds the cheapest path from start to goal, path receives every cell from start to goal
+    // returns false and leaves path empty when the goal can't be reached
+    bool search(const Grid<float> & heights, State start, State goal, const TraversalCosts & costs, std::vector<State> & path);
+
+    // cost of stepping from a to a + action, or -1 when the step isn't possible
+    static int32_t stepCost(const Grid<float> & heights, State a, const Action & action, const TraversalCosts & costs);
+
+    static bool passable(const Grid<float> & heights, State s, const TraversalCosts & costs);
+
+    // whether every step between two cells that can be entered costs only its Action cost
+    static bool uniformCost(const Grid<float> & heights, const TraversalCosts & costs);
+
+    // octile distance with the Action costs, a lower bound for every path
+    int32_t heuristic(State a, State b) const;
+
+    // the heuristic scaled by the weight, what nodes are opened with
+    inline int32_t weightedHeuristic(State a, State b) const { return m_weight == 100 ? heuristic(a, b) : heuristic(a, b) * m_weight / 100; }
+
+    inline const SearchStats & stats() const { return m_stats; }
+
+    // bytes held by the node store and the open list
+    size_t memoryUsage() const;
+};
+
+typedef BasicAStar<CompactNodeStore> AStar;
+typedef BasicAStar<NodeArenaStore> AStarNodeArena;
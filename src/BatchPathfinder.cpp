@@ -0,0 +1,70 @@
+#include "BatchPathfinder.h"
+#include "Profiler.hpp"
+
+BatchPathfinder::BatchPathfinder(size_t threads, SearchMode mode)
+    : m_pool(std::max((size_t)1, threads) - 1)
+    , m_workers(std::max((size_t)1, threads))
+{
+    for (auto & worker : m_workers) { worker.astar.setMode(mode); }
+}
+
+void BatchPathfinder::solve(const Grid<float> & heights, const std::vector<PathQuery> & queries, const TraversalCosts & costs)
+{
+    PROFILE_FUNCTION();
+
+    m_results.assign(queries.size(), PathResult());
+    m_solvedBy.assign(queries.size(), 0);
+
+    std::atomic<size_t> next = 0;
+    m_pool.run(m_workers.size(), [&](size_t w)
+    {
+        Worker & worker = m_workers[w];
+        worker.cells.clear();
+        worker.expanded = 0;
+
+        size_t q;
+        while ((q = next.fetch_add(1)) < queries.size())
+        {
+            bool found = worker.astar.search(heights, queries[q].start, queries[q].goal, costs, worker.path);
+            worker.expanded += worker.astar.stats().expanded;
+            if (!found) { continue; }
+
+            m_results[q] = { worker.cells.size(), worker.path.size(), worker.astar.stats().cost };
+            m_solvedBy[q] = (uint32_t)w;
+            worker.cells.insert(worker.cells.end(), worker.path.begin(), worker.path.end());
+        }
+    });
+
+    // gather the paths in query order
+    PROFILE_SCOPE("Gather Paths");
+    size_t total = 0;
+    for (auto & worker : m_workers) { total += worker.cells.size(); }
+    m_cells.resize(total);
+
+    size_t offset = 0;
+    for (size_t q = 0; q < m_results.size(); q++)
+    {
+        PathResult & result = m_results[q];
+        const State * source = m_workers[m_solvedBy[q]].cells.data() + result.offset;
+        std::copy(source, source + result.length, m_cells.begin() + offset);
+        result.offset = offset;
+        offset += result.length;
+    }
+}
+
+size_t BatchPathfinder::expanded() const
+{
+    size_t total = 0;
+    for (auto & worker : m_workers) { total += worker.expanded; }
+    return total;
+}
+
+size_t BatchPathfinder::memoryUsage() const
+{
+    size_t bytes = m_results.capacity() * sizeof(PathResult) + m_solvedBy.capacity() * sizeof(uint32_t) + m_cells.capacity() * sizeof(State);
+    for (auto & worker : m_workers)
+    {
+        bytes += worker.astar.memoryUsage() + (worker.path.capacity() + worker.cells.capacity()) * sizeof(State);
+    }
+    return bytes;
+}
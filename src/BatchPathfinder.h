@@ -0,0 +1,62 @@
+#pragma once
+
+#include "AStar.h"
+#include "TaskPool.hpp"
+
+#include <vector>
+
+struct PathQuery
+{
+    State   start;
+    State   goal;
+};
+
+struct PathResult
+{
+    size_t  offset = 0;                 // first cell of the path in the flat cell buffer
+    size_t  length = 0;                 // cells in the path, 0 when no path was found
+    int32_t cost = -1;                  // -1 when no path was found
+
+    inline bool found() const { return cost >= 0; }
+};
+
+// Solves many independent path queries at once, spread over a pool of threads
+// Every thread has its own AStar so the node arenas and open lists are reused from batch to batch and nothing
+// is allocated once they have grown, the heights are only read and shared by all of them.
+// Threads take queries one at a time so a few long searches don't leave the others idle.
+// The paths of a batch end up back to back in one buffer, in query order.
+class BatchPathfinder
+{
+    struct Worker
+    {
+        AStar               astar;
+        std::vector<State>  path;       // scratch for one search
+        std::vector<State>  cells;      // every path this thread found in the batch
+        size_t              expanded = 0;
+    };
+
+    TaskPool                m_pool;
+    std::vector<Worker>     m_workers;
+    std::vector<PathResult> m_results;
+    std::vector<uint32_t>   m_solvedBy; // worker that found each path, offsets point into its cells until they are gathered
+    std::vector<State>      m_cells;
+
+public:
+
+    // threads includes the calling one, which takes part in every batch
+    BatchPathfinder(size_t threads = std::max(1u, std::thread::hardware_concurrency()), SearchMode mode = SearchMode::AStar);
+
+    // solves every query, the results are valid until the next call
+    void solve(const Grid<float> & heights, const std::vector<PathQuery> & queries, const TraversalCosts & costs);
+
+    inline const std::vector<PathResult> & results() const { return m_results; }
+    inline const std::vector<State> & cells() const { return m_cells; }
+    inline const State * path(size_t query) const { return m_cells.data() + m_results[query].offset; }
+    inline size_t threads() const { return m_workers.size(); }
+
+    // nodes expanded by the last batch over all threads
+    size_t expanded() const;
+
+    // bytes held by every thread's search and the buffers
+    size_t memoryUsage() const;
+};
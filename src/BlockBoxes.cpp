@@ -0,0 +1,81 @@
+#include "BlockBoxes.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace mc
+{
+    void BoxMerger::clear()
+    {
+        m_row.clear();
+        m_rowBoxes.clear();
+        m_open.clear();
+        m_next.clear();
+        m_boxes.clear();
+    }
+
+    void BoxMerger::add(int x, int y1, int y2, int z, uint8_t block)
+    {
+        if (!m_row.empty() && z != m_rowZ) { endRow(); }
+        m_rowZ = z;
+        m_row.push_back({ x, y1, y2, block });
+    }
+
+    void BoxMerger::endRow()
+    {
+        // neighbouring columns with the same span end up next to each other once sorted by span then x
+        std::sort(m_row.begin(), m_row.end(), [](const Span & a, const Span & b)
+        {
+            return std::tie(a.y1, a.y2, a.block, a.x) < std::tie(b.y1, b.y2, b.block, b.x);
+        });
+
+        m_rowBoxes.clear();
+        for (const Span & span : m_row)
+        {
+            if (!m_rowBoxes.empty())
+            {
+                BlockBox & last = m_rowBoxes.back();
+                if (last.x2 + 1 == span.x && last.y1 == span.y1 && last.y2 == span.y2 && last.block == span.block)
+                {
+                    last.x2 = span.x;
+                    continue;
+                }
+            }
+            m_rowBoxes.push_back({ span.x, span.y1, m_rowZ, span.x, span.y2, m_rowZ, span.block });
+        }
+        m_row.clear();
+
+        // both lists sorted the same way, a box of this row continues an open box with the same key from the row before
+        auto key = [](const BlockBox & b) { return std::tie(b.x1, b.x2, b.y1, b.y2, b.block); };
+        std::sort(m_rowBoxes.begin(), m_rowBoxes.end(), [&](const BlockBox & a, const BlockBox & b) { return key(a) < key(b); });
+
+        m_next.clear();
+        size_t o = 0;
+        for (const BlockBox & box : m_rowBoxes)
+        {
+            while (o < m_open.size() && key(m_open[o]) < key(box))
+            {
+                m_boxes.push_back(m_open[o++]);
+            }
+            if (o < m_open.size() && key(m_open[o]) == key(box) && m_open[o].z2 + 1 == m_rowZ)
+            {
+                m_next.push_back(m_open[o++]);
+                m_next.back().z2 = m_rowZ;
+            }
+            else
+            {
+                m_next.push_back(box);
+            }
+        }
+        m_boxes.insert(m_boxes.end(), m_open.begin() + o, m_open.end());
+        std::swap(m_open, m_next);
+    }
+
+    const std::vector<BlockBox> & BoxMerger::finish()
+    {
+        if (!m_row.empty()) { endRow(); }
+        m_boxes.insert(m_boxes.end(), m_open.begin(), m_open.end());
+        m_open.clear();
+        return m_boxes;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mc
+{
+    // A box of one block, both corners included like the corners of a fill command
+    struct BlockBox
+    {
+        int     x1 = 0, y1 = 0, z1 = 0;
+        int     x2 = 0, y2 = 0, z2 = 0;
+        uint8_t block = 0;
+
+        inline std::size_t volume() const
+        {
+            return (std::size_t)(x2 - x1 + 1) * (y2 - y1 + 1) * (z2 - z1 + 1);
+        }
+    };
+
+    // Merges the spans of block columns into boxes of the same block
+    // Spans are added a row of z at a time with x ascending inside a row, the order ColumnCube walks its columns in.
+    // Spans of neighbouring columns with the same y range and block are joined along x, then the boxes of a row
+    // are joined with the boxes of the row before that cover the same x and y range.
+    class BoxMerger
+    {
+        struct Span
+        {
+            int     x, y1, y2;
+            uint8_t block;
+        };
+
+        std::vector<Span>       m_row;          // spans of the current row
+        int                     m_rowZ = 0;
+        std::vector<BlockBox>   m_rowBoxes;     // the spans of the current row joined along x
+        std::vector<BlockBox>   m_open;         // boxes that reach the previous row, sorted by x and y range and block
+        std::vector<BlockBox>   m_next;
+        std::vector<BlockBox>   m_boxes;        // boxes that can't grow any more
+
+        void endRow();
+
+    public:
+
+        // forgets all spans and boxes, keeps the memory
+        void clear();
+
+        // a span of a column from y1 to y2, both included
+        void add(int x, int y1, int y2, int z, uint8_t block);
+
+        // closes every box, the boxes stay valid until the next clear
+        const std::vector<BlockBox> & finish();
+    };
+
+    // calls f with pieces of box that hold at most maxVolume blocks, halving the longest side until they fit
+    template <class F>
+    void splitBox(const BlockBox & box, std::size_t maxVolume, F f)
+    {
+        if (box.volume() <= maxVolume)
+        {
+            f(box);
+            return;
+        }
+
+        BlockBox low = box, high = box;
+        const int dx = box.x2 - box.x1, dy = box.y2 - box.y1, dz = box.z2 - box.z1;
+        if (dx >= dy && dx >= dz) { low.x2 = box.x1 + dx / 2; high.x1 = low.x2 + 1; }
+        else if (dy >= dz)        { low.y2 = box.y1 + dy / 2; high.y1 = low.y2 + 1; }
+        else                      { low.z2 = box.z1 + dz / 2; high.z1 = low.z2 + 1; }
+        splitBox(low, maxVolume, f);
+        splitBox(high, maxVolume, f);
+    }
+}
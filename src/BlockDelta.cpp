@@ -0,0 +1,234 @@
+#include "BlockDelta.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr int SectionSize = 16;
+
+    constexpr uint64_t HashBasis = 14695981039346656037ull;
+    constexpr uint64_t HashPrime = 1099511628211ull;
+
+    inline uint64_t hashBytes(uint64_t hash, const void * data, size_t size)
+    {
+        const uint8_t * bytes = (const uint8_t *)data;
+        for (size_t i = 0; i < size; i++) { hash = (hash ^ bytes[i]) * HashPrime; }
+        return hash;
+    }
+
+    inline void putVarint(std::string & out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((char)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+
+    inline void putSigned(std::string & out, int64_t value)
+    {
+        putVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+    }
+
+    inline int floorDiv(int value, int divisor)
+    {
+        return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+    }
+
+    inline uint64_t sectionKey(int sx, int sz)
+    {
+        return ((uint64_t)(uint32_t)sx << 32) | (uint32_t)sz;
+    }
+
+    inline uint32_t read32(const uint8_t * p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    // the lengths past the 4 bits of the token, 255 until the last byte
+    inline void putLength(std::string & out, size_t length)
+    {
+        while (length >= 255)
+        {
+            out.push_back((char)255);
+            length -= 255;
+        }
+        out.push_back((char)length);
+    }
+}
+
+namespace mc
+{
+    void lz4Compress(const uint8_t * src, size_t size, std::string & out)
+    {
+        // the block format wants the last 5 bytes as literals and no match starting in the last 12
+        constexpr size_t MinMatch = 4, LastLiterals = 5, MatchFreeEnd = 12, HashBits = 12;
+
+        int32_t table[1 << HashBits];
+        std::fill(table, table + (1 << HashBits), -1);
+
+        auto emit = [&](size_t literalStart, size_t literals, size_t offset, size_t matchLength)
+        {
+            const size_t extra = matchLength > 0 ? matchLength - MinMatch : 0;
+            out.push_back((char)((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(extra, 15)));
+            if (literals >= 15) { putLength(out, literals - 15); }
+            out.append((const char *)src + literalStart, literals);
+            if (matchLength == 0) { return; }
+            out.push_back((char)(offset & 0xFF));
+            out.push_back((char)(offset >> 8));
+            if (extra >= 15) { putLength(out, extra - 15); }
+        };
+
+        size_t anchor = 0, i = 0;
+        while (size > MatchFreeEnd && i + MatchFreeEnd <= size)
+        {
+            const uint32_t sequence = read32(src + i);
+            const uint32_t h = (sequence * 2654435761u) >> (32 - HashBits);
+            const int32_t ref = table[h];
+            table[h] = (int32_t)i;
+
+            if (ref < 0 || i - ref > 0xFFFF || read32(src + ref) != sequence)
+            {
+                i++;
+                continue;
+            }
+
+            size_t length = MinMatch;
+            while (i + length < size - LastLiterals && src[ref + length] == src[i + length]) { length++; }
+            emit(anchor, i - anchor, i - ref, length);
+            i += length;
+            anchor = i;
+        }
+        emit(anchor, size - anchor, 0, 0);
+    }
+
+    void BlockDeltaEncoder::reset()
+    {
+        m_sections.clear();
+    }
+
+    void BlockDeltaEncoder::encode(const ColumnCube<uint8_t> & volume, const std::vector<std::string> & blockNames, int x, int y, int z,
+                                   size_t chunkBytes, bool compress, const std::function<void(std::string &)> & send)
+    {
+        m_stats = DeltaStats();
+        m_body.clear();
+        m_bodySections = 0;
+        if (volume.sizeX() == 0 || volume.sizeZ() == 0) { return; }
+
+        // a column hash covers where the column starts and what its ids mean, so a new palette or height resends it
+        uint64_t seed = hashBytes(HashBasis, &y, sizeof(y));
+        for (const std::string & name : blockNames) { seed = hashBytes(seed, name.data(), name.size() + 1); }
+
+        const int sx1 = floorDiv(x, SectionSize), sx2 = floorDiv(x + (int)volume.sizeX() - 1, SectionSize);
+        const int sz1 = floorDiv(z, SectionSize), sz2 = floorDiv(z + (int)volume.sizeZ() - 1, SectionSize);
+
+        uint8_t changed[SectionSize * SectionSize];
+        uint64_t hashes[SectionSize * SectionSize];
+        for (int sz = sz1; sz <= sz2; sz++)
+        {
+            const int lz1 = std::max(0, z - sz * SectionSize), lz2 = std::min(SectionSize, z + (int)volume.sizeZ() - sz * SectionSize);
+            for (int sx = sx1; sx <= sx2; sx++)
+            {
+                const int lx1 = std::max(0, x - sx * SectionSize), lx2 = std::min(SectionSize, x + (int)volume.sizeX() - sx * SectionSize);
+                Section & section = m_sections[sectionKey(sx, sz)];
+
+                size_t count = 0;
+                for (int lz = lz1; lz < lz2; lz++)
+                {
+                    for (int lx = lx1; lx < lx2; lx++)
+                    {
+                        const size_t vx = sx * SectionSize + lx - x, vz = sz * SectionSize + lz - z;
+                        const ColumnCube<uint8_t>::Run * runs = volume.columnRuns(vx, vz);
+                        uint64_t hash = seed;
+                        for (size_t r = 0; r < volume.runCount(vx, vz); r++)
+                        {
+                            hash = hashBytes(hash, &runs[r].top, sizeof(runs[r].top));
+                            hash = hashBytes(hash, &runs[r].value, sizeof(runs[r].value));
+                        }
+                        hash = std::max<uint64_t>(hash, 1);
+
+                        const int local = lz * SectionSize + lx;
+                        if (section.columns[local] != hash)
+                        {
+                            changed[count] = (uint8_t)local;
+                            hashes[count] = hash;
+                            count++;
+                        }
+                    }
+                }
+                if (count == 0) { continue; }
+
+                putSigned(m_body, sx);
+                putSigned(m_body, sz);
+                putVarint(m_body, count);
+                for (size_t c = 0; c < count; c++)
+                {
+                    const size_t vx = sx * SectionSize + (changed[c] % SectionSize) - x, vz = sz * SectionSize + (changed[c] / SectionSize) - z;
+                    const ColumnCube<uint8_t>::Run * runs = volume.columnRuns(vx, vz);
+                    const size_t runCount = volume.runCount(vx, vz);
+                    m_body.push_back((char)changed[c]);
+                    putVarint(m_body, runCount);
+                    uint16_t bottom = 0;
+                    for (size_t r = 0; r < runCount; r++)
+                    {
+                        putVarint(m_body, runs[r].top - bottom);
+                        putVarint(m_body, runs[r].value);
+                        bottom = runs[r].top;
+                    }
+                    section.columns[changed[c]] = hashes[c];
+                }
+
+                m_stats.sections++;
+                m_stats.columns += count;
+                m_stats.blocks += count * volume.sizeY();
+                m_bodySections++;
+                if (m_body.size() >= chunkBytes) { finishMessage(blockNames, y, compress, send); }
+            }
+        }
+        finishMessage(blockNames, y, compress, send);
+    }
+
+    void BlockDeltaEncoder::finishMessage(const std::vector<std::string> & blockNames, int baseY, bool compress,
+                                          const std::function<void(std::string &)> & send)
+    {
+        if (m_bodySections == 0) { return; }
+
+        m_raw.clear();
+        putVarint(m_raw, blockNames.size());
+        for (const std::string & name : blockNames)
+        {
+            putVarint(m_raw, name.size());
+            m_raw.append(name);
+        }
+        putSigned(m_raw, baseY);
+        putVarint(m_raw, m_bodySections);
+        m_raw.append(m_body);
+
+        m_message.assign("SBD\x01", 4);
+        if (compress)
+        {
+            m_message.push_back(1);
+            putVarint(m_message, m_raw.size());
+            lz4Compress((const uint8_t *)m_raw.data(), m_raw.size(), m_message);
+        }
+        // data that does not shrink goes out as it is
+        if (!compress || m_message.size() >= m_raw.size() + 5)
+        {
+            m_message.assign("SBD\x01", 4);
+            m_message.push_back(0);
+            m_message.append(m_raw);
+        }
+
+        m_stats.messages++;
+        m_stats.rawBytes += m_raw.size();
+        m_stats.bytes += m_message.size();
+        send(m_message);
+
+        m_body.clear();
+        m_bodySections = 0;
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "ColumnCube.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mc
+{
+    // what the last encode sent
+    struct DeltaStats
+    {
+        size_t  sections = 0;
+        size_t  columns = 0;
+        size_t  blocks = 0;                     // blocks in the columns sent
+        size_t  messages = 0;
+        size_t  rawBytes = 0;                   // message bytes before compression
+        size_t  bytes = 0;
+    };
+
+    // Encodes block columns in a compact binary format for links that are too slow for json
+    //
+    // A message is self contained, all numbers are varints (7 bits per byte, low bits first),
+    // the ones marked signed are zigzag encoded first:
+    //
+    //   "SBD" 1                     magic and version
+    //   flags                       one byte, bit 0: the rest is a single LZ4 block
+    //   [size]                      only when compressed, the size of the rest before compression
+    //   paletteSize                 then per block id: name length, name bytes
+    //   baseY (signed)              world y of the bottom of every column
+    //   sectionCount
+    //   per section:
+    //     sectionX, sectionZ (signed)   the 16x16 columns at world x = sectionX * 16 + lx, z = sectionZ * 16 + lz
+    //     columnCount
+    //     per column:
+    //       lz * 16 + lx            one byte
+    //       runCount                then per run from the bottom up: length, palette index
+    //
+    // A column replaces every block from baseY up to baseY plus the sum of its run lengths, a palette index
+    // past the end of the palette leaves the blocks of its run as they are.
+    //
+    // The encoder remembers a hash of every column it has sent, per 16x16 section of the world. A column is only
+    // encoded when its hash changed, a section without changed columns is left out, so a volume that moved or
+    // changed size still only sends the columns the world does not have yet.
+    class BlockDeltaEncoder
+    {
+        struct Section
+        {
+            uint64_t columns[256];              // hash of every column as sent, 0 if never sent
+        };
+
+        std::unordered_map<uint64_t, Section>   m_sections;
+        std::string                             m_body;         // sections of the message being built
+        std::string                             m_raw;
+        std::string                             m_message;
+        size_t                                  m_bodySections = 0;
+        DeltaStats                              m_stats;
+
+        void finishMessage(const std::vector<std::string> & blockNames, int baseY, bool compress,
+                           const std::function<void(std::string &)> & send);
+
+    public:
+
+        const DeltaStats & stats() const { return m_stats; }
+
+        // forgets every column sent, the next encode sends the whole volume
+        // the hashes are kept when a message is made, so this is also the way back after a message did not arrive
+        void reset();
+
+        // encodes the columns of volume at world (x, y, z) that changed since they were last encoded
+        // messages are cut at the first section past chunkBytes, send gets each message and may take its memory
+        void encode(const ColumnCube<uint8_t> & volume, const std::vector<std::string> & blockNames, int x, int y, int z,
+                    size_t chunkBytes, bool compress, const std::function<void(std::string &)> & send);
+    };
+
+    // appends src compressed as one LZ4 block (the raw LZ4 block format, no frame) to out
+    void lz4Compress(const uint8_t * src, size_t size, std::string & out);
+}
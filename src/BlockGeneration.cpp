@@ -1,79 +1,299 @@
 #include "BlockGeneration.h"
+#include "Profiler.hpp"
 #include <imgui-SFML.h>
 #include <imgui.h>
+#include <immintrin.h> // For AVX intrinsics
+
+#include <cstring>
+
+namespace
+{
+    // heightmap rows per strip handed to one thread
+    constexpr int StripRows = 32;
+
+    // voxels of z written at once, one AVX register of bytes
+    constexpr int SpanLength = 32;
+
+    // heightmap columns per strip of x handed to one thread when writing a Cube
+    constexpr int StripColumns = 16;
+
+    // the column heights of one heightmap row clamped into the volume, 8 at a time
+    // the float multiply and truncation are the same as the scalar (int)(value * blockScale)
+    void rowHeights(const float * row, int cols, int blockScale, int32_t * heights)
+    {
+        const __m256 scale = _mm256_set1_ps((float)blockScale);
+        const __m256i low = _mm256_setzero_si256();
+        const __m256i high = _mm256_set1_epi32(blockScale - 1);
+
+        int i = 0;
+        for (; i <= cols - 8; i += 8)
+        {
+            __m256i height = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(row + i), scale));
+            _mm256_storeu_si256((__m256i *)(heights + i), _mm256_min_epi32(_mm256_max_epi32(height, low), high));
+        }
+        for (; i < cols; ++i)
+        {
+            heights[i] = std::clamp((int)(row[i] * blockScale), 0, blockScale - 1);
+        }
+    }
+
+    // the blocks at height y of SpanLength columns, the k-th run of every column is in the k-th row of tops and values
+    // the value of a column is the one of its first run with a top above y, runs past the last have a top of UINT16_MAX
+    void writeSpan(const uint16_t * tops, const uint16_t * values, int stride, uint32_t runs, uint16_t y, uint8_t * span, int length)
+    {
+        const __m256i height = _mm256_set1_epi16((short)y);
+        __m256i half[2];
+        for (int h = 0; h < 2; ++h)
+        {
+            __m256i value = _mm256_loadu_si256((const __m256i *)(values + h * 16));
+            for (uint32_t k = 1; k < runs; ++k)
+            {
+                // y >= top of the run below, unsigned
+                __m256i top = _mm256_loadu_si256((const __m256i *)(tops + (k - 1) * stride + h * 16));
+                __m256i above = _mm256_cmpeq_epi16(_mm256_max_epu16(height, top), height);
+                value = _mm256_blendv_epi8(value, _mm256_loadu_si256((const __m256i *)(values + k * stride + h * 16)), above);
+            }
+            half[h] = value;
+        }
+
+        // packing works within 128 bit lanes, the permute puts the 32 bytes back in order
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(half[0], half[1]), 0xD8);
+        if (length == SpanLength)
+        {
+            _mm256_storeu_si256((__m256i *)span, bytes);
+        }
+        else
+        {
+            alignas(32) uint8_t last[SpanLength];
+            _mm256_store_si256((__m256i *)last, bytes);
+            std::memcpy(span, last, length);
+        }
+    }
+}
 
 namespace mc
 {
-    BasicGrassProfile::BasicGrassProfile()
+    void GenerationProfile::makeTable(int blockScale)
     {
-        m_blockNames = { "minecraft:air", "minecraft:stone", "minecraft:dirt", "minecraft:grass_block", "minecraft:water"};
+        BlockRun runs[ColumnCube<uint8_t>::MaxRuns + 2];
+        m_tableRuns.clear();
+        m_tableFirst.resize((size_t)blockScale + 1);
+        for (int height = 0; height < blockScale; ++height)
+        {
+            m_tableFirst[height] = (uint32_t)m_tableRuns.size();
+            size_t count = column(height, blockScale, runs);
+            m_tableRuns.insert(m_tableRuns.end(), runs, runs + count);
+        }
+        m_tableFirst[blockScale] = (uint32_t)m_tableRuns.size();
+
+        m_tableMaxRuns = 0;
+        for (int height = 0; height < blockScale; ++height)
+        {
+            m_tableMaxRuns = std::max(m_tableMaxRuns, m_tableFirst[height + 1] - m_tableFirst[height]);
+        }
     }
 
-    void BasicGrassProfile::imgui()
+    void GenerationProfile::computeHeights(const cv::Mat & input, int blockScale)
     {
-        ImGui::SliderFloat("MC Water Level", &m_waterLevel, 0.0f, 1.0f);
+        PROFILE_FUNCTION();
+
+        const int wx = input.cols;
+        m_heights.resize((size_t)wx * input.rows);
+        cv::parallel_for_(cv::Range(0, input.rows), [&](const cv::Range & range)
+        {
+            for (int j = range.start; j < range.end; ++j)
+            {
+                rowHeights(input.ptr<float>(j), wx, blockScale, m_heights.data() + (size_t)j * wx);
+            }
+        });
     }
 
-    void BasicGrassProfile::generate(Cube<uint8_t> & output, const cv::Mat & input, int blockScale)
+    void GenerationProfile::generate(Cube<uint8_t> & output, const cv::Mat & input, int blockScale)
     {
-        int wx = input.cols;
-        int wz = input.rows;
-        int water = (int)(std::ceil(blockScale * m_waterLevel));
+        PROFILE_FUNCTION();
 
-        if (wx <= 0 || wz <= 0) { return; }
+        const int wx = input.cols;
+        const int wz = input.rows;
 
-        output.refill(wx, blockScale, wz, 0);
+        if (wx <= 0 || wz <= 0 || blockScale <= 0) { return; }
 
-        for (int i = 0; i < wx; ++i)
+        makeTable(blockScale);
+        computeHeights(input, blockScale);
+
+        // every voxel is written below, so the old values don't have to be cleared
+        output.resize(wx, blockScale, wz);
+        uint8_t * cube = output.data();
+        const size_t sizeY = blockScale;
+        const size_t sizeZ = wz;
+
+        // in the x-major layout all of x is one contiguous block of memory and every y in it a contiguous span of z,
+        // so threads take strips of x and write their part of the cube front to back
+        // the runs of the columns of one x are laid out side by side and each span is made from them with AVX2
+        const int lanes = (wz + SpanLength - 1) / SpanLength * SpanLength;
+        const int strips = (wx + StripColumns - 1) / StripColumns;
+        cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range & range)
         {
-            for (int j = 0; j < wz; ++j)
+            std::vector<uint16_t> tops(m_tableMaxRuns * lanes);
+            std::vector<uint16_t> values(m_tableMaxRuns * lanes);
+            for (int x = range.start * StripColumns; x < std::min(range.end * StripColumns, wx); ++x)
             {
-                int height = (int)(input.at<float>(j, i) * blockScale);
-                if (height >= water)
+                for (int z = 0; z < lanes; ++z)
                 {
-                    output.fill(i, height, j, i, height, j, 3);
-                    height--;
+                    uint32_t first = 0, count = 0;
+                    if (z < wz)
+                    {
+                        const int32_t height = m_heights[(size_t)z * wx + x];
+                        first = m_tableFirst[height];
+                        count = m_tableFirst[height + 1] - first;
+                    }
+                    for (uint32_t k = 0; k < m_tableMaxRuns; ++k)
+                    {
+                        tops[k * lanes + z] = k < count ? m_tableRuns[first + k].top : UINT16_MAX;
+                        values[k * lanes + z] = k < count ? m_tableRuns[first + k].value : 0;
+                    }
                 }
-                else
+
+                uint8_t * span = cube + x * sizeY * sizeZ;
+                for (size_t y = 0; y < sizeY; ++y, span += sizeZ)
                 {
-                    output.fill(i, height, j, i, water, j, 4);
+                    for (int z = 0; z < wz; z += SpanLength)
+                    {
+                        writeSpan(tops.data() + z, values.data() + z, lanes, m_tableMaxRuns, (uint16_t)y, span + z, std::min(SpanLength, wz - z));
+                    }
                 }
-                if (height > 1)
+            }
+        });
+    }
+
+    void GenerationProfile::generate(ColumnCube<uint8_t> & output, const cv::Mat & input, int blockScale)
+    {
+        PROFILE_FUNCTION();
+
+        const int wx = input.cols;
+        const int wz = input.rows;
+
+        if (wx <= 0 || wz <= 0 || blockScale <= 0) { return; }
+
+        makeTable(blockScale);
+        computeHeights(input, blockScale);
+
+        // the columns are stored in the same order as the heightmap, one row after the other
+        // the first pass counts the runs of every strip, the second copies them to where the strip starts
+        const int strips = (wz + StripRows - 1) / StripRows;
+        std::vector<size_t> stripFirst(strips + 1, 0);
+        m_counts.resize((size_t)wx * wz);
+        cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range & range)
+        {
+            for (int s = range.start; s < range.end; ++s)
+            {
+                size_t total = 0;
+                for (size_t c = (size_t)s * StripRows * wx; c < (size_t)std::min((s + 1) * StripRows, wz) * wx; ++c)
                 {
-                    output.fill(i, height, j, i, height, j, 2);
-                    height--;
+                    const int32_t height = m_heights[c];
+                    m_counts[c] = (uint8_t)(m_tableFirst[height + 1] - m_tableFirst[height]);
+                    total += m_counts[c];
                 }
-                if (height > 1)
+                stripFirst[s + 1] = total;
+            }
+        });
+
+        for (int s = 0; s < strips; ++s) { stripFirst[s + 1] += stripFirst[s]; }
+        m_runs.resize(stripFirst[strips]);
+
+        cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range & range)
+        {
+            for (int s = range.start; s < range.end; ++s)
+            {
+                BlockRun * runs = m_runs.data() + stripFirst[s];
+                for (size_t c = (size_t)s * StripRows * wx; c < (size_t)std::min((s + 1) * StripRows, wz) * wx; ++c)
                 {
-                    output.fill(i, 0, j, i, height, j, 1);
+                    const int32_t height = m_heights[c];
+                    runs = std::copy(m_tableRuns.data() + m_tableFirst[height], m_tableRuns.data() + m_tableFirst[height + 1], runs);
                 }
             }
-        }
+        });
+
+        output.assign(wx, blockScale, wz, m_runs, m_counts);
     }
 
-    MonochromeProfile::MonochromeProfile()
+    GenerationTimes benchmarkGeneration(GenerationProfile & profile, const cv::Mat & input, int blockScale, int repeats)
     {
-        m_blockNames = { "minecraft:air", "minecraft:black_concrete", "minecraft:gray_concrete", "minecraft:light_gray_concrete", "minecraft:white_concrete"};
+        GenerationTimes times;
+        if (input.empty() || blockScale <= 0 || repeats <= 0) { return times; }
+
+        Cube<uint8_t> dense;
+        ColumnCube<uint8_t> runs;
+        auto time = [&](auto & output)
+        {
+            profile.generate(output, input, blockScale);        // the first one allocates
+            const int64 start = cv::getTickCount();
+            for (int r = 0; r < repeats; ++r) { profile.generate(output, input, blockScale); }
+            return (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency() / repeats;
+        };
+
+        times.voxels = (size_t)input.cols * input.rows * blockScale;
+        times.denseMS = time(dense);
+        times.runsMS = time(runs);
+
+        const int threads = cv::getNumThreads();
+        cv::setNumThreads(1);
+        times.denseSingleMS = time(dense);
+        times.runsSingleMS = time(runs);
+        cv::setNumThreads(threads);
+
+        return times;
     }
-    void MonochromeProfile::imgui()
+
+    BasicGrassProfile::BasicGrassProfile()
     {
+        m_blockNames = { "minecraft:air", "minecraft:stone", "minecraft:dirt", "minecraft:grass_block", "minecraft:water"};
     }
-    void MonochromeProfile::generate(Cube<uint8_t> & output, const cv::Mat & input, int blockScale)
-    {
-        int wx = input.cols;
-        int wz = input.rows;
 
-        if (wx <= 0 || wz <= 0) { return; }
+    void BasicGrassProfile::imgui()
+    {
+        ImGui::SliderFloat("MC Water Level", &m_waterLevel, 0.0f, 1.0f);
+    }
 
-        output.refill(wx, blockScale, wz, 0);
+    size_t BasicGrassProfile::column(int height, int blockScale, BlockRun * runs) const
+    {
+        int water = (int)(std::ceil(blockScale * m_waterLevel));
 
-        for (int i = 0; i < wx; ++i)
+        // the runs of one column of the given height, painted over air from the top down: grass at the height when it is
+        // above the water line, water from the height up to the line when it is not, then one block of dirt and stone below
+        // on land the dirt sits under the grass, under water it takes the place of the lowest block of water
+        runs[0] = { (uint16_t)blockScale, 0 };
+        size_t count = 1;
+        if (height >= water)
         {
-            for (int j = 0; j < wz; ++j)
-            {
-                int height = (int)(input.at<float>(j, i) * blockScale);
-                output.fill(i, 0, j, i, height, j, height * 4 / blockScale + 1);
-            }
+            count = ColumnCube<uint8_t>::paint(runs, count, blockScale, height, height, 3);
+            height--;
+        }
+        else
+        {
+            count = ColumnCube<uint8_t>::paint(runs, count, blockScale, height, water, 4);
         }
+        if (height > 1)
+        {
+            count = ColumnCube<uint8_t>::paint(runs, count, blockScale, height, height, 2);
+            height--;
+        }
+        if (height > 1)
+        {
+            count = ColumnCube<uint8_t>::paint(runs, count, blockScale, 0, height, 1);
+        }
+        return count;
+    }
+
+    MonochromeProfile::MonochromeProfile()
+    {
+        m_blockNames = { "minecraft:air", "minecraft:black_concrete", "minecraft:gray_concrete", "minecraft:light_gray_concrete", "minecraft:white_concrete"};
+    }
+    void MonochromeProfile::imgui()
+    {
+    }
+    size_t MonochromeProfile::column(int height, int blockScale, BlockRun * runs) const
+    {
+        runs[0] = { (uint16_t)blockScale, 0 };
+        return ColumnCube<uint8_t>::paint(runs, 1, blockScale, 0, height, (uint8_t)(height * 4 / blockScale + 1));
     }
 }
\ No newline at end of file
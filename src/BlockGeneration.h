@@ -3,18 +3,42 @@
 #include <vector>
 #include <string>
 #include <opencv2/opencv.hpp>
+#include "ColumnCube.hpp"
 #include "Cube.hpp"
 
 namespace mc
 {
+    typedef ColumnCube<uint8_t>::Run BlockRun;
+
     class GenerationProfile
     {
+        std::vector<BlockRun> m_runs;       // traded with the output on every generate so the memory is reused
+        std::vector<uint8_t> m_counts;
+
+        std::vector<BlockRun> m_tableRuns;  // the column of every height, one after the other
+        std::vector<uint32_t> m_tableFirst; // per height its first run in m_tableRuns, one more at the end
+        uint32_t m_tableMaxRuns = 0;        // the most runs of any height
+        std::vector<int32_t> m_heights;     // per column of the last heightmap, clamped into the volume
+
+        void makeTable(int blockScale);
+        void computeHeights(const cv::Mat & input, int blockScale);
+
     protected:
         std::vector<std::string> m_blockNames;
     public:
         virtual void imgui() = 0;
-        virtual void generate(Cube<uint8_t> & output, const cv::Mat & input, int blockScale) = 0;
+
+        // the runs of one column from the bottom up for a height in [0, blockScale), returns how many there are
+        // runs has room for ColumnCube<uint8_t>::MaxRuns + 2 runs
+        virtual size_t column(int height, int blockScale, BlockRun * runs) const = 0;
+
+        // both generates spread strips of heightmap rows over threads, a column only depends on its height
+        // so the columns of all heights are made once up front and copied from there
+        void generate(Cube<uint8_t> & output, const cv::Mat & input, int blockScale);
+        void generate(ColumnCube<uint8_t> & output, const cv::Mat & input, int blockScale);
+
         inline const std::string & blockName(uint8_t id) const { return m_blockNames[id]; };
+        inline const std::vector<std::string> & blockNames() const { return m_blockNames; }
         inline const size_t numberOfBlocks() const { return m_blockNames.size(); }
     };
 
@@ -24,7 +48,7 @@ namespace mc
     public:
         BasicGrassProfile();
         void imgui();
-        void generate(Cube<uint8_t> & output, const cv::Mat & input, int blockScale);
+        size_t column(int height, int blockScale, BlockRun * runs) const;
     };
 
     class MonochromeProfile : public GenerationProfile
@@ -32,6 +56,18 @@ namespace mc
     public:
         MonochromeProfile();
         void imgui();
-        void generate(Cube<uint8_t> & output, const cv::Mat & input, int blockScale);
+        size_t column(int height, int blockScale, BlockRun * runs) const;
     };
+
+    struct GenerationTimes
+    {
+        double  denseMS = 0.0;              // per generate into a Cube
+        double  runsMS = 0.0;               // per generate into a ColumnCube
+        double  denseSingleMS = 0.0;        // the same on one thread
+        double  runsSingleMS = 0.0;
+        size_t  voxels = 0;
+    };
+
+    // times repeats generates of input into both volumes, with all threads and with one
+    GenerationTimes benchmarkGeneration(GenerationProfile & profile, const cv::Mat & input, int blockScale, int repeats);
 }
@@ -6,6 +6,7 @@
 #include "imgui-SFML.h"
 #include "Profiler.hpp"
 #include "Save.hpp"
+#include "DepthFilters.h"
 
 #include <fstream>
 
@@ -14,11 +15,15 @@ struct CameraFilters
     float               m_smoothAlphaTemporal = 0.047f;
     int                 m_smoothDeltaTemporal = 72;
     int                 m_persistanceTemporal = 3;
+    bool                m_nativeTemporal = false;   // our own filter on the CV_16U depth instead of the realsense block
     rs2::temporal_filter m_temporalFilter;
+    TemporalDepthFilter m_nativeTemporalFilter;
 
     int                 m_holeFill = 1;
     rs2::hole_filling_filter m_holeFilter;
 
+    EdgePreservingFilter m_edgeFilter;
+
 public:
     rs2::frame apply(const rs2::frame & frame)
     {
@@ -31,7 +36,7 @@ public:
             temp = m_holeFilter.process(temp);
         }
 
-        if (m_smoothAlphaTemporal < 1.0f)
+        if (!m_nativeTemporal && m_smoothAlphaTemporal < 1.0f)
         {
             PROFILE_SCOPE("Temporal");
             m_temporalFilter.set_option(RS2_OPTION_FILTER_SMOOTH_ALPHA, m_smoothAlphaTemporal);
@@ -42,6 +47,25 @@ public:
         return temp;
     }
 
+    // our own filters, they work on the CV_16U depth once it is out of the realsense frame
+    void apply(cv::Mat & depth)
+    {
+        if (m_nativeTemporal && m_smoothAlphaTemporal < 1.0f)
+        {
+            PROFILE_SCOPE("Temporal");
+            m_nativeTemporalFilter.apply(depth, m_smoothAlphaTemporal, m_smoothDeltaTemporal, m_persistanceTemporal);
+        }
+        else
+        {
+            m_nativeTemporalFilter.reset();
+        }
+
+        {
+            PROFILE_SCOPE("Edge Preserving");
+            m_edgeFilter.apply(depth);
+        }
+    }
+
     void imgui()
     {
         PROFILE_FUNCTION();
@@ -49,11 +73,10 @@ public:
         if (ImGui::CollapsingHeader("Temporal Filter"))
         {
             ImGui::Indent();
+            ImGui::Checkbox("Native Temporal Filter", &m_nativeTemporal);
             ImGui::SliderFloat("Temporal Alpha", &m_smoothAlphaTemporal, 0.0, 1.0);
             ImGui::SliderInt("Temporal Delta", &m_smoothDeltaTemporal, 1, 100);
-            const char * persistance_options[] = { "Disabled", "Valid in 8/8", "Valid in 2/last 3", "Valid in 2/last 4", "Valid in 2/8",
-                                                  "Valid in 1/last 2", "Valid in 1/last 5", "Valid in 1/last 8", "Persist Indefinitely" };
-            ImGui::Combo("Persistance", &m_persistanceTemporal, persistance_options, 9);
+            ImGui::Combo("Persistance", &m_persistanceTemporal, TemporalDepthFilter::PersistenceNames, TemporalDepthFilter::PersistenceModes);
             ImGui::Unindent();
         }
 
@@ -64,6 +87,13 @@ public:
             ImGui::Combo("Fill Setting", &m_holeFill, hole_options, 4);
             ImGui::Unindent();
         }
+
+        if (ImGui::CollapsingHeader("Edge Preserving Filter"))
+        {
+            ImGui::Indent();
+            m_edgeFilter.imgui();
+            ImGui::Unindent();
+        }
     }
 
     void save(Save & save) const
@@ -71,7 +101,9 @@ public:
         save.temporalAlpha = m_smoothAlphaTemporal;
         save.temporalDelta = m_smoothDeltaTemporal;
         save.temporalPersistance = m_persistanceTemporal;
+        save.temporalNative = m_nativeTemporal;
         save.holeFill = m_holeFill;
+        m_edgeFilter.save(save);
     }
 
     void load(const Save & save)
@@ -79,6 +111,9 @@ public:
         m_smoothAlphaTemporal = save.temporalAlpha;
         m_smoothDeltaTemporal = save.temporalDelta;
         m_persistanceTemporal = save.temporalPersistance;
+        m_nativeTemporal = save.temporalNative;
+        m_nativeTemporalFilter.reset();
         m_holeFill = save.holeFill;
+        m_edgeFilter.load(save);
     }
 };
\ No newline at end of file
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// A volume stored as runs of equal values along y, one list of runs per (x, z) column
+// Terrain made from a heightmap is a few runs per column (stone, dirt, grass, air), so this holds
+// the same volume as a Cube in a fraction of the memory, and two volumes are compared run by run.
+// The runs of all columns sit back to back in one array in z-major column order, the same order as
+// the rows of the heightmap they are made from. A column that grows when it is edited moves to the end
+// of the array, the runs it leaves behind are reclaimed by compact().
+template <class T>
+class ColumnCube
+{
+public:
+
+    struct Run
+    {
+        uint16_t    top;                    // first y above the run, a run starts at the top of the one below it
+        T           value;
+    };
+
+    // a column can't hold more runs than this, the count of a column is a byte
+    // runs past the limit are dropped and the last run kept goes up to where the last one ended
+    static constexpr size_t MaxRuns = 255;
+
+private:
+
+    size_t m_sizeX = 0;
+    size_t m_sizeY = 0;
+    size_t m_sizeZ = 0;
+
+    std::vector<Run>        m_runs;
+    std::vector<uint32_t>   m_offsets;      // per column, its first run in m_runs
+    std::vector<uint8_t>    m_counts;       // per column, how many runs it has
+    size_t                  m_garbage = 0;  // runs no column uses any more
+
+    inline size_t column(size_t x, size_t z) const { return z * m_sizeX + x; }
+
+public:
+
+    ColumnCube() {}
+
+    ColumnCube(size_t sizeX, size_t sizeY, size_t sizeZ, T val)
+    {
+        refill(sizeX, sizeY, sizeZ, val);
+    }
+
+    // paints y0 to y1, both included, with val into a column of runs covering [0, sizeY)
+    // runs needs room for two more runs than count, returns the new count, which is never more than MaxRuns
+    static size_t paint(Run * runs, size_t count, size_t sizeY, size_t y0, size_t y1, const T & val)
+    {
+        if (y0 > y1) { std::swap(y0, y1); }
+        if (y0 >= sizeY) { return count; }
+        y1 = std::min(y1, sizeY - 1);
+
+        Run result[MaxRuns + 2];
+        size_t n = 0;
+        auto append = [&](uint16_t top, const T & value)
+        {
+            if (n > 0 && result[n - 1].value == value) { result[n - 1].top = top; }
+            else                                       { result[n++] = { top, value }; }
+        };
+
+        size_t start = 0;
+        bool painted = false;
+        for (size_t r = 0; r < count; r++)
+        {
+            size_t top = runs[r].top;
+            if (start < y0) { append((uint16_t)std::min(top, y0), runs[r].value); }
+            if (!painted && top > y0)
+            {
+                append((uint16_t)(y1 + 1), val);
+                painted = true;
+            }
+            if (top > y1 + 1) { append((uint16_t)top, runs[r].value); }
+            start = top;
+        }
+
+        n = limitRuns(result, n);
+        std::copy(result, result + n, runs);
+        return n;
+    }
+
+    // cuts runs down to MaxRuns, the last run kept takes over the top of the last one, returns the new count
+    static size_t limitRuns(Run * runs, size_t count)
+    {
+        if (count <= MaxRuns) { return count; }
+        runs[MaxRuns - 1].top = runs[count - 1].top;
+        return MaxRuns;
+    }
+
+    inline void refill(size_t sizeX, size_t sizeY, size_t sizeZ, T val)
+    {
+        m_sizeX = sizeX;
+        m_sizeY = sizeY;
+        m_sizeZ = sizeZ;
+        m_runs.assign(sizeX * sizeZ, { (uint16_t)sizeY, val });
+        m_counts.assign(sizeX * sizeZ, 1);
+        m_offsets.resize(sizeX * sizeZ);
+        for (size_t c = 0; c < m_offsets.size(); c++) { m_offsets[c] = (uint32_t)c; }
+        m_garbage = 0;
+    }
+
+    // replaces the whole volume, runs holds the runs of every column in column order and counts how many each one has
+    void assign(size_t sizeX, size_t sizeY, size_t sizeZ, std::vector<Run> & runs, std::vector<uint8_t> & counts)
+    {
+        m_sizeX = sizeX;
+        m_sizeY = sizeY;
+        m_sizeZ = sizeZ;
+        m_runs.swap(runs);
+        m_counts.swap(counts);
+        m_offsets.resize(sizeX * sizeZ);
+        uint32_t offset = 0;
+        for (size_t c = 0; c < m_offsets.size(); c++)
+        {
+            m_offsets[c] = offset;
+            offset += m_counts[c];
+        }
+        m_garbage = 0;
+    }
+
+    // replaces the runs of one column, the runs have to cover [0, sizeY), only the first MaxRuns are kept
+    void setColumn(size_t x, size_t z, const Run * runs, size_t count)
+    {
+        const size_t c = column(x, z);
+        const uint16_t top = runs[count - 1].top;
+        count = std::min(count, MaxRuns);
+        if (count > m_counts[c])
+        {
+            m_garbage += m_counts[c];
+            m_offsets[c] = (uint32_t)m_runs.size();
+            m_runs.resize(m_runs.size() + count);
+        }
+        else
+        {
+            m_garbage += m_counts[c] - count;
+        }
+        std::copy(runs, runs + count, m_runs.begin() + m_offsets[c]);
+        m_runs[m_offsets[c] + count - 1].top = top;
+        m_counts[c] = (uint8_t)count;
+
+        if (m_garbage > m_runs.size() / 2) { compact(); }
+    }
+
+    void fill(int x1, int y1, int z1, int x2, int y2, int z2, const T & val)
+    {
+        if (y1 < 0 && y2 < 0) { return; }
+
+        Run runs[MaxRuns + 2];
+        for (int x = std::max(std::min(x1, x2), 0); x <= std::min(std::max(x1, x2), (int)m_sizeX - 1); x++)
+        {
+            for (int z = std::max(std::min(z1, z2), 0); z <= std::min(std::max(z1, z2), (int)m_sizeZ - 1); z++)
+            {
+                size_t count = runCount(x, z);
+                std::copy(columnRuns(x, z), columnRuns(x, z) + count, runs);
+                count = paint(runs, count, m_sizeY, std::max(std::min(y1, y2), 0), std::max(y1, y2), val);
+                setColumn(x, z, runs, count);
+            }
+        }
+    }
+
+    // moves every column back into column order and drops the runs no column uses
+    void compact()
+    {
+        std::vector<Run> runs;
+        runs.reserve(m_runs.size() - m_garbage);
+        for (size_t c = 0; c < m_offsets.size(); c++)
+        {
+            const Run * first = m_runs.data() + m_offsets[c];
+            m_offsets[c] = (uint32_t)runs.size();
+            runs.insert(runs.end(), first, first + m_counts[c]);
+        }
+        m_runs.swap(runs);
+        m_garbage = 0;
+    }
+
+    void clear(T val)
+    {
+        refill(m_sizeX, m_sizeY, m_sizeZ, val);
+    }
+
+    inline const Run * columnRuns(size_t x, size_t z) const
+    {
+        return m_runs.data() + m_offsets[column(x, z)];
+    }
+
+    inline size_t runCount(size_t x, size_t z) const
+    {
+        return m_counts[column(x, z)];
+    }
+
+    inline T get(size_t x, size_t y, size_t z) const
+    {
+        const Run * run = columnRuns(x, z);
+        while (run->top <= y) { run++; }
+        return run->value;
+    }
+
+    inline void set(size_t x, size_t y, size_t z, T val)
+    {
+        fill((int)x, (int)y, (int)z, (int)x, (int)y, (int)z, val);
+    }
+
+    // calls f(x, y1, y2, z, value) for every span of a column, y2 excluded, where this volume holds value
+    // and other holds something else, every span is reported when the sizes differ
+    template <class F>
+    void forEachDifference(const ColumnCube & other, F f) const
+    {
+        const bool sameSize = other.m_sizeX == m_sizeX && other.m_sizeY == m_sizeY && other.m_sizeZ == m_sizeZ;
+        for (size_t z = 0; z < m_sizeZ; z++)
+        {
+            for (size_t x = 0; x < m_sizeX; x++)
+            {
+                const Run * a = columnRuns(x, z);
+                const size_t countA = runCount(x, z);
+                if (!sameSize)
+                {
+                    size_t start = 0;
+                    for (size_t r = 0; r < countA; r++) { f(x, start, (size_t)a[r].top, z, a[r].value); start = a[r].top; }
+                    continue;
+                }
+
+                const Run * b = other.columnRuns(x, z);
+                const size_t countB = other.runCount(x, z);
+                auto sameRun = [](const Run & r1, const Run & r2) { return r1.top == r2.top && r1.value == r2.value; };
+                if (countA == countB && std::equal(a, a + countA, b, sameRun)) { continue; }
+
+                // walk both run lists at once, the parts of a run of this volume that differ are joined when they touch
+                size_t y = 0, ib = 0;
+                for (size_t ia = 0; ia < countA; ia++)
+                {
+                    size_t spanStart = 0, spanEnd = 0;
+                    while (y < a[ia].top)
+                    {
+                        size_t end = std::min(a[ia].top, b[ib].top);
+                        if (!(b[ib].value == a[ia].value))
+                        {
+                            if (spanEnd != y)
+                            {
+                                if (spanEnd > spanStart) { f(x, spanStart, spanEnd, z, a[ia].value); }
+                                spanStart = y;
+                            }
+                            spanEnd = end;
+                        }
+                        y = end;
+                        if (b[ib].top == end) { ib++; }
+                    }
+                    if (spanEnd > spanStart) { f(x, spanStart, spanEnd, z, a[ia].value); }
+                }
+            }
+        }
+    }
+
+    inline size_t sizeX() const
+    {
+        return m_sizeX;
+    }
+
+    inline size_t sizeY() const
+    {
+        return m_sizeY;
+    }
+
+    inline size_t sizeZ() const
+    {
+        return m_sizeZ;
+    }
+
+    // bytes held by the runs and the column tables
+    size_t memoryUsage() const
+    {
+        return m_runs.capacity() * sizeof(Run) + m_offsets.capacity() * sizeof(uint32_t) + m_counts.capacity() * sizeof(uint8_t);
+    }
+};
@@ -65,6 +65,15 @@ public:
         }
     }
 
+    // changes the size without setting the values, for when every value is written next
+    inline void resize(size_t sizeX, size_t sizeY, size_t sizeZ)
+    {
+        m_sizeX = sizeX;
+        m_sizeY = sizeY;
+        m_sizeZ = sizeZ;
+        m_cube.resize(sizeX * sizeY * sizeZ);
+    }
+
     void fill(int x1, int y1, int z1, int x2, int y2, int z2, const T & val)
     {
         int xstep = (x2 - x1 >= 0) ? 1 : -1;
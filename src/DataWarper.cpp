@@ -74,6 +74,7 @@ void DataWarper::heightAdjustment(cv::Mat & matrix)
 
         m_plane[3] = -(m_plane[0] * m_planarPoints[1].x + m_plane[1] * m_planarPoints[1].y + m_plane[2] * m_baseHeight);
         m_updatePlane = false;
+        m_version++;
     }
 
     int width = matrix.cols;
@@ -182,6 +183,7 @@ void DataWarper::generateWarpMatrix()
             cv::Point2f((float)m_width, (float)m_height),
     };
     m_warpMatrix = cv::getPerspectiveTransform(m_warpPoints, dstPoints);
+    m_version++;
 }
 
 void DataWarper::save(Save & save) const
@@ -19,7 +19,7 @@ class DataWarper
     std::vector<sf::CircleShape>    m_planarCircles;
     float                           m_dataSize = 1.0f;
     bool                            m_drawCameraRegion = true;
-
+    size_t                          m_version = 0;              // bumped whenever the warp or the height plane changes
 
     // Height Adjustment
     float                           m_plane[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
@@ -42,5 +42,6 @@ public:
 
     inline bool shouldAdjustHeight() const { return m_applyHeightAdjustment; }
     inline const cv::Point2f* getPoints() const { return m_warpPoints; }
+    inline size_t getVersion() const { return m_version; }
 
 };
\ No newline at end of file
@@ -0,0 +1,677 @@
+#include "DepthFilters.h"
+#include "Profiler.hpp"
+#include "Timer.hpp"
+
+#include "imgui.h"
+#include "imgui-SFML.h"
+
+#include <immintrin.h> // For AVX intrinsics
+#include <bit>
+
+namespace
+{
+    constexpr int StripWidth = 64;
+    constexpr int StripRows = 16;           // rows filtered together by the row pass, two registers of lanes
+
+    // feedback between two neighbouring depth values, no data on either side cuts the link
+    inline float feedbackWeight(uint16_t a, uint16_t b, const std::vector<float> & table)
+    {
+        if (a == 0 || b == 0) { return 0.0f; }
+        size_t diff = (size_t)std::abs((int)a - (int)b);
+        return table[std::min(diff, table.size() - 1)];
+    }
+
+    // 8 feedback weights at once from depth widened to 32 bit, the same as feedbackWeight
+    inline __m256 feedbackWeight8(__m256i va, __m256i vb, const float * table, __m256i last)
+    {
+        __m256i index = _mm256_min_epi32(_mm256_abs_epi32(_mm256_sub_epi32(va, vb)), last);
+        __m256 weight = _mm256_i32gather_ps(table, index, 4);
+
+        __m256i zero = _mm256_setzero_si256();
+        __m256i invalid = _mm256_or_si256(_mm256_cmpeq_epi32(va, zero), _mm256_cmpeq_epi32(vb, zero));
+        return _mm256_andnot_ps(_mm256_castsi256_ps(invalid), weight);
+    }
+
+    inline __m256 feedbackWeight8(const uint16_t * a, const uint16_t * b, const float * table, __m256i last)
+    {
+        return feedbackWeight8(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)a)),
+                               _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)b)), table, last);
+    }
+
+    // one recursive pass down and back up every column of data
+    // rows are contiguous, so 8 neighbouring columns are filtered together, and strips of columns run in parallel
+    void recursiveColumns(cv::Mat & data, const cv::Mat & depth, const std::vector<float> & table)
+    {
+        const int rows = data.rows;
+        const int cols = data.cols;
+        const __m256i last = _mm256_set1_epi32((int)table.size() - 1);
+
+        cv::parallel_for_(cv::Range(0, (cols + StripWidth - 1) / StripWidth), [&](const cv::Range & range)
+        {
+            const int x0 = range.start * StripWidth;
+            const int x1 = std::min(cols, range.end * StripWidth);
+
+            // J[y] += w(y, y-1) * (J[y-1] - J[y])
+            for (int y = 1; y < rows; y++)
+            {
+                float * current = data.ptr<float>(y);
+                const float * previous = data.ptr<float>(y - 1);
+                const uint16_t * d = depth.ptr<uint16_t>(y);
+                const uint16_t * dPrevious = depth.ptr<uint16_t>(y - 1);
+
+                int x = x0;
+                for (; x + 8 <= x1; x += 8)
+                {
+                    __m256 w = feedbackWeight8(d + x, dPrevious + x, table.data(), last);
+                    __m256 c = _mm256_loadu_ps(current + x);
+                    __m256 p = _mm256_loadu_ps(previous + x);
+                    _mm256_storeu_ps(current + x, _mm256_add_ps(c, _mm256_mul_ps(w, _mm256_sub_ps(p, c))));
+                }
+                for (; x < x1; x++)
+                {
+                    current[x] += feedbackWeight(d[x], dPrevious[x], table) * (previous[x] - current[x]);
+                }
+            }
+
+            // J[y] += w(y, y+1) * (J[y+1] - J[y])
+            for (int y = rows - 2; y >= 0; y--)
+            {
+                float * current = data.ptr<float>(y);
+                const float * next = data.ptr<float>(y + 1);
+                const uint16_t * d = depth.ptr<uint16_t>(y);
+                const uint16_t * dNext = depth.ptr<uint16_t>(y + 1);
+
+                int x = x0;
+                for (; x + 8 <= x1; x += 8)
+                {
+                    __m256 w = feedbackWeight8(d + x, dNext + x, table.data(), last);
+                    __m256 c = _mm256_loadu_ps(current + x);
+                    __m256 n = _mm256_loadu_ps(next + x);
+                    _mm256_storeu_ps(current + x, _mm256_add_ps(c, _mm256_mul_ps(w, _mm256_sub_ps(n, c))));
+                }
+                for (; x < x1; x++)
+                {
+                    current[x] += feedbackWeight(d[x], dNext[x], table) * (next[x] - current[x]);
+                }
+            }
+        });
+    }
+
+    // transposes the 8x8 floats in r, lane k of r[i] becomes lane i of r[k]
+    inline void transpose8x8(__m256 * r)
+    {
+        __m256 t[8];
+        for (int i = 0; i < 8; i += 2)
+        {
+            t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+            t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+        }
+        for (int i = 0; i < 8; i += 4)
+        {
+            r[i] = _mm256_shuffle_ps(t[i], t[i + 2], 0x44);
+            r[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], 0xEE);
+            r[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], 0x44);
+            r[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], 0xEE);
+        }
+        for (int k = 0; k < 4; k++)
+        {
+            t[k] = _mm256_permute2f128_ps(r[k], r[k + 4], 0x20);
+            t[k + 4] = _mm256_permute2f128_ps(r[k], r[k + 4], 0x31);
+        }
+        for (int k = 0; k < 8; k++) { r[k] = t[k]; }
+    }
+
+    // copies between StripRows rows and a strip where they are interleaved, strip[x * StripRows + r] is rows[r][x]
+    // 8x8 blocks are transposed in registers, the columns past the last full block are copied one by one
+    void interleaveRows(float * const * rows, int cols, float * strip, bool back)
+    {
+        int x = 0;
+        for (; x + 8 <= cols; x += 8)
+        {
+            for (int g = 0; g < StripRows; g += 8)
+            {
+                __m256 r[8];
+                float * block = strip + (size_t)x * StripRows + g;
+                if (back)
+                {
+                    for (int i = 0; i < 8; i++) { r[i] = _mm256_loadu_ps(block + i * StripRows); }
+                    transpose8x8(r);
+                    for (int i = 0; i < 8; i++) { _mm256_storeu_ps(rows[g + i] + x, r[i]); }
+                }
+                else
+                {
+                    for (int i = 0; i < 8; i++) { r[i] = _mm256_loadu_ps(rows[g + i] + x); }
+                    transpose8x8(r);
+                    for (int i = 0; i < 8; i++) { _mm256_storeu_ps(block + i * StripRows, r[i]); }
+                }
+            }
+        }
+        for (; x < cols; x++)
+        {
+            for (int r = 0; r < StripRows; r++)
+            {
+                if (back) { rows[r][x] = strip[(size_t)x * StripRows + r]; }
+                else { strip[(size_t)x * StripRows + r] = rows[r][x]; }
+            }
+        }
+    }
+
+    // the same for depth, widened to 32 bit so the strip can be read 8 lanes at a time
+    void interleaveDepth(const uint16_t * const * rows, int cols, int32_t * strip)
+    {
+        int x = 0;
+        for (; x + 8 <= cols; x += 8)
+        {
+            for (int g = 0; g < StripRows; g += 8)
+            {
+                __m256 r[8];
+                for (int i = 0; i < 8; i++)
+                {
+                    r[i] = _mm256_castsi256_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(rows[g + i] + x))));
+                }
+                transpose8x8(r);
+                for (int i = 0; i < 8; i++) { _mm256_storeu_ps((float *)(strip + (size_t)(x + i) * StripRows + g), r[i]); }
+            }
+        }
+        for (; x < cols; x++)
+        {
+            for (int r = 0; r < StripRows; r++) { strip[(size_t)x * StripRows + r] = rows[r][x]; }
+        }
+    }
+
+    // one recursive pass along and back every row of data
+    // a row is one chain from each pixel to the next, so StripRows rows are interleaved into a strip and stepped
+    // together, 8 to a register, which also keeps two chains in flight
+    // the rows past the end of the image read zeros and are written into scratch
+    void recursiveRows(cv::Mat & data, const cv::Mat & depth, const std::vector<float> & table)
+    {
+        const int rows = data.rows;
+        const int cols = data.cols;
+        const __m256i last = _mm256_set1_epi32((int)table.size() - 1);
+
+        cv::parallel_for_(cv::Range(0, (rows + StripRows - 1) / StripRows), [&](const cv::Range & range)
+        {
+            std::vector<float> strip((size_t)cols * StripRows);
+            std::vector<int32_t> stripDepth((size_t)cols * StripRows);
+            std::vector<float> stripWeights((size_t)cols * StripRows);   // w(x, x-1) for every lane
+            std::vector<float> padding(cols);
+            const std::vector<uint16_t> noDepth(cols, 0);
+
+            for (int s = range.start; s < range.end; s++)
+            {
+                const int y0 = s * StripRows;
+                float * rowPtr[StripRows];
+                const uint16_t * depthPtr[StripRows];
+                for (int r = 0; r < StripRows; r++)
+                {
+                    rowPtr[r] = y0 + r < rows ? data.ptr<float>(y0 + r) : padding.data();
+                    depthPtr[r] = y0 + r < rows ? depth.ptr<uint16_t>(y0 + r) : noDepth.data();
+                }
+
+                interleaveRows(rowPtr, cols, strip.data(), false);
+                interleaveDepth(depthPtr, cols, stripDepth.data());
+                float * J = strip.data();
+                const int32_t * D = stripDepth.data();
+                float * W = stripWeights.data();
+
+                // J[x] += w(x, x-1) * (J[x-1] - J[x])
+                __m256 previous0 = _mm256_loadu_ps(J);
+                __m256 previous1 = _mm256_loadu_ps(J + 8);
+                __m256i depth0 = _mm256_loadu_si256((const __m256i *)D);
+                __m256i depth1 = _mm256_loadu_si256((const __m256i *)(D + 8));
+                for (int x = 1; x < cols; x++)
+                {
+                    const size_t i = (size_t)x * StripRows;
+                    __m256i d0 = _mm256_loadu_si256((const __m256i *)(D + i));
+                    __m256i d1 = _mm256_loadu_si256((const __m256i *)(D + i + 8));
+                    __m256 w0 = feedbackWeight8(d0, depth0, table.data(), last);
+                    __m256 w1 = feedbackWeight8(d1, depth1, table.data(), last);
+                    _mm256_storeu_ps(W + i, w0);
+                    _mm256_storeu_ps(W + i + 8, w1);
+                    depth0 = d0;
+                    depth1 = d1;
+
+                    __m256 c0 = _mm256_loadu_ps(J + i);
+                    __m256 c1 = _mm256_loadu_ps(J + i + 8);
+                    previous0 = _mm256_add_ps(c0, _mm256_mul_ps(w0, _mm256_sub_ps(previous0, c0)));
+                    previous1 = _mm256_add_ps(c1, _mm256_mul_ps(w1, _mm256_sub_ps(previous1, c1)));
+                    _mm256_storeu_ps(J + i, previous0);
+                    _mm256_storeu_ps(J + i + 8, previous1);
+                }
+
+                // J[x] += w(x, x+1) * (J[x+1] - J[x]), w(x, x+1) is stored with x + 1
+                __m256 next0 = previous0;
+                __m256 next1 = previous1;
+                for (int x = cols - 2; x >= 0; x--)
+                {
+                    const size_t i = (size_t)x * StripRows;
+                    __m256 c0 = _mm256_loadu_ps(J + i);
+                    __m256 c1 = _mm256_loadu_ps(J + i + 8);
+                    next0 = _mm256_add_ps(c0, _mm256_mul_ps(_mm256_loadu_ps(W + i + StripRows), _mm256_sub_ps(next0, c0)));
+                    next1 = _mm256_add_ps(c1, _mm256_mul_ps(_mm256_loadu_ps(W + i + StripRows + 8), _mm256_sub_ps(next1, c1)));
+                    _mm256_storeu_ps(J + i, next0);
+                    _mm256_storeu_ps(J + i + 8, next1);
+                }
+
+                interleaveRows(rowPtr, cols, strip.data(), true);
+            }
+        });
+    }
+
+    // index into [0, n) reflected around the edges without repeating them, like cv::BORDER_REFLECT_101
+    inline int reflect101(int i, int n)
+    {
+        if (i < 0) { return -i; }
+        if (i >= n) { return 2 * n - 2 - i; }
+        return i;
+    }
+
+    // widths of the three boxes whose stacked variance is closest to sigma^2, all odd
+    std::array<int, 3> boxWidths(float sigma)
+    {
+        const int passes = 3;
+        double ideal = std::sqrt(12.0 * sigma * sigma / passes + 1.0);
+        int lower = (int)std::floor(ideal);
+        if (lower % 2 == 0) { lower--; }
+        int upper = lower + 2;
+
+        double m = (12.0 * sigma * sigma - passes * lower * lower - 4.0 * passes * lower - 3.0 * passes) / (-4.0 * lower - 4.0);
+        int lowerCount = (int)std::round(m);
+
+        std::array<int, 3> widths;
+        for (int i = 0; i < passes; i++) { widths[i] = i < lowerCount ? lower : upper; }
+        return widths;
+    }
+
+    // one box blur along a row with a running sum
+    void boxRow(const float * src, float * dst, int n, int radius)
+    {
+        radius = std::min(radius, n - 1);
+        if (radius <= 0) { std::copy(src, src + n, dst); return; }
+
+        const float scale = 1.0f / (2 * radius + 1);
+        float sum = 0.0f;
+        for (int k = -radius; k <= radius; k++) { sum += src[reflect101(k, n)]; }
+        for (int x = 0; x < n - 1; x++)
+        {
+            dst[x] = sum * scale;
+            sum += src[reflect101(x + radius + 1, n)] - src[reflect101(x - radius, n)];
+        }
+        dst[n - 1] = sum * scale;
+    }
+
+    // one box blur down the columns [x0, x1) with a running sum per column
+    void boxColumns(const cv::Mat & src, cv::Mat & dst, int x0, int x1, int radius, std::vector<float> & sum)
+    {
+        const int rows = src.rows;
+        const int width = x1 - x0;
+        radius = std::min(radius, rows - 1);
+        if (radius <= 0)
+        {
+            for (int y = 0; y < rows; y++) { std::copy(src.ptr<float>(y) + x0, src.ptr<float>(y) + x1, dst.ptr<float>(y) + x0); }
+            return;
+        }
+
+        const float scale = 1.0f / (2 * radius + 1);
+        sum.assign(width, 0.0f);
+        float * s = sum.data();
+        for (int k = -radius; k <= radius; k++)
+        {
+            const float * row = src.ptr<float>(reflect101(k, rows)) + x0;
+            for (int x = 0; x < width; x++) { s[x] += row[x]; }
+        }
+
+        for (int y = 0; y < rows; y++)
+        {
+            float * out = dst.ptr<float>(y) + x0;
+            if (y == rows - 1)
+            {
+                for (int x = 0; x < width; x++) { out[x] = s[x] * scale; }
+                break;
+            }
+
+            const float * add = src.ptr<float>(reflect101(y + radius + 1, rows)) + x0;
+            const float * remove = src.ptr<float>(reflect101(y - radius, rows)) + x0;
+            int x = 0;
+            for (; x + 8 <= width; x += 8)
+            {
+                __m256 vs = _mm256_loadu_ps(s + x);
+                _mm256_storeu_ps(out + x, _mm256_mul_ps(vs, _mm256_set1_ps(scale)));
+                vs = _mm256_add_ps(vs, _mm256_sub_ps(_mm256_loadu_ps(add + x), _mm256_loadu_ps(remove + x)));
+                _mm256_storeu_ps(s + x, vs);
+            }
+            for (; x < width; x++)
+            {
+                out[x] = s[x] * scale;
+                s[x] += add[x] - remove[x];
+            }
+        }
+    }
+    // the last `window` frames before `frame` in the 8 bit history, the current frame's bit is excluded
+    inline uint16_t historyWindow(int frame, int window)
+    {
+        uint16_t bits = 0;
+        for (int i = 1; i <= window; i++) { bits |= (uint16_t)(1 << ((frame - i + 8) % 8)); }
+        return bits;
+    }
+
+    // how many of the bits of a 16 bit lane are set, for lanes that only use their low byte
+    inline __m256i popcount8(__m256i v)
+    {
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low = _mm256_set1_epi8(0x0f);
+        __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low));
+        __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+        return _mm256_and_si256(_mm256_add_epi8(lo, hi), _mm256_set1_epi16(0x00ff));
+    }
+
+    struct TemporalParameters
+    {
+        float       alpha;
+        uint16_t    delta;
+        uint16_t    frameBit;       // bit of the current frame in the history
+        uint16_t    window;         // history bits that count towards persistence
+        int         required;       // valid frames needed in the window to fill a hole
+    };
+
+    // one pixel of the temporal filter, the same rules as librealsense's temporal_filter
+    inline void temporalPixel(uint16_t & depth, uint16_t & last, uint16_t & history, const TemporalParameters & p)
+    {
+        const uint16_t current = depth;
+        const uint16_t previous = last;
+        if (current)
+        {
+            int diff = std::abs((int)current - (int)previous);
+            if (previous && diff < p.delta)
+            {
+                uint16_t filtered = (uint16_t)(p.alpha * current + (1.0f - p.alpha) * previous);
+                depth = filtered;
+                last = filtered;
+                history |= p.frameBit;
+            }
+            else
+            {
+                last = current;
+                history = p.frameBit;
+            }
+        }
+        else
+        {
+            int valid = std::popcount((unsigned)(history & p.window));
+            if (previous && valid >= p.required) { depth = previous; }
+            history &= ~p.frameBit;
+        }
+    }
+
+    // 16 pixels of temporalPixel at once
+    inline void temporalPixels16(uint16_t * depth, uint16_t * last, uint16_t * history, const TemporalParameters & p)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i ones = _mm256_set1_epi16(-1);
+        const __m256i frameBit = _mm256_set1_epi16((short)p.frameBit);
+
+        __m256i current = _mm256_loadu_si256((const __m256i *)depth);
+        __m256i previous = _mm256_loadu_si256((const __m256i *)last);
+        __m256i hist = _mm256_loadu_si256((const __m256i *)history);
+
+        __m256i currentValid = _mm256_xor_si256(_mm256_cmpeq_epi16(current, zero), ones);
+        __m256i previousValid = _mm256_xor_si256(_mm256_cmpeq_epi16(previous, zero), ones);
+
+        // |current - previous| < delta, unsigned
+        __m256i diff = _mm256_or_si256(_mm256_subs_epu16(current, previous), _mm256_subs_epu16(previous, current));
+        __m256i deltaMinusOne = _mm256_set1_epi16((short)(p.delta - 1));
+        __m256i close = _mm256_cmpeq_epi16(_mm256_min_epu16(diff, deltaMinusOne), diff);
+        if (p.delta == 0) { close = zero; }
+        __m256i agree = _mm256_and_si256(_mm256_and_si256(currentValid, previousValid), close);
+
+        // alpha * current + (1 - alpha) * previous in floats, truncated like the scalar cast
+        const __m256 alpha = _mm256_set1_ps(p.alpha);
+        const __m256 beta = _mm256_set1_ps(1.0f - p.alpha);
+        auto blend8 = [&](__m128i c, __m128i q)
+        {
+            __m256 fc = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(c));
+            __m256 fq = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(q));
+            return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(alpha, fc), _mm256_mul_ps(beta, fq)));
+        };
+        __m256i lo = blend8(_mm256_castsi256_si128(current), _mm256_castsi256_si128(previous));
+        __m256i hi = blend8(_mm256_extracti128_si256(current, 1), _mm256_extracti128_si256(previous, 1));
+        __m256i filtered = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+
+        // holes are filled from the last value when enough of the recent frames were valid
+        __m256i valid = popcount8(_mm256_and_si256(hist, _mm256_set1_epi16((short)p.window)));
+        __m256i persist = _mm256_cmpgt_epi16(valid, _mm256_set1_epi16((short)(p.required - 1)));
+        __m256i fill = _mm256_andnot_si256(currentValid, _mm256_and_si256(previousValid, persist));
+
+        __m256i out = _mm256_blendv_epi8(current, filtered, agree);
+        out = _mm256_blendv_epi8(out, previous, fill);
+
+        __m256i newLast = _mm256_blendv_epi8(previous, current, currentValid);
+        newLast = _mm256_blendv_epi8(newLast, filtered, agree);
+
+        __m256i newHist = _mm256_andnot_si256(frameBit, hist);
+        newHist = _mm256_blendv_epi8(newHist, frameBit, currentValid);
+        newHist = _mm256_blendv_epi8(newHist, _mm256_or_si256(hist, frameBit), agree);
+
+        _mm256_storeu_si256((__m256i *)depth, out);
+        _mm256_storeu_si256((__m256i *)last, newLast);
+        _mm256_storeu_si256((__m256i *)history, newHist);
+    }
+}
+
+// The feedback of iteration i is a^(1 + sigmaSpatial / sigmaRange * |dI|), where a shrinks every iteration
+// so the passes together add up to a filter with the requested spatial sigma.
+// The exponential is tabulated per integer depth difference, which is exact since the input is 16 bit.
+void EdgePreservingFilter::buildFeedbackTables()
+{
+    if (m_tableSigmaSpatial == m_sigmaSpatial && m_tableSigmaRange == m_sigmaRange && m_tableIterations == m_iterations) { return; }
+
+    m_tableSigmaSpatial = m_sigmaSpatial;
+    m_tableSigmaRange = m_sigmaRange;
+    m_tableIterations = m_iterations;
+    m_feedback.clear();
+
+    const double ratio = m_sigmaSpatial / std::max(m_sigmaRange, 0.01f);
+    const double n = m_iterations;
+    for (int i = 0; i < m_iterations; i++)
+    {
+        double sigmaH = m_sigmaSpatial * std::sqrt(3.0) * std::pow(2.0, n - i - 1) / std::sqrt(std::pow(4.0, n) - 1.0);
+        double logA = -std::sqrt(2.0) / sigmaH;
+
+        std::vector<float> table;
+        for (int diff = 0; diff < 65536; diff++)
+        {
+            double weight = std::exp(logA * (1.0 + ratio * diff));
+            if (weight < 1e-4) { break; }
+            table.push_back((float)weight);
+        }
+
+        // every difference past the end of the table maps onto this, which cuts the link
+        table.push_back(0.0f);
+        m_feedback.push_back(table);
+    }
+}
+
+void EdgePreservingFilter::apply(cv::Mat & depth)
+{
+    if (!m_enabled || depth.empty()) { return; }
+    PROFILE_FUNCTION();
+
+    buildFeedbackTables();
+
+    depth.convertTo(m_work, CV_32F);
+
+    for (auto & table : m_feedback)
+    {
+        recursiveRows(m_work, depth, table);
+        recursiveColumns(m_work, depth, table);
+    }
+
+    m_work.convertTo(depth, CV_16U);
+}
+
+void EdgePreservingFilter::imgui()
+{
+    ImGui::Checkbox("Edge Preserving Filter", &m_enabled);
+    ImGui::SliderFloat("Spatial Sigma", &m_sigmaSpatial, 1.0f, 50.0f);
+    ImGui::SliderFloat("Range Sigma", &m_sigmaRange, 0.5f, 100.0f);
+    ImGui::SliderInt("Iterations", &m_iterations, 1, 4);
+}
+
+void EdgePreservingFilter::save(Save & save) const
+{
+    save.edgeFilter = m_enabled;
+    save.edgeSigmaSpatial = m_sigmaSpatial;
+    save.edgeSigmaRange = m_sigmaRange;
+    save.edgeIterations = m_iterations;
+}
+
+void EdgePreservingFilter::load(const Save & save)
+{
+    m_enabled = save.edgeFilter;
+    m_sigmaSpatial = save.edgeSigmaSpatial;
+    m_sigmaRange = save.edgeSigmaRange;
+    m_iterations = save.edgeIterations;
+}
+
+const char * TemporalDepthFilter::PersistenceNames[PersistenceModes] = { "Disabled", "Valid in 8/8", "Valid in 2/last 3", "Valid in 2/last 4", "Valid in 2/8",
+                                                                          "Valid in 1/last 2", "Valid in 1/last 5", "Valid in 1/last 8", "Persist Indefinitely" };
+
+void TemporalDepthFilter::reset()
+{
+    m_last = cv::Mat();
+    m_history = cv::Mat();
+    m_frame = 0;
+}
+
+void TemporalDepthFilter::apply(cv::Mat & depth, float alpha, int delta, int persistence)
+{
+    if (depth.empty()) { return; }
+    PROFILE_FUNCTION();
+
+    CV_Assert(depth.type() == CV_16U);
+    if (m_last.size() != depth.size())
+    {
+        m_last = cv::Mat::zeros(depth.size(), CV_16U);
+        m_history = cv::Mat::zeros(depth.size(), CV_16U);
+        m_frame = 0;
+    }
+
+    // how many of the last frames are looked at and how many of them need data, per persistence mode
+    // disabled never fills a hole and persist indefinitely always does
+    static const int windows[TemporalDepthFilter::PersistenceModes] = { 8, 8, 3, 4, 8, 2, 5, 8, 8 };
+    static const int required[TemporalDepthFilter::PersistenceModes] = { 9, 8, 2, 2, 2, 1, 1, 1, 0 };
+    persistence = std::clamp(persistence, 0, PersistenceModes - 1);
+
+    TemporalParameters parameters;
+    parameters.alpha = std::clamp(alpha, 0.0f, 1.0f);
+    parameters.delta = (uint16_t)std::clamp(delta, 0, 65535);
+    parameters.frameBit = (uint16_t)(1 << m_frame);
+    parameters.window = historyWindow(m_frame, windows[persistence]);
+    parameters.required = required[persistence];
+
+    cv::parallel_for_(cv::Range(0, depth.rows), [&](const cv::Range & range)
+    {
+        for (int y = range.start; y < range.end; y++)
+        {
+            uint16_t * d = depth.ptr<uint16_t>(y);
+            uint16_t * last = m_last.ptr<uint16_t>(y);
+            uint16_t * history = m_history.ptr<uint16_t>(y);
+
+            int x = 0;
+            for (; x + 16 <= depth.cols; x += 16)
+            {
+                temporalPixels16(d + x, last + x, history + x, parameters);
+            }
+            for (; x < depth.cols; x++)
+            {
+                temporalPixel(d[x], last[x], history[x], parameters);
+            }
+        }
+    });
+
+    m_frame = (m_frame + 1) % 8;
+}
+
+void RunningSumBlur::apply(const cv::Mat & input, cv::Mat & output)
+{
+    PROFILE_FUNCTION();
+
+    CV_Assert(input.type() == CV_32F);
+    const int rows = input.rows;
+    const int cols = input.cols;
+    const auto widths = boxWidths(m_sigma);
+
+    // all three horizontal boxes on a row while it is in cache, input -> temp
+    m_temp.create(input.size(), CV_32F);
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range & range)
+    {
+        std::vector<float> a(cols), b(cols);
+        for (int y = range.start; y < range.end; y++)
+        {
+            boxRow(input.ptr<float>(y), a.data(), cols, widths[0] / 2);
+            boxRow(a.data(), b.data(), cols, widths[1] / 2);
+            boxRow(b.data(), m_temp.ptr<float>(y), cols, widths[2] / 2);
+        }
+    });
+
+    // the vertical boxes ping pong temp -> output -> temp -> output, each strip only touches its own columns
+    output.create(input.size(), CV_32F);
+    cv::parallel_for_(cv::Range(0, (cols + StripWidth - 1) / StripWidth), [&](const cv::Range & range)
+    {
+        const int x0 = range.start * StripWidth;
+        const int x1 = std::min(cols, range.end * StripWidth);
+        std::vector<float> sum;
+        boxColumns(m_temp, output, x0, x1, widths[0] / 2, sum);
+        boxColumns(output, m_temp, x0, x1, widths[1] / 2, sum);
+        boxColumns(m_temp, output, x0, x1, widths[2] / 2, sum);
+    });
+}
+
+void RunningSumBlur::compare(const cv::Mat & input)
+{
+    if (input.empty() || input.type() != CV_32F) { return; }
+
+    const int runs = 10;
+    cv::Mat own, reference;
+
+    Timer timer;
+    for (int i = 0; i < runs; i++) { apply(input, own); }
+    m_ownMS = timer.elapsed() / 1000.0f / runs;
+
+    timer.start();
+    for (int i = 0; i < runs; i++) { cv::GaussianBlur(input, reference, cv::Size(0, 0), m_sigma, m_sigma, cv::BORDER_REFLECT_101); }
+    m_opencvMS = timer.elapsed() / 1000.0f / runs;
+
+    cv::Mat difference;
+    cv::absdiff(own, reference, difference);
+    cv::minMaxLoc(difference, nullptr, &m_maxError);
+    m_meanError = cv::mean(difference)[0];
+    m_compared = true;
+}
+
+void RunningSumBlur::imgui(const cv::Mat & comparisonInput)
+{
+    ImGui::SliderFloat("Blur Sigma", &m_sigma, 0.5f, 30.0f);
+
+    if (ImGui::Button("Compare With OpenCV"))
+    {
+        compare(comparisonInput);
+    }
+    if (m_compared)
+    {
+        ImGui::Text("Running Sum: %.3f ms", m_ownMS);
+        ImGui::Text("cv::GaussianBlur: %.3f ms", m_opencvMS);
+        ImGui::Text("Max Error: %.6f, Mean Error: %.6f", m_maxError, m_meanError);
+    }
+}
+
+void RunningSumBlur::save(Save & save) const
+{
+    save.blurSigma = m_sigma;
+}
+
+void RunningSumBlur::load(const Save & save)
+{
+    m_sigma = save.blurSigma;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Save.hpp"
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Edge preserving smoothing of 16 bit depth with the recursive domain transform filter (Gastal and Oliveira 2011)
+// Every pass is a first order recursive filter whose feedback drops to zero across depth edges,
+// so the cost per pixel is the same for any spatial sigma and the ridges people sculpt stay sharp.
+// Zero depth (no data) is never smoothed into its neighbours and stays zero.
+class EdgePreservingFilter
+{
+    bool                m_enabled = false;
+    float               m_sigmaSpatial = 8.0f;      // pixels
+    float               m_sigmaRange = 6.0f;        // raw depth units
+    int                 m_iterations = 2;           // a row and a column pass each, two keep edges sharp
+
+    cv::Mat             m_work;                     // the depth as floats while it is being filtered
+
+    // feedback weight by absolute depth difference, one table per iteration
+    std::vector<std::vector<float>> m_feedback;
+    float               m_tableSigmaSpatial = -1.0f;
+    float               m_tableSigmaRange = -1.0f;
+    int                 m_tableIterations = -1;
+
+    void buildFeedbackTables();
+
+public:
+
+    // filters the CV_16U depth in place
+    void apply(cv::Mat & depth);
+
+    inline bool enabled() const { return m_enabled; }
+
+    void imgui();
+    void save(Save & save) const;
+    void load(const Save & save);
+};
+
+// Temporal smoothing of 16 bit depth with the same rules as librealsense's temporal_filter
+// Each pixel keeps its last value and a bitmask of which of the last 8 frames had data for it.
+// New values that agree with the last one within delta are blended in with alpha, others replace it,
+// and holes are filled from the last value when the history passes the persistence mode.
+// The state lives in our own buffers and the depth is filtered in place, 16 pixels per AVX2 step,
+// so it runs on any CV_16U depth without going through a realsense processing block.
+class TemporalDepthFilter
+{
+    cv::Mat             m_last;                     // last value of every pixel, CV_16U
+    cv::Mat             m_history;                  // which of the last 8 frames were valid, CV_16U using the low byte
+    int                 m_frame = 0;                // bit of the current frame in the history
+
+public:
+
+    // the persistence modes in the order of RS2_OPTION_HOLES_FILL on the temporal filter
+    static constexpr int PersistenceModes = 9;
+    static const char * PersistenceNames[PersistenceModes];
+
+    // filters the CV_16U depth in place
+    void apply(cv::Mat & depth, float alpha, int delta, int persistence);
+
+    // forgets every pixel's history, the next frame passes through unchanged
+    void reset();
+};
+
+// Gaussian blur approximated by three stacked box blurs made of running sums (Kovesi 2010)
+// The cost per pixel is the same for any sigma. Horizontal passes run over strips of rows,
+// vertical passes over strips of columns where the running sums of 8 columns are updated at once.
+// Borders are reflected the same way cv::GaussianBlur does by default.
+class RunningSumBlur
+{
+    float               m_sigma = 9.5f;
+    cv::Mat             m_temp;
+
+    // results of the last comparison against cv::GaussianBlur
+    bool                m_compared = false;
+    float               m_ownMS = 0.0f;
+    float               m_opencvMS = 0.0f;
+    double              m_maxError = 0.0;
+    double              m_meanError = 0.0;
+
+public:
+
+    // blurs a CV_32F image, input and output may be the same matrix
+    void apply(const cv::Mat & input, cv::Mat & output);
+
+    // times apply() against cv::GaussianBlur with the same sigma and measures how far apart they are
+    void compare(const cv::Mat & input);
+
+    inline float sigma() const { return m_sigma; }
+
+    void imgui(const cv::Mat & comparisonInput);
+    void save(Save & save) const;
+    void load(const Save & save);
+};
@@ -0,0 +1,168 @@
+#include "DirtyTiles.h"
+#include "Profiler.hpp"
+
+#include "imgui.h"
+#include "imgui-SFML.h"
+
+TileMask::TileMask(cv::Size imageSize, int tileSize, bool dirty)
+    : m_imageSize(imageSize)
+    , m_tileSize(tileSize)
+    , m_tilesX((imageSize.width + tileSize - 1) / tileSize)
+    , m_tilesY((imageSize.height + tileSize - 1) / tileSize)
+{
+    m_dirty = std::vector<uint8_t>(m_tilesX * m_tilesY, dirty ? 1 : 0);
+    m_dirtyCount = dirty ? m_dirty.size() : 0;
+}
+
+void TileMask::setDirty(int tx, int ty, bool dirty)
+{
+    uint8_t & tile = m_dirty[ty * m_tilesX + tx];
+    if (tile == (dirty ? 1 : 0)) { return; }
+    tile = dirty ? 1 : 0;
+    if (dirty) { m_dirtyCount++; }
+    else       { m_dirtyCount--; }
+}
+
+cv::Rect TileMask::tileRect(int tx, int ty) const
+{
+    cv::Rect tile(tx * m_tileSize, ty * m_tileSize, m_tileSize, m_tileSize);
+    return tile & cv::Rect(cv::Point(0, 0), m_imageSize);
+}
+
+std::vector<cv::Rect> TileMask::dirtyRects() const
+{
+    std::vector<cv::Rect> rects;
+    for (int ty = 0; ty < m_tilesY; ty++)
+    {
+        int tx = 0;
+        while (tx < m_tilesX)
+        {
+            if (!isDirty(tx, ty)) { tx++; continue; }
+
+            int start = tx;
+            while (tx < m_tilesX && isDirty(tx, ty)) { tx++; }
+            rects.push_back(tileRect(start, ty) | tileRect(tx - 1, ty));
+        }
+    }
+    return rects;
+}
+
+void DirtyTileTracker::reset()
+{
+    m_reference = cv::Mat();
+}
+
+cv::Mat DirtyTileTracker::update(const cv::Mat & topography, size_t calibrationVersion, TileMask & mask)
+{
+    PROFILE_FUNCTION();
+
+    if (topography.rows <= 0 || topography.cols <= 0)
+    {
+        mask = TileMask();
+        return topography;
+    }
+
+    // anything that invalidates the comparison makes the whole frame dirty and starts over from it
+    bool restart = !m_enabled
+        || m_reference.size() != topography.size()
+        || m_reference.type() != topography.type()
+        || m_calibrationVersion != calibrationVersion;
+
+    if (restart)
+    {
+        mask = TileMask(topography.size(), TileSize, true);
+        m_reference = topography;
+        m_calibrationVersion = calibrationVersion;
+        m_dirty = std::vector<uint8_t>(mask.tileCount(), 1);
+        m_hold = std::vector<uint8_t>(mask.tileCount(), 0);
+        m_delta = std::vector<float>(mask.tileCount(), 0.0f);
+        m_dirtyPercent = 100.0f;
+        return topography;
+    }
+
+    mask = TileMask(topography.size(), TileSize, false);
+    const int tilesX = mask.tilesX();
+
+    // the max abs delta of each tile, one tile row per task
+    {
+        PROFILE_SCOPE("Tile Deltas");
+        cv::parallel_for_(cv::Range(0, mask.tilesY()), [&](const cv::Range & range)
+        {
+            for (int ty = range.start; ty < range.end; ty++)
+            {
+                for (int tx = 0; tx < tilesX; tx++)
+                {
+                    cv::Rect tile = mask.tileRect(tx, ty);
+                    m_delta[ty * tilesX + tx] = (float)cv::norm(topography(tile), m_reference(tile), cv::NORM_INF);
+                }
+            }
+        });
+    }
+
+    // hysteresis: dirty tiles need less change to stay dirty than clean tiles need to become dirty
+    for (int ty = 0; ty < mask.tilesY(); ty++)
+    {
+        for (int tx = 0; tx < tilesX; tx++)
+        {
+            size_t i = ty * tilesX + tx;
+            float threshold = m_dirty[i] ? m_exitThreshold : m_enterThreshold;
+            if (m_delta[i] > threshold)
+            {
+                m_hold[i] = (uint8_t)m_holdFrames;
+                mask.setDirty(tx, ty, true);
+            }
+            else if (m_dirty[i] && m_hold[i] > 0)
+            {
+                m_hold[i]--;
+                mask.setDirty(tx, ty, true);
+            }
+            m_dirty[i] = mask.isDirty(tx, ty) ? 1 : 0;
+        }
+    }
+
+    m_dirtyPercent = 100.0f * mask.dirtyCount() / mask.tileCount();
+    if (!mask.any()) { return m_reference; }
+
+    // the previous reference may still be held by earlier frames, so the new one is a copy with the dirty tiles replaced
+    {
+        PROFILE_SCOPE("Copy Dirty Tiles");
+        cv::Mat emitted = m_reference.clone();
+        for (auto & rect : mask.dirtyRects())
+        {
+            topography(rect).copyTo(emitted(rect));
+        }
+        m_reference = emitted;
+    }
+    return m_reference;
+}
+
+void DirtyTileTracker::imgui()
+{
+    PROFILE_FUNCTION();
+
+    if (ImGui::Checkbox("Track Dirty Tiles", &m_enabled)) { reset(); }
+    if (!m_enabled) { return; }
+
+    ImGui::SliderFloat("Dirty Enter Threshold", &m_enterThreshold, 0.0f, 0.1f, "%.4f");
+    ImGui::SliderFloat("Dirty Exit Threshold", &m_exitThreshold, 0.0f, 0.1f, "%.4f");
+    ImGui::SliderInt("Dirty Hold Frames", &m_holdFrames, 0, 30);
+    m_exitThreshold = std::min(m_exitThreshold, m_enterThreshold);
+    ImGui::Text("Dirty Tiles: %.1f%%", m_dirtyPercent);
+}
+
+void DirtyTileTracker::save(Save & save) const
+{
+    save.trackDirtyTiles = m_enabled;
+    save.dirtyEnterThreshold = m_enterThreshold;
+    save.dirtyExitThreshold = m_exitThreshold;
+    save.dirtyHoldFrames = m_holdFrames;
+}
+
+void DirtyTileTracker::load(const Save & save)
+{
+    m_enabled = save.trackDirtyTiles;
+    m_enterThreshold = save.dirtyEnterThreshold;
+    m_exitThreshold = save.dirtyExitThreshold;
+    m_holdFrames = save.dirtyHoldFrames;
+    reset();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Save.hpp"
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Which tiles of a topography changed since the previous emitted frame
+// A mask that does not cover an image is treated as fully dirty by whoever receives it
+class TileMask
+{
+    cv::Size                m_imageSize;
+    int                     m_tileSize = 32;
+    int                     m_tilesX = 0;
+    int                     m_tilesY = 0;
+    std::vector<uint8_t>    m_dirty;
+    size_t                  m_dirtyCount = 0;
+
+public:
+
+    TileMask() = default;
+    TileMask(cv::Size imageSize, int tileSize, bool dirty);
+
+    inline cv::Size imageSize() const { return m_imageSize; }
+    inline int tileSize() const { return m_tileSize; }
+    inline int tilesX() const { return m_tilesX; }
+    inline int tilesY() const { return m_tilesY; }
+    inline size_t tileCount() const { return m_dirty.size(); }
+    inline size_t dirtyCount() const { return m_dirtyCount; }
+    inline bool any() const { return m_dirtyCount > 0; }
+    inline bool all() const { return m_dirtyCount == m_dirty.size(); }
+    inline bool covers(cv::Size size) const { return !m_dirty.empty() && m_imageSize == size; }
+
+    inline bool isDirty(int tx, int ty) const
+    {
+        return m_dirty[ty * m_tilesX + tx] != 0;
+    }
+
+    void setDirty(int tx, int ty, bool dirty);
+
+    // pixel rectangle of a tile, the last row and column of tiles are clipped to the image
+    cv::Rect tileRect(int tx, int ty) const;
+
+    // dirty tiles merged into one rectangle per horizontal run, in image coordinates
+    std::vector<cv::Rect> dirtyRects() const;
+};
+
+// Compares every topography against the last emitted one, tile by tile
+// A clean tile becomes dirty when any of its values moved more than the enter threshold, and only becomes
+// clean again after its change stayed below the (lower) exit threshold for a number of frames.
+// The emitted topography keeps the old values in clean tiles, so sensor noise below the threshold never
+// reaches the processors and stages that only update dirty tiles stay exactly in sync with the frame.
+class DirtyTileTracker
+{
+    cv::Mat                 m_reference;            // the last emitted topography
+    std::vector<uint8_t>    m_dirty;                // dirty state of every tile in the last emitted frame
+    std::vector<uint8_t>    m_hold;                 // frames a tile stays dirty after its last real change
+    std::vector<float>      m_delta;                // max abs delta of every tile this frame
+    size_t                  m_calibrationVersion = 0;
+
+    bool                    m_enabled = true;
+    float                   m_enterThreshold = 0.01f;
+    float                   m_exitThreshold = 0.004f;
+    int                     m_holdFrames = 3;
+    float                   m_dirtyPercent = 100.0f;
+
+public:
+
+    static constexpr int TileSize = 32;
+
+    // returns the topography to emit and the tiles that differ from the previous one
+    cv::Mat update(const cv::Mat & topography, size_t calibrationVersion, TileMask & mask);
+
+    // forget the previous frame, the next update reports everything dirty
+    void reset();
+
+    void imgui();
+    void save(Save & save) const;
+    void load(const Save & save);
+};
@@ -0,0 +1,251 @@
+#include "FlowField.h"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+    // index of the action that undoes action i in Actions8
+    uint8_t opposite(size_t i)
+    {
+        static const std::array<uint8_t, 8> table = []()
+        {
+            std::array<uint8_t, 8> t = { 0 };
+            auto & actions = Actions8();
+            for (size_t a = 0; a < actions.size(); a++)
+            {
+                for (size_t b = 0; b < actions.size(); b++)
+                {
+                    if (actions[a].dir.x == -actions[b].dir.x && actions[a].dir.y == -actions[b].dir.y) { t[a] = (uint8_t)b; }
+                }
+            }
+            return t;
+        }();
+        return table[i];
+    }
+}
+
+FlowField::FlowField(int tileSize)
+    : m_tileSize(std::max(tileSize, 1))
+{
+
+}
+
+void FlowField::setGoals(const std::vector<State> & goals)
+{
+    m_goals = goals;
+    m_valid = false;
+}
+
+size_t FlowField::update(const Grid<float> & heights, const TraversalCosts & costs)
+{
+    PROFILE_FUNCTION();
+
+    m_settled = 0;
+    const bool full = !m_valid
+        || heights.width() != m_heights.width() || heights.height() != m_heights.height()
+        || costs.slopePenalty != m_costs.slopePenalty || costs.maxStep != m_costs.maxStep || costs.minHeight != m_costs.minHeight;
+
+    // no step costs more than the steepest diagonal that can still be climbed
+    const size_t bucketCount = 141 + (size_t)(costs.slopePenalty * costs.maxStep + 0.5f) + 1;
+    if (m_buckets.size() != bucketCount) { m_buckets = std::vector<std::vector<int32_t>>(bucketCount); }
+
+    if (full)
+    {
+        m_heights = heights;
+        m_costs = costs;
+        computeAll();
+        m_valid = true;
+        return heights.width() * heights.height();
+    }
+
+    // tiles whose heights changed are taken over
+    const int width = (int)heights.width();
+    const int height = (int)heights.height();
+    const int tilesX = (width + m_tileSize - 1) / m_tileSize;
+    const int tilesY = (height + m_tileSize - 1) / m_tileSize;
+    std::vector<uint8_t> dirty(tilesX * tilesY, 0);
+    bool any = false;
+    for (int ty = 0; ty < tilesY; ty++)
+    {
+        for (int tx = 0; tx < tilesX; tx++)
+        {
+            const int x0 = tx * m_tileSize;
+            const int columns = std::min(m_tileSize, width - x0);
+            for (int y = ty * m_tileSize; y < std::min((ty + 1) * m_tileSize, height); y++)
+            {
+                if (std::memcmp(&m_heights.get(x0, y), &heights.get(x0, y), columns * sizeof(float)) == 0) { continue; }
+
+                std::memcpy(&m_heights.get(x0, y), &heights.get(x0, y), columns * sizeof(float));
+                dirty[ty * tilesX + tx] = 1;
+                any = true;
+            }
+        }
+    }
+
+    if (!any) { return 0; }
+    repair(dirty, tilesX);
+    return m_reset.size();
+}
+
+void FlowField::computeAll()
+{
+    PROFILE_FUNCTION();
+
+    m_distance.refill(m_heights.width(), m_heights.height(), INT32_MAX);
+    m_flow.refill(m_heights.width(), m_heights.height(), NoFlow);
+    m_isReset.refill(m_heights.width(), m_heights.height(), 0);
+
+    m_seeds.clear();
+    for (State goal : m_goals)
+    {
+        if (!AStar::passable(m_heights, goal, m_costs)) { continue; }
+        m_distance.set(goal, 0);
+        m_seeds.push_back({ 0, (int32_t)(goal.y * m_heights.width() + goal.x) });
+    }
+    propagate();
+}
+
+void FlowField::repair(const std::vector<uint8_t> & dirtyTiles, int tilesX)
+{
+    PROFILE_FUNCTION();
+
+    const int width = (int)m_heights.width();
+    const int height = (int)m_heights.height();
+    auto & actions = Actions8();
+
+    m_reset.clear();
+    auto reset = [&](int x, int y)
+    {
+        int32_t cell = y * width + x;
+        if (m_isReset.get(cell)) { return; }
+        m_isReset.set(cell, 1);
+        m_distance.set(cell, INT32_MAX);
+        m_flow.set(cell, NoFlow);
+        m_reset.push_back(cell);
+    };
+
+    // a changed cell also changes whether diagonals next to it cut a corner, so one more ring of cells is reset
+    for (size_t t = 0; t < dirtyTiles.size(); t++)
+    {
+        if (!dirtyTiles[t]) { continue; }
+
+        const int x0 = (int)(t % tilesX) * m_tileSize;
+        const int y0 = (int)(t / tilesX) * m_tileSize;
+        for (int y = std::max(y0 - 1, 0); y < std::min(y0 + m_tileSize + 1, height); y++)
+        {
+            for (int x = std::max(x0 - 1, 0); x < std::min(x0 + m_tileSize + 1, width); x++)
+            {
+                reset(x, y);
+            }
+        }
+    }
+
+    // every cell whose flow leads into a reset cell has to find its way again
+    for (size_t i = 0; i < m_reset.size(); i++)
+    {
+        State s(m_reset[i] % width, m_reset[i] / width);
+        for (size_t a = 0; a < actions.size(); a++)
+        {
+            State n = s + actions[a].dir;
+            if (n.x < 0 || n.y < 0 || n.x >= width || n.y >= height) { continue; }
+            if (m_flow.get(n) == opposite(a)) { reset(n.x, n.y); }
+        }
+    }
+
+    // restart from the goals that were reset and from every cell next to the reset ones that kept its distance
+    m_seeds.clear();
+    for (State goal : m_goals)
+    {
+        if (!AStar::passable(m_heights, goal, m_costs) || !m_isReset.get(goal)) { continue; }
+        m_distance.set(goal, 0);
+        m_seeds.push_back({ 0, (int32_t)(goal.y * width + goal.x) });
+    }
+
+    for (int32_t cell : m_reset)
+    {
+        State s(cell % width, cell / width);
+        for (auto & action : actions)
+        {
+            State n = s + action.dir;
+            if (n.x < 0 || n.y < 0 || n.x >= width || n.y >= height) { continue; }
+            if (!m_isReset.get(n) && m_distance.get(n) != INT32_MAX) { m_seeds.push_back({ m_distance.get(n), n.y * width + n.x }); }
+        }
+    }
+
+    for (int32_t cell : m_reset) { m_isReset.set(cell, 0); }
+
+    std::sort(m_seeds.begin(), m_seeds.end());
+    m_seeds.erase(std::unique(m_seeds.begin(), m_seeds.end()), m_seeds.end());
+    propagate();
+}
+
+void FlowField::propagate()
+{
+    PROFILE_FUNCTION();
+
+    // the seeds are sorted, each one joins the buckets once the search reaches its distance
+    // every other entry is at most one step more than the distance being settled, so the ring never wraps onto itself
+    const int width = (int)m_heights.width();
+    const size_t bucketCount = m_buckets.size();
+    auto & actions = Actions8();
+
+    size_t nextSeed = 0;
+    size_t pending = 0;
+    int32_t current = 0;
+    while (true)
+    {
+        if (pending == 0)
+        {
+            if (nextSeed == m_seeds.size()) { break; }
+            current = m_seeds[nextSeed].first;
+        }
+
+        auto & bucket = m_buckets[current % bucketCount];
+        for (; nextSeed < m_seeds.size() && m_seeds[nextSeed].first == current; nextSeed++)
+        {
+            bucket.push_back(m_seeds[nextSeed].second);
+            pending++;
+        }
+
+        while (!bucket.empty())
+        {
+            int32_t cell = bucket.back();
+            bucket.pop_back();
+            pending--;
+
+            // cells are put in again when their distance drops, the older entries are skipped
+            if (m_distance.get(cell) != current) { continue; }
+            m_settled++;
+
+            State s(cell % width, cell / width);
+            for (size_t a = 0; a < actions.size(); a++)
+            {
+                int32_t step = AStar::stepCost(m_heights, s, actions[a], m_costs);
+                if (step < 0) { continue; }
+
+                State n = s + actions[a].dir;
+                int32_t d = current + step;
+                if (d >= m_distance.get(n)) { continue; }
+
+                m_distance.set(n, d);
+                m_flow.set(n, opposite(a));
+                m_buckets[d % bucketCount].push_back(n.y * width + n.x);
+                pending++;
+            }
+        }
+
+        current++;
+    }
+}
+
+size_t FlowField::memoryUsage() const
+{
+    size_t cells = m_heights.width() * m_heights.height();
+    size_t bytes = cells * (sizeof(float) + sizeof(int32_t) + 2 * sizeof(uint8_t));
+    for (auto & bucket : m_buckets) { bytes += sizeof(bucket) + bucket.capacity() * sizeof(int32_t); }
+    bytes += m_seeds.capacity() * sizeof(std::pair<int32_t, int32_t>) + m_reset.capacity() * sizeof(int32_t);
+    return bytes;
+}
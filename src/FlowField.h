@@ -0,0 +1,68 @@
+#pragma once
+
+#include "AStar.h"
+
+#include <vector>
+
+// Distance to the nearest of a set of goals for every cell, and the step each cell takes towards it
+// When many agents head for the same place one field replaces a search per agent, an agent
+// steers by looking up the direction of the cell it stands on.
+// The distances come from Dijkstra with the same step costs as AStar, outwards from the goals.
+// Step costs are small integers, so the open list is a ring of buckets, one per cost, and a cell is
+// taken out in constant time (Dial 1969).
+// update() compares new heights tile by tile with the ones the field was computed from. Cells in changed
+// tiles and every cell whose flow leads through them are reset, and the search is restarted from the
+// cells around them that kept their distance.
+class FlowField
+{
+    static constexpr uint8_t NoFlow = 255;
+
+    int                 m_tileSize = 16;
+    Grid<float>         m_heights;          // what the field was computed from
+    TraversalCosts      m_costs;
+    std::vector<State>  m_goals;
+    bool                m_valid = false;    // false until computed and after the goals changed
+
+    Grid<int32_t>       m_distance;         // INT32_MAX where no goal can be reached
+    Grid<uint8_t>       m_flow;             // index into Actions8 of the step towards the goal, NoFlow at goals and unreachable cells
+
+    // scratch
+    std::vector<std::vector<int32_t>> m_buckets;
+    std::vector<std::pair<int32_t, int32_t>> m_seeds;  // distance, cell the search restarts from
+    std::vector<int32_t> m_reset;
+    Grid<uint8_t>       m_isReset;
+    size_t              m_settled = 0;
+
+    void computeAll();
+    void repair(const std::vector<uint8_t> & dirtyTiles, int tilesX);
+    void propagate();
+
+public:
+
+    FlowField(int tileSize = 16);
+
+    // the goals take effect at the next update(), which recomputes everything
+    void setGoals(const std::vector<State> & goals);
+
+    // brings the field up to date with the heights, returns how many cells were reset and searched again
+    size_t update(const Grid<float> & heights, const TraversalCosts & costs);
+
+    // cost to the nearest goal, -1 when none can be reached
+    inline int32_t distance(State s) const
+    {
+        int32_t d = m_distance.get(s);
+        return d == INT32_MAX ? -1 : d;
+    }
+
+    // the step to take from s, (0, 0) at a goal or where no goal can be reached
+    inline State direction(State s) const
+    {
+        uint8_t flow = m_flow.get(s);
+        return flow == NoFlow ? State(0, 0) : Actions8()[flow].dir;
+    }
+
+    // cells taken out of the open list by the last update
+    inline size_t settled() const { return m_settled; }
+
+    size_t memoryUsage() const;
+};
@@ -0,0 +1,311 @@
+#include "FractalNoise.h"
+#include "Profiler.hpp"
+
+#include <immintrin.h> // For AVX intrinsics
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    constexpr int StripRows = 32;
+
+    // lowbias32 from Chris Wellons' hash prospector, every bit of the input moves about half the output bits
+    inline uint32_t hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
+    }
+
+    inline __m256i hash(__m256i x)
+    {
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+        x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x846ca68bU));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        return x;
+    }
+
+    // 6t^5 - 15t^4 + 10t^3, flat at both ends so the gradient octaves have no creases at the lattice lines
+    inline float fade(float t)
+    {
+        return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+    }
+
+    inline __m256 fade(__m256 t)
+    {
+        __m256 f = _mm256_fmadd_ps(t, _mm256_set1_ps(6.0f), _mm256_set1_ps(-15.0f));
+        f = _mm256_fmadd_ps(t, f, _mm256_set1_ps(10.0f));
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), f);
+    }
+
+    inline int roundUp8(int value)
+    {
+        return (value + 7) & ~7;
+    }
+
+    // the lattice columns of an octave, shared by every strip
+    struct OctaveColumns
+    {
+        int                     period = 1;
+        int                     shift = 0;
+        int                     count = 0;      // lattice columns covering the width and one past it
+        int                     phase = 0;      // pixels of the first lattice cell left of pixel 0
+        float                   amplitude = 1.0f;
+        uint32_t                key = 0;        // mixed into the hash of every lattice row of this octave
+        std::vector<uint32_t>   x;              // what each lattice column hashes as, padded for whole vectors
+    };
+
+    // one octave while a strip is computed
+    struct OctaveRows
+    {
+        bool                    cached = false;
+        int64_t                 row = 0;        // the lattice row held in above
+        std::vector<uint32_t>   above;          // hashes of the lattice row at or above the pixel row
+        std::vector<uint32_t>   below;
+        std::vector<float>      a;              // per lattice column: the noise at fx is fx * a + b for the left column
+        std::vector<float>      b;              // and (fx - 1) * a + b for the right one
+    };
+
+    void hashLatticeRow(uint32_t * out, const OctaveColumns & octave, uint32_t row)
+    {
+        const __m256i rowKey = _mm256_set1_epi32((int)hash(row + octave.key));
+        for (size_t k = 0; k < octave.x.size(); k += 8)
+        {
+            const __m256i x = _mm256_loadu_si256((const __m256i *)(octave.x.data() + k));
+            _mm256_storeu_si256((__m256i *)(out + k), hash(_mm256_add_epi32(x, rowKey)));
+        }
+    }
+
+    // blends the lattice rows above and below into a and b for a pixel row fy of the way down
+    void blendLatticeRows(OctaveRows & rows, float fy, NoiseType type)
+    {
+        const __m256 vfy = _mm256_set1_ps(fy);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 valueScale = _mm256_set1_ps(1.0f / 16777216.0f);
+        const __m256 gradientX = _mm256_setr_ps(1.0f, 0.70710678f, 0.0f, -0.70710678f, -1.0f, -0.70710678f, 0.0f, 0.70710678f);
+        const __m256 gradientY = _mm256_setr_ps(0.0f, 0.70710678f, 1.0f, 0.70710678f, 0.0f, -0.70710678f, -1.0f, -0.70710678f);
+        const __m256 t = _mm256_set1_ps(fade(fy));
+        const __m256 fyBelow = _mm256_set1_ps(fy - 1.0f);
+
+        for (size_t k = 0; k < rows.above.size(); k += 8)
+        {
+            const __m256i h0 = _mm256_loadu_si256((const __m256i *)(rows.above.data() + k));
+            const __m256i h1 = _mm256_loadu_si256((const __m256i *)(rows.below.data() + k));
+            if (type == NoiseType::Value)
+            {
+                // the top 24 bits as a value in [0, 1), blended linearly like the grids of Perlin2DNew
+                const __m256 v0 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h0, 8)), valueScale);
+                const __m256 v1 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h1, 8)), valueScale);
+                _mm256_storeu_ps(rows.a.data() + k, zero);
+                _mm256_storeu_ps(rows.b.data() + k, _mm256_fmadd_ps(vfy, _mm256_sub_ps(v1, v0), v0));
+            }
+            else
+            {
+                // the top 3 bits pick one of eight directions, the dot product with the offset is split in x and y
+                const __m256i d0 = _mm256_srli_epi32(h0, 29), d1 = _mm256_srli_epi32(h1, 29);
+                const __m256 gx0 = _mm256_permutevar8x32_ps(gradientX, d0), gy0 = _mm256_permutevar8x32_ps(gradientY, d0);
+                const __m256 gx1 = _mm256_permutevar8x32_ps(gradientX, d1), gy1 = _mm256_permutevar8x32_ps(gradientY, d1);
+                const __m256 y0 = _mm256_mul_ps(gy0, vfy), y1 = _mm256_mul_ps(gy1, fyBelow);
+                _mm256_storeu_ps(rows.a.data() + k, _mm256_fmadd_ps(t, _mm256_sub_ps(gx1, gx0), gx0));
+                _mm256_storeu_ps(rows.b.data() + k, _mm256_fmadd_ps(t, _mm256_sub_ps(y1, y0), y0));
+            }
+        }
+    }
+
+    // noise between a lattice column (a0, b0) and the next (a1, b1) at fx of the way across
+    inline __m256 latticeNoise(__m256 fx, __m256 a0, __m256 b0, __m256 a1, __m256 b1, NoiseType type)
+    {
+        const __m256 u = type == NoiseType::Gradient ? fade(fx) : fx;
+        const __m256 left = _mm256_fmadd_ps(fx, a0, b0);
+        const __m256 right = _mm256_fmadd_ps(_mm256_sub_ps(fx, _mm256_set1_ps(1.0f)), a1, b1);
+        return _mm256_fmadd_ps(u, _mm256_sub_ps(right, left), left);
+    }
+
+    // adds one octave of a pixel row to sum, which is padded to whole vectors
+    void addOctave(float * sum, int width, const OctaveColumns & octave, const OctaveRows & rows, NoiseType type)
+    {
+        const __m256 amplitude = _mm256_set1_ps(octave.amplitude);
+        const __m256 invPeriod = _mm256_set1_ps(1.0f / octave.period);
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const float * a = rows.a.data();
+        const float * b = rows.b.data();
+
+        if (octave.period >= 8)
+        {
+            // every vector lies between the same two lattice columns
+            for (int k = 0; k + 1 < octave.count; k++)
+            {
+                const __m256 a0 = _mm256_set1_ps(a[k]), b0 = _mm256_set1_ps(b[k]);
+                const __m256 a1 = _mm256_set1_ps(a[k + 1]), b1 = _mm256_set1_ps(b[k + 1]);
+                const int x0 = k * octave.period - octave.phase, x1 = std::min(x0 + octave.period, width);
+                for (int x = std::max(x0, 0); x < x1; x += 8)
+                {
+                    const __m256 fx = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x - x0), lanes)), invPeriod);
+                    const __m256 noise = latticeNoise(fx, a0, b0, a1, b1, type);
+                    _mm256_storeu_ps(sum + x, _mm256_fmadd_ps(amplitude, noise, _mm256_loadu_ps(sum + x)));
+                }
+            }
+            return;
+        }
+
+        if (octave.period == 1)
+        {
+            // every pixel sits on a lattice column, fx is 0 so the noise is b
+            for (int x = 0; x < width; x += 8)
+            {
+                _mm256_storeu_ps(sum + x, _mm256_fmadd_ps(amplitude, _mm256_loadu_ps(b + x), _mm256_loadu_ps(sum + x)));
+            }
+            return;
+        }
+
+        // a vector spans a few lattice columns, they are loaded together and spread over the lanes,
+        // the offset of a lane into its lattice cell is the same for every vector
+        const __m256i left = _mm256_srli_epi32(lanes, octave.shift);
+        const __m256i right = _mm256_add_epi32(left, _mm256_set1_epi32(1));
+        const __m256 fx = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(lanes, _mm256_set1_epi32(octave.period - 1))), invPeriod);
+        for (int x = 0; x < width; x += 8)
+        {
+            const int k = x >> octave.shift;
+            const __m256 va = _mm256_loadu_ps(a + k), vb = _mm256_loadu_ps(b + k);
+            const __m256 a0 = _mm256_permutevar8x32_ps(va, left), b0 = _mm256_permutevar8x32_ps(vb, left);
+            const __m256 a1 = _mm256_permutevar8x32_ps(va, right), b1 = _mm256_permutevar8x32_ps(vb, right);
+            const __m256 noise = latticeNoise(fx, a0, b0, a1, b1, type);
+            _mm256_storeu_ps(sum + x, _mm256_fmadd_ps(amplitude, noise, _mm256_loadu_ps(sum + x)));
+        }
+    }
+}
+
+namespace
+{
+    // where the pixels of an output lie on the lattices
+    struct NoiseWindow
+    {
+        bool    wrap = true;            // lattice points wrap around at the size of the output, otherwise they go on forever
+        int64_t x = 0, y = 0;           // first pixel, in pixels of the level of detail
+        int     lod = 0;                // pixels are 2^lod pixels of the finest octave apart
+    };
+
+    void generate(cv::Mat & output, const NoiseWindow & window, int seed, int octaves, float persistance, NoiseType type)
+    {
+        const int width = output.cols, height = output.rows;
+        octaves = std::max(octaves, 1);
+
+        // the same weights as Perlin2DNew, the coarsest octave weighs persistance and every finer one persistance times less
+        // octaves finer than a pixel are left out, they would only alias, and count with their average instead
+        std::vector<OctaveColumns> columns;
+        float amplitude = 1.0f, totalAmplitude = 0.0f, average = 0.0f;
+        for (int o = octaves - 1; o >= 0; o--)
+        {
+            amplitude *= persistance;
+            totalAmplitude += amplitude;
+            if (o < window.lod)
+            {
+                average += type == NoiseType::Value ? amplitude * 0.5f : 0.0f;
+                continue;
+            }
+
+            OctaveColumns octave;
+            octave.amplitude = amplitude;
+            octave.shift = std::min(o - window.lod, 30);
+            octave.period = 1 << octave.shift;
+            octave.key = hash((uint32_t)seed * 0x9E3779B9U + (uint32_t)o);
+
+            const int64_t firstColumn = window.x >> octave.shift;
+            octave.phase = (int)(window.x - (firstColumn << octave.shift));
+            octave.count = (width + octave.phase + octave.period - 1) / octave.period + 1;
+
+            // a row of a short octave loads a whole vector from its last lattice column, the extra vector keeps it in range
+            octave.x.assign(roundUp8(octave.count) + 8, 0);
+            for (int k = 0; k < octave.count; k++)
+            {
+                octave.x[k] = window.wrap ? (uint32_t)(((int64_t)k * octave.period) % width) : (uint32_t)(firstColumn + k);
+            }
+            columns.push_back(std::move(octave));
+        }
+
+        // value noise sums to [0, 1], gradient noise of unit directions stays within +-sqrt(0.5)
+        const float scale = totalAmplitude > 0.0f ? (type == NoiseType::Value ? 1.0f : 0.70710678f) / totalAmplitude : 0.0f;
+        const float offset = (type == NoiseType::Value ? 0.0f : 0.5f) + average * scale;
+
+        auto rowId = [&](int64_t row, int shift)
+        {
+            return window.wrap ? (uint32_t)((row << shift) % height) : (uint32_t)row;
+        };
+
+        const int strips = (height + StripRows - 1) / StripRows;
+        cv::parallel_for_(cv::Range(0, strips), [&](const cv::Range & range)
+        {
+            std::vector<OctaveRows> rows(columns.size());
+            for (size_t o = 0; o < columns.size(); o++)
+            {
+                rows[o].above.resize(columns[o].x.size());
+                rows[o].below.resize(columns[o].x.size());
+                rows[o].a.resize(columns[o].x.size());
+                rows[o].b.resize(columns[o].x.size());
+            }
+            std::vector<float> sum(roundUp8(width));
+
+            for (int y = range.start * StripRows; y < std::min(range.end * StripRows, height); y++)
+            {
+                std::fill(sum.begin(), sum.end(), 0.0f);
+                for (size_t o = 0; o < columns.size(); o++)
+                {
+                    const OctaveColumns & octave = columns[o];
+                    OctaveRows & octaveRows = rows[o];
+                    const int64_t pixelY = window.y + y;
+                    const int64_t row = pixelY >> octave.shift;
+
+                    // the lattice rows only change every period rows, the row below becomes the row above
+                    if (!octaveRows.cached || octaveRows.row != row)
+                    {
+                        if (octaveRows.cached && octaveRows.row + 1 == row)
+                        {
+                            octaveRows.above.swap(octaveRows.below);
+                        }
+                        else
+                        {
+                            hashLatticeRow(octaveRows.above.data(), octave, rowId(row, octave.shift));
+                        }
+                        hashLatticeRow(octaveRows.below.data(), octave, rowId(row + 1, octave.shift));
+                        octaveRows.row = row;
+                        octaveRows.cached = true;
+                    }
+
+                    blendLatticeRows(octaveRows, (float)(pixelY - (row << octave.shift)) / octave.period, type);
+                    addOctave(sum.data(), width, octave, octaveRows, type);
+                }
+
+                float * out = output.ptr<float>(y);
+                for (int x = 0; x < width; x++)
+                {
+                    out[x] = offset + sum[x] * scale;
+                }
+            }
+        });
+    }
+}
+
+void fractalNoise(cv::Mat & output, int seed, int octaves, float persistance, NoiseType type)
+{
+    PROFILE_FUNCTION();
+
+    generate(output, NoiseWindow(), seed, octaves, persistance, type);
+}
+
+void fractalNoise(cv::Mat & output, int64_t x, int64_t y, int lod, int seed, int octaves, float persistance, NoiseType type)
+{
+    PROFILE_FUNCTION();
+
+    NoiseWindow window;
+    window.wrap = false;
+    window.x = x;
+    window.y = y;
+    window.lod = std::max(lod, 0);
+    generate(output, window, seed, octaves, persistance, type);
+}
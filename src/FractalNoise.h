@@ -0,0 +1,22 @@
+#pragma once
+
+#include <opencv2/opencv.hpp>
+
+enum class NoiseType
+{
+    Value,          // linear blend of random values at the lattice points, the look of Perlin2DNew
+    Gradient        // Perlin's gradient noise, random directions at the lattice points and a quintic fade
+};
+
+// Fills output (CV_32F) with octaves of lattice noise in [0, 1] that wraps around at the edges
+// Octave o has a lattice point every 2^o pixels and weighs persistance^(octaves - o), like Perlin2DNew.
+// All octaves of a row are summed in one pass, so there are no grids per octave: each octave hashes the lattice
+// rows it needs from (x, y, octave, seed) and keeps them while the rows of a strip move between two of them.
+// Strips of rows run in parallel and the pixels of a row are computed 8 at a time with AVX2.
+void fractalNoise(cv::Mat & output, int seed, int octaves, float persistance, NoiseType type);
+
+// Fills output with a window of the same noise that goes on forever instead of wrapping around
+// Pixel (0, 0) is at (x, y) in pixels of the level of detail lod, where a pixel covers 2^lod pixels of the finest
+// octave. Octaves finer than a pixel are replaced by their average, so a window at a coarser level is the same
+// terrain without its finest detail. x has to be a multiple of 8.
+void fractalNoise(cv::Mat & output, int64_t x, int64_t y, int lod, int seed, int octaves, float persistance, NoiseType type);
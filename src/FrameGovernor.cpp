@@ -0,0 +1,96 @@
+#include "FrameGovernor.h"
+#include "Profiler.hpp"
+
+#include "imgui.h"
+#include "imgui-SFML.h"
+
+void FrameGovernor::endFrame()
+{
+    PROFILE_FUNCTION();
+
+    if (!m_enabled || m_activity)
+    {
+        m_mode = GovernorMode::Active;
+        m_sinceActivity = 0.0f;
+    }
+    else if (m_sinceActivity >= m_idleDelay)
+    {
+        m_mode = GovernorMode::Idle;
+    }
+    else
+    {
+        m_mode = GovernorMode::Settling;
+    }
+    m_activity = false;
+
+    // sleep away whatever is left of the frame period of the current mode
+    int fps = (m_mode == GovernorMode::Idle) ? m_idleFPS : m_activeFPS;
+    if (m_enabled && fps > 0)
+    {
+        sf::Time period = sf::seconds(1.0f / fps);
+        sf::Time elapsed = m_frameClock.getElapsedTime();
+        if (elapsed < period)
+        {
+            PROFILE_SCOPE("Governor Sleep");
+            sf::sleep(period - elapsed);
+        }
+    }
+
+    float frameTime = m_frameClock.restart().asSeconds();
+    m_timeInMode[(int)m_mode] += frameTime;
+    m_sinceActivity += frameTime;
+}
+
+const char * FrameGovernor::modeName() const
+{
+    switch (m_mode)
+    {
+        case GovernorMode::Active:   return "Active";
+        case GovernorMode::Settling: return "Settling";
+        case GovernorMode::Idle:     return "Idle";
+    }
+    return "";
+}
+
+void FrameGovernor::imgui()
+{
+    PROFILE_FUNCTION();
+
+    ImGui::Checkbox("Adaptive Frame Rate", &m_enabled);
+    ImGui::Checkbox("Skip Processing When Idle", &m_skipIdleProcessing);
+    ImGui::SliderInt("Active FPS (0 = Unlimited)", &m_activeFPS, 0, 240);
+    ImGui::SliderInt("Idle FPS", &m_idleFPS, 1, 30);
+    ImGui::SliderFloat("Idle Delay (s)", &m_idleDelay, 0.0f, 60.0f);
+
+    ImGui::Separator();
+    ImGui::Text("Mode: %s", modeName());
+
+    double total = m_timeInMode[0] + m_timeInMode[1] + m_timeInMode[2];
+    const char * names[] = { "Active", "Settling", "Idle" };
+    for (int i = 0; i < 3; i++)
+    {
+        ImGui::Text("%-8s %10.1f s (%5.1f%%)", names[i], m_timeInMode[i], total > 0.0 ? 100.0 * m_timeInMode[i] / total : 0.0);
+    }
+    if (ImGui::Button("Reset Times"))
+    {
+        m_timeInMode[0] = m_timeInMode[1] = m_timeInMode[2] = 0.0;
+    }
+}
+
+void FrameGovernor::save(Save & save) const
+{
+    save.adaptiveFrameRate = m_enabled;
+    save.skipIdleProcessing = m_skipIdleProcessing;
+    save.activeFPS = m_activeFPS;
+    save.idleFPS = m_idleFPS;
+    save.idleDelay = m_idleDelay;
+}
+
+void FrameGovernor::load(const Save & save)
+{
+    m_enabled = save.adaptiveFrameRate;
+    m_skipIdleProcessing = save.skipIdleProcessing;
+    m_activeFPS = save.activeFPS;
+    m_idleFPS = save.idleFPS;
+    m_idleDelay = save.idleDelay;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Save.hpp"
+
+#include <SFML/System.hpp>
+
+enum class GovernorMode
+{
+    Active,     // something is moving, run at full rate
+    Settling,   // nothing moved recently, still at full rate until the idle delay passes
+    Idle,       // the sand has been still for a while, run at the idle rate
+};
+
+// Decides how fast the engine loop runs based on how much is happening in the scene
+// The scene reports activity (depth changes, gestures, input, running simulations) every frame it sees any,
+// a single report puts the governor back to Active so the very next frame runs at full rate
+class FrameGovernor
+{
+    GovernorMode    m_mode = GovernorMode::Active;
+    bool            m_activity = true;
+    bool            m_enabled = true;
+    bool            m_skipIdleProcessing = true;
+    int             m_activeFPS = 0;            // 0 means unlimited
+    int             m_idleFPS = 5;
+    float           m_idleDelay = 3.0f;         // seconds without activity before going idle
+    float           m_sinceActivity = 0.0f;
+    double          m_timeInMode[3] = { 0.0, 0.0, 0.0 };
+    sf::Clock       m_frameClock;
+
+public:
+
+    // something changed this frame, the loop should run at full rate
+    inline void reportActivity() { m_activity = true; }
+
+    // called once at the end of every engine frame, sleeps as long as the current mode asks for
+    void endFrame();
+
+    inline GovernorMode mode() const { return m_mode; }
+    inline bool isIdle() const { return m_enabled && m_mode == GovernorMode::Idle; }
+
+    // while idle nothing is moving, so the scene can skip processing frames without changes
+    inline bool shouldSkipProcessing() const { return isIdle() && m_skipIdleProcessing; }
+
+    const char * modeName() const;
+
+    void imgui();
+    void save(Save & save) const;
+    void load(const Save & save);
+};
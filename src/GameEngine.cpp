@@ -43,6 +43,11 @@ mc::MinecraftInterface & GameEngine::minecraft()
     return m_mcInterface;
 }
 
+FrameGovernor & GameEngine::governor()
+{
+    return m_governor;
+}
+
 std::shared_ptr<Scene> GameEngine::currentScene()
 {
     return m_sceneMap.at(m_currentScene);
@@ -75,6 +80,9 @@ void GameEngine::update()
             m_displayWindow.display();
         }
     }
+
+    // sleeps when the scene has been still for a while instead of spinning at full speed
+    m_governor.endFrame();
 }
 
 void GameEngine::run()
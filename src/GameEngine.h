@@ -10,6 +10,7 @@
 #include "imgui.h"
 #include "imgui-SFML.h"
 #include "MinecraftInterface.h"
+#include "FrameGovernor.h"
 
 typedef std::map<std::string, std::shared_ptr<Scene>> SceneMap;
 
@@ -28,6 +29,7 @@ protected:
     ImGuiStyle          m_originalStyle;
     mc::MinecraftInterface  m_mcInterface;
     float               m_framerate;
+    FrameGovernor       m_governor;
 
     void update();
 
@@ -68,5 +70,6 @@ public:
     sf::RenderWindow & window();
     sf::RenderWindow & displayWindow();
     mc::MinecraftInterface & minecraft();
+    FrameGovernor & governor();
     bool isRunning();
 };
\ No newline at end of file
@@ -39,7 +39,10 @@ void Assert::ReportFailure(const char * condition, const char * file, int line,
     ss << "Time:      " << CurrentDateTime() << std::endl;
 
     std::cerr << ss.str() << "\n";
-    Logger::Log(ss.str() + "\n");
+    Logger::Log(LogLevel::Error, ss.str() + "\n");
+
+    // the logger writes on a background thread, make sure the failure reaches the file before we exit
+    Logger::Flush();
 
     exit(-1);
 }
@@ -1,7 +1,55 @@
 #include "HandDetection.h"
 #include "Tools.h"
+#include "Profiler.hpp"
 
 #include <fstream>
+#include <immintrin.h> // For AVX intrinsics
+
+namespace
+{
+    // one pixel of the background model, returns the depth with the hand removed
+    inline float backgroundPixel(float input, float & background, uint8_t mask, uint8_t & hold, int holdFrames, float rate)
+    {
+        bool covered = mask || hold > 0;
+        hold = mask ? (uint8_t)holdFrames : (uint8_t)std::max(hold - 1, 0);
+        if (covered) { return background; }
+
+        if (input >= background) { background = input; }
+        else                     { background += rate * (input - background); }
+        return input;
+    }
+
+    // 8 pixels of backgroundPixel at once
+    inline void backgroundPixels8(float * output, const float * input, float * background, const uint8_t * mask, uint8_t * hold, int holdFrames, float rate)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi32(1);
+
+        __m256 in = _mm256_loadu_ps(input);
+        __m256 bg = _mm256_loadu_ps(background);
+        __m256i m = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)mask));
+        __m256i h = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)hold));
+
+        __m256i masked = _mm256_xor_si256(_mm256_cmpeq_epi32(m, zero), _mm256_set1_epi32(-1));
+        __m256i held = _mm256_cmpgt_epi32(h, zero);
+
+        // the hold counter restarts under the mask and counts down once the hand is gone
+        __m256i newHold = _mm256_blendv_epi8(_mm256_max_epi32(_mm256_sub_epi32(h, one), zero), _mm256_set1_epi32(holdFrames), masked);
+
+        // unmasked pixels update the background, farther depth at once and nearer depth at the approach rate
+        __m256 farther = _mm256_cmp_ps(in, bg, _CMP_GE_OQ);
+        __m256 approached = _mm256_fmadd_ps(_mm256_set1_ps(rate), _mm256_sub_ps(in, bg), bg);
+        __m256 updated = _mm256_blendv_ps(approached, in, farther);
+        __m256 covered = _mm256_castsi256_ps(_mm256_or_si256(masked, held));
+        __m256 newBackground = _mm256_blendv_ps(updated, bg, covered);
+
+        _mm256_storeu_ps(background, newBackground);
+        _mm256_storeu_ps(output, _mm256_blendv_ps(in, newBackground, covered));
+
+        __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(newHold), _mm256_extracti128_si256(newHold, 1));
+        _mm_storel_epi64((__m128i *)hold, _mm_packus_epi16(packed, packed));
+    }
+}
 
 HandDetection::HandDetection()
 {
@@ -89,6 +137,13 @@ void HandDetection::imgui()
     }
     
     ImGui::SliderInt("Threshold", &m_thresh, 0, 255);
+    ImGui::SliderInt("Mask Dilation", &m_dilation, 0, 20);
+    ImGui::SliderInt("Mask Hold Frames", &m_holdFrames, 0, 30);
+    ImGui::SliderFloat("Background Approach Rate", &m_approachRate, 0.0f, 1.0f);
+    if (ImGui::Button("Reset Background"))
+    {
+        reset();
+    }
 
     if (ImGui::CollapsingHeader("Convex Hulls"))
     {
@@ -113,30 +168,70 @@ void HandDetection::imgui()
     }
 }
 
+void HandDetection::reset()
+{
+    m_background = cv::Mat();
+    m_hold = cv::Mat();
+}
+
 // Function that detects the area taken up by hands / arms and ignores it
+// Hands are anything nearer than the threshold, which includes pixels without depth.
+// The hand mask is dilated and held for a few frames, everything under it is filled from a background model
+// that is only updated where no hand is, so a hand that rests on the sand never becomes part of it.
 void HandDetection::removeHands(const cv::Mat & input, cv::Mat & output, float maxDistance, float minDistance)
 {
-    if (m_previous.total() <= 0) // For the first frame
+    PROFILE_FUNCTION();
+
+    if (m_background.size() != input.size()) // For the first frame
     {
-        m_previous = input.clone();
-        output = input;
+        m_background = input.clone();
+        m_hold = cv::Mat::zeros(input.size(), CV_8U);
+        if (output.data != input.data) { input.copyTo(output); }
         return;
     }
-    // Normalize
-    cv::Mat normalized;
-    normalized = 1.f - (input - minDistance) / (maxDistance - minDistance);
-
-    // Binarize
-    cv::Mat binarized;
-    normalized.convertTo(binarized, CV_8U, 255.0);
-    cv::threshold(binarized, m_segmented, m_thresh, 255, cv::THRESH_BINARY);
-    cv::Mat mask = m_segmented == 255;
-    cv::Mat in = input.clone();
-    cv::Mat prev = m_previous.clone();
-    in.setTo(0.0, mask);
-    prev.setTo(0.0, 1 - mask);
-    output = in + prev;
-    m_previous = output.clone();
+
+    // the binarized normalized depth is above the threshold wherever the depth is nearer than this
+    float cutoff = minDistance + (1.0f - (m_thresh + 0.5f) / 255.0f) * (maxDistance - minDistance);
+    cv::compare(input, cutoff, m_segmented, cv::CMP_LT);
+
+    if (m_dilation > 0)
+    {
+        if (m_dilationKernel.rows != 2 * m_dilation + 1)
+        {
+            m_dilationKernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(2 * m_dilation + 1, 2 * m_dilation + 1));
+        }
+        cv::dilate(m_segmented, m_dilated, m_dilationKernel);
+    }
+    else
+    {
+        m_dilated = m_segmented;
+    }
+
+    // background update and hole filling in a single pass, output may be the input itself
+    output.create(input.size(), CV_32F);
+    const int holdFrames = m_holdFrames;
+    const float rate = m_approachRate;
+    cv::parallel_for_(cv::Range(0, input.rows), [&](const cv::Range & range)
+    {
+        for (int y = range.start; y < range.end; y++)
+        {
+            const float * in = input.ptr<float>(y);
+            const uint8_t * mask = m_dilated.ptr<uint8_t>(y);
+            float * out = output.ptr<float>(y);
+            float * background = m_background.ptr<float>(y);
+            uint8_t * hold = m_hold.ptr<uint8_t>(y);
+
+            int x = 0;
+            for (; x + 8 <= input.cols; x += 8)
+            {
+                backgroundPixels8(out + x, in + x, background + x, mask + x, hold + x, holdFrames, rate);
+            }
+            for (; x < input.cols; x++)
+            {
+                out[x] = backgroundPixel(in[x], background[x], mask[x], hold[x], holdFrames, rate);
+            }
+        }
+    });
 }
 
 void HandDetection::identifyGestures(std::vector<cv::Point> & box)
@@ -14,7 +14,15 @@ class HandDetection
     sf::Image m_image;
     sf::Texture m_texture;
 
-    cv::Mat m_previous;
+    // hand removal: pixels under the dilated hand mask are filled from a background model of the sand
+    int m_dilation = 6;                 // pixels the hand mask grows by so arm edges don't leak into the terrain
+    int m_holdFrames = 2;               // frames a pixel stays masked after the hand left it
+    float m_approachRate = 0.25f;       // how fast the background follows sand that rises, lowered sand is taken at once
+
+    cv::Mat m_background;               // depth of the sand without hands, CV_32F
+    cv::Mat m_hold;                     // frames left before a pixel is unmasked, CV_8U
+    cv::Mat m_dilated;                  // hand mask grown by m_dilation, CV_8U
+    cv::Mat m_dilationKernel;
     cv::Mat m_segmented;
 
     std::vector<std::vector<cv::Point>> m_hulls;
@@ -44,6 +52,9 @@ public:
 
     void imgui();
     void removeHands(const cv::Mat & input, cv::Mat & output, float maxDistance, float minDistance);
+
+    // forgets the background and the held mask, the next frame starts them again
+    void reset();
     void identifyGestures(std::vector<cv::Point> & nbox);
     sf::Texture & getTexture();
     void eventHandling(const sf::Event & event);
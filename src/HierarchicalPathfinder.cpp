@@ -0,0 +1,552 @@
+#include "HierarchicalPathfinder.h"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <queue>
+
+namespace
+{
+    // runs of crossings at least this long get a transition at each end instead of one in the middle
+    constexpr int LongRun = 6;
+
+    inline int32_t octile(State a, State b)
+    {
+        State d = a.absdiff(b);
+        int32_t diagonal = std::min(d.x, d.y);
+        return 100 * (std::max(d.x, d.y) - diagonal) + 141 * diagonal;
+    }
+
+    typedef std::pair<int32_t, int32_t> QueueEntry;     // cost, index
+    typedef std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> MinQueue;
+}
+
+HierarchicalPathfinder::HierarchicalPathfinder(int clusterSize)
+    : m_clusterSize(std::max(clusterSize, 2))
+{
+
+}
+
+void HierarchicalPathfinder::labelComponents(const Cluster & cluster)
+{
+    // every cell gets the first cell of its part, the parts are what searchCluster can reach from a cell
+    auto inside = [&](State s) { return s.x >= cluster.x && s.y >= cluster.y && s.x < cluster.x + cluster.width && s.y < cluster.y + cluster.height; };
+    for (int y = cluster.y; y < cluster.y + cluster.height; y++)
+    {
+        for (int x = cluster.x; x < cluster.x + cluster.width; x++) { m_components.set(x, y, -1); }
+    }
+
+    std::vector<State> stack;
+    for (int y = cluster.y; y < cluster.y + cluster.height; y++)
+    {
+        for (int x = cluster.x; x < cluster.x + cluster.width; x++)
+        {
+            State seed(x, y);
+            if (m_components.get(seed) >= 0 || !AStar::passable(m_heights, seed, m_costs)) { continue; }
+
+            const int32_t label = y * (int32_t)m_heights.width() + x;
+            m_components.set(seed, label);
+            stack.push_back(seed);
+            while (!stack.empty())
+            {
+                State s = stack.back();
+                stack.pop_back();
+                for (const Action & action : Actions8())
+                {
+                    State n = s + action.dir;
+                    if (!inside(n) || m_components.get(n) >= 0) { continue; }
+                    if (AStar::stepCost(m_heights, s, action, m_costs) < 0) { continue; }
+
+                    m_components.set(n, label);
+                    stack.push_back(n);
+                }
+            }
+        }
+    }
+}
+
+void HierarchicalPathfinder::buildBorder(int cluster, bool right)
+{
+    const Cluster & c = m_clusters[cluster];
+    auto & transitions = right ? m_bordersRight[cluster] : m_bordersDown[cluster];
+    transitions.clear();
+
+    // the last cluster in a row or column has nothing to its right or below it
+    if (right && c.x + c.width >= (int)m_heights.width()) { return; }
+    if (!right && c.y + c.height >= (int)m_heights.height()) { return; }
+
+    struct Crossing
+    {
+        int         position;               // along the border
+        bool        diagonal;
+        Transition  transition;
+        int32_t     from, to;               // the parts of the two clusters it joins
+    };
+
+    // every step out of the border cells, diagonal steps over the corner of a cluster are only in the right borders
+    const int length = right ? c.height : c.width;
+    std::vector<Crossing> crossings;
+    for (int i = 0; i < length; i++)
+    {
+        State a = right ? State(c.x + c.width - 1, c.y + i) : State(c.x + i, c.y + c.height - 1);
+        if (!AStar::passable(m_heights, a, m_costs)) { continue; }
+
+        for (int side : { 0, -1, 1 })
+        {
+            const Action step(right ? State(1, side) : State(side, 1), side == 0 ? 100 : 141);
+            State b = a + step.dir;
+            if (!right && (b.x < c.x || b.x >= c.x + c.width)) { continue; }
+
+            int32_t cost = AStar::stepCost(m_heights, a, step, m_costs);
+            if (cost < 0) { continue; }
+            crossings.push_back({ i, side != 0, { a, b, cost }, m_components.get(a), m_components.get(b) });
+        }
+    }
+
+    // crossings between the same two parts that follow each other along the border form a run
+    // straight runs come first, diagonal crossings only get transitions for parts no straight step joins
+    std::stable_sort(crossings.begin(), crossings.end(), [](const Crossing & l, const Crossing & r)
+    {
+        if (l.diagonal != r.diagonal) { return r.diagonal; }
+        return l.from != r.from ? l.from < r.from : l.to < r.to;
+    });
+
+    std::vector<std::pair<int32_t, int32_t>> joined;
+    size_t i = 0;
+    while (i < crossings.size())
+    {
+        const Crossing & first = crossings[i];
+        size_t start = i++;
+        while (i < crossings.size() && crossings[i].diagonal == first.diagonal && crossings[i].from == first.from && crossings[i].to == first.to
+            && crossings[i].position <= crossings[i - 1].position + 1) { i++; }
+
+        const std::pair<int32_t, int32_t> parts(first.from, first.to);
+        if (!first.diagonal) { joined.push_back(parts); }
+        else if (std::find(joined.begin(), joined.end(), parts) != joined.end()) { continue; }
+
+        if (crossings[i - 1].position - first.position + 1 < LongRun)
+        {
+            transitions.push_back(crossings[start + (i - start) / 2].transition);
+        }
+        else
+        {
+            transitions.push_back(first.transition);
+            transitions.push_back(crossings[i - 1].transition);
+        }
+    }
+}
+
+void HierarchicalPathfinder::collectEntrances(int cluster, std::vector<State> & entrances, std::vector<std::vector<Link>> & links) const
+{
+    entrances.clear();
+    links.clear();
+
+    auto add = [&](State cell, State other, int32_t cost)
+    {
+        size_t i = std::find(entrances.begin(), entrances.end(), cell) - entrances.begin();
+        if (i == entrances.size())
+        {
+            entrances.push_back(cell);
+            links.emplace_back();
+        }
+        links[i].push_back({ other, cost });
+    };
+
+    // the borders of the cluster itself, then the borders of the clusters left of and above it that step into it
+    const int cx = cluster % m_clustersX;
+    const int cy = cluster / m_clustersX;
+    for (auto & t : m_bordersRight[cluster]) { add(t.a, t.b, t.cost); }
+    for (auto & t : m_bordersDown[cluster])  { add(t.a, t.b, t.cost); }
+    auto into = [&](const std::vector<Transition> & border)
+    {
+        for (auto & t : border) { if (clusterOf(t.b) == cluster) { add(t.b, t.a, t.cost); } }
+    };
+    for (int dy = -1; dy <= 1 && cx > 0; dy++)
+    {
+        if (cy + dy >= 0 && cy + dy < m_clustersY) { into(m_bordersRight[cluster - 1 + dy * m_clustersX]); }
+    }
+    if (cy > 0) { into(m_bordersDown[cluster - m_clustersX]); }
+}
+
+void HierarchicalPathfinder::searchCluster(const Cluster & cluster, State from, State target)
+{
+    const size_t area = (size_t)cluster.width * cluster.height;
+    m_localCost.assign(area, INT32_MAX);
+    m_localParent.assign(area, -1);
+
+    auto local = [&](State s) { return (s.y - cluster.y) * cluster.width + (s.x - cluster.x); };
+    auto inside = [&](State s) { return s.x >= cluster.x && s.y >= cluster.y && s.x < cluster.x + cluster.width && s.y < cluster.y + cluster.height; };
+    const int32_t targetIndex = inside(target) ? local(target) : -1;
+
+    MinQueue open;
+    m_localCost[local(from)] = 0;
+    open.push({ 0, local(from) });
+    while (!open.empty())
+    {
+        auto [cost, index] = open.top();
+        open.pop();
+        if (cost > m_localCost[index]) { continue; }
+        if (index == targetIndex) { break; }
+
+        State s(cluster.x + index % cluster.width, cluster.y + index / cluster.width);
+        for (const Action & action : Actions8())
+        {
+            State n = s + action.dir;
+            if (!inside(n)) { continue; }
+
+            int32_t step = AStar::stepCost(m_heights, s, action, m_costs);
+            if (step < 0) { continue; }
+
+            int32_t ni = local(n);
+            if (cost + step < m_localCost[ni])
+            {
+                m_localCost[ni] = cost + step;
+                m_localParent[ni] = index;
+                open.push({ cost + step, ni });
+            }
+        }
+    }
+}
+
+int32_t HierarchicalPathfinder::localCost(const Cluster & cluster, State s) const
+{
+    int32_t cost = m_localCost[(s.y - cluster.y) * cluster.width + (s.x - cluster.x)];
+    return cost == INT32_MAX ? -1 : cost;
+}
+
+void HierarchicalPathfinder::computeDistances(Cluster & cluster)
+{
+    const size_t n = cluster.entrances.size();
+    cluster.distances.assign(n * n, -1);
+    for (size_t i = 0; i < n; i++)
+    {
+        searchCluster(cluster, cluster.entrances[i], State(-1, -1));
+        for (size_t j = 0; j < n; j++)
+        {
+            cluster.distances[i * n + j] = localCost(cluster, cluster.entrances[j]);
+        }
+    }
+}
+
+size_t HierarchicalPathfinder::update(const Grid<float> & heights, const TraversalCosts & costs)
+{
+    PROFILE_FUNCTION();
+
+    const int width = (int)heights.width();
+    const int height = (int)heights.height();
+    bool full = !m_built
+        || heights.width() != m_heights.width() || heights.height() != m_heights.height()
+        || costs.slopePenalty != m_costs.slopePenalty || costs.maxStep != m_costs.maxStep || costs.minHeight != m_costs.minHeight;
+
+    std::vector<uint8_t> dirty;
+    if (full)
+    {
+        m_heights = heights;
+        m_costs = costs;
+        m_clustersX = (width + m_clusterSize - 1) / m_clusterSize;
+        m_clustersY = (height + m_clusterSize - 1) / m_clusterSize;
+        m_clusters = std::vector<Cluster>(m_clustersX * m_clustersY);
+        m_bordersRight = std::vector<std::vector<Transition>>(m_clusters.size());
+        m_bordersDown = std::vector<std::vector<Transition>>(m_clusters.size());
+        m_entranceIndex.refill(width, height, -1);
+        m_components.refill(width, height, -1);
+        for (int cy = 0; cy < m_clustersY; cy++)
+        {
+            for (int cx = 0; cx < m_clustersX; cx++)
+            {
+                Cluster & c = m_clusters[cy * m_clustersX + cx];
+                c.x = cx * m_clusterSize;
+                c.y = cy * m_clusterSize;
+                c.width = std::min(m_clusterSize, width - c.x);
+                c.height = std::min(m_clusterSize, height - c.y);
+            }
+        }
+        dirty = std::vector<uint8_t>(m_clusters.size(), 1);
+        m_built = true;
+    }
+    else
+    {
+        // a cluster is dirty when any of its rows changed, those rows are taken over
+        PROFILE_SCOPE("Compare Clusters");
+        dirty = std::vector<uint8_t>(m_clusters.size(), 0);
+        for (size_t i = 0; i < m_clusters.size(); i++)
+        {
+            const Cluster & c = m_clusters[i];
+            for (int y = c.y; y < c.y + c.height; y++)
+            {
+                const float * row = &heights.get(c.x, y);
+                if (std::memcmp(&m_heights.get(c.x, y), row, c.width * sizeof(float)) != 0) { dirty[i] = 1; break; }
+            }
+            if (!dirty[i]) { continue; }
+
+            for (int y = c.y; y < c.y + c.height; y++)
+            {
+                std::memcpy(&m_heights.get(c.x, y), &heights.get(c.x, y), c.width * sizeof(float));
+            }
+        }
+    }
+
+    // borders depend on the parts of the clusters on both sides, so every dirty cluster is labelled first
+    for (size_t i = 0; i < m_clusters.size(); i++)
+    {
+        if (dirty[i]) { labelComponents(m_clusters[i]); }
+    }
+
+    // every border that steps out of or into a dirty cluster changes, and with it the entrances on both sides
+    std::vector<uint8_t> affected(m_clusters.size(), 0);
+    std::vector<uint8_t> rebuiltRight(m_clusters.size(), 0);
+    std::vector<uint8_t> rebuiltDown(m_clusters.size(), 0);
+    auto rebuild = [&](int cx, int cy, bool right)
+    {
+        if (cx < 0 || cy < 0 || cx >= m_clustersX || cy >= m_clustersY) { return; }
+
+        const int i = cy * m_clustersX + cx;
+        auto & done = right ? rebuiltRight[i] : rebuiltDown[i];
+        if (done) { return; }
+        done = 1;
+        buildBorder(i, right);
+        affected[i] = 1;
+        for (int dy = right ? -1 : 1; dy <= 1; dy++)
+        {
+            const int nx = right ? cx + 1 : cx;
+            const int ny = cy + dy;
+            if (nx < m_clustersX && ny >= 0 && ny < m_clustersY) { affected[ny * m_clustersX + nx] = 1; }
+        }
+    };
+    for (int i = 0; i < (int)m_clusters.size(); i++)
+    {
+        if (!dirty[i]) { continue; }
+
+        const int cx = i % m_clustersX;
+        const int cy = i / m_clustersX;
+        rebuild(cx, cy, true);
+        rebuild(cx, cy, false);
+        rebuild(cx - 1, cy - 1, true);
+        rebuild(cx - 1, cy, true);
+        rebuild(cx - 1, cy + 1, true);
+        rebuild(cx, cy - 1, true);
+        rebuild(cx, cy + 1, true);
+        rebuild(cx, cy - 1, false);
+    }
+
+    m_rebuilt = 0;
+    std::vector<State> entrances;
+    std::vector<std::vector<Link>> links;
+    for (size_t i = 0; i < m_clusters.size(); i++)
+    {
+        if (!affected[i]) { continue; }
+
+        Cluster & c = m_clusters[i];
+        collectEntrances((int)i, entrances, links);
+        for (State s : c.entrances) { m_entranceIndex.set(s, -1); }
+
+        // a neighbour whose cells and entrances stayed the same keeps its distances, only the links changed
+        bool recompute = dirty[i] || entrances != c.entrances;
+        c.entrances.swap(entrances);
+        c.links.swap(links);
+        for (size_t e = 0; e < c.entrances.size(); e++) { m_entranceIndex.set(c.entrances[e], (int32_t)e); }
+
+        if (recompute)
+        {
+            computeDistances(c);
+            m_rebuilt++;
+        }
+    }
+
+    m_nodeCount = 0;
+    for (auto & c : m_clusters)
+    {
+        c.firstNode = m_nodeCount;
+        m_nodeCount += c.entrances.size();
+    }
+
+    // start and goal are the two nodes after the entrances
+    m_nodeCost.resize(m_nodeCount + 2);
+    m_nodeParent.resize(m_nodeCount + 2);
+    m_nodeSeen.assign(m_nodeCount + 2, 0);
+    m_nodeClosed.assign(m_nodeCount + 2, 0);
+    m_stamp = 0;
+    return m_rebuilt;
+}
+
+bool HierarchicalPathfinder::findWaypoints(State start, State goal, std::vector<State> & waypoints)
+{
+    PROFILE_FUNCTION();
+
+    waypoints.clear();
+    m_stats = SearchStats();
+    if (!m_built || !AStar::passable(m_heights, start, m_costs) || !AStar::passable(m_heights, goal, m_costs)) { return false; }
+
+    if (start == goal)
+    {
+        waypoints.push_back(start);
+        m_stats.cost = 0;
+        return true;
+    }
+
+    const int startCluster = clusterOf(start);
+    const int goalCluster = clusterOf(goal);
+    const Cluster & sc = m_clusters[startCluster];
+    const Cluster & gc = m_clusters[goalCluster];
+
+    // connect start and goal to the entrances of their clusters, costs are symmetric so both search outwards
+    searchCluster(sc, start, State(-1, -1));
+    m_startCosts.resize(sc.entrances.size());
+    for (size_t i = 0; i < sc.entrances.size(); i++) { m_startCosts[i] = localCost(sc, sc.entrances[i]); }
+    int32_t direct = startCluster == goalCluster ? localCost(sc, goal) : -1;
+
+    searchCluster(gc, goal, State(-1, -1));
+    m_goalCosts.resize(gc.entrances.size());
+    for (size_t i = 0; i < gc.entrances.size(); i++) { m_goalCosts[i] = localCost(gc, gc.entrances[i]); }
+
+    if (++m_stamp == 0)
+    {
+        std::fill(m_nodeSeen.begin(), m_nodeSeen.end(), 0);
+        std::fill(m_nodeClosed.begin(), m_nodeClosed.end(), 0);
+        m_stamp = 1;
+    }
+
+    const int32_t startID = (int32_t)m_nodeCount;
+    const int32_t goalID = (int32_t)m_nodeCount + 1;
+    auto cellOf = [&](int32_t id, int32_t & cluster) -> State
+    {
+        if (id == startID) { cluster = startCluster; return start; }
+        if (id == goalID)  { cluster = goalCluster; return goal; }
+
+        // clusters are in id order, so the owner is the last one starting at or before the id
+        auto it = std::upper_bound(m_clusters.begin(), m_clusters.end(), (size_t)id, [](size_t value, const Cluster & c) { return value < c.firstNode; });
+        cluster = (int32_t)(it - m_clusters.begin()) - 1;
+        return m_clusters[cluster].entrances[id - m_clusters[cluster].firstNode];
+    };
+
+    MinQueue open;
+    auto relax = [&](int32_t from, int32_t to, int32_t cost, State cell)
+    {
+        int32_t g = m_nodeCost[from] + cost;
+        if (m_nodeClosed[to] == m_stamp) { return; }
+        if (m_nodeSeen[to] == m_stamp && g >= m_nodeCost[to]) { return; }
+        m_nodeSeen[to] = m_stamp;
+        m_nodeCost[to] = g;
+        m_nodeParent[to] = from;
+        open.push({ g + octile(cell, goal), to });
+        m_stats.generated++;
+    };
+
+    m_nodeSeen[startID] = m_stamp;
+    m_nodeCost[startID] = 0;
+    m_nodeParent[startID] = -1;
+    open.push({ octile(start, goal), startID });
+
+    while (!open.empty())
+    {
+        int32_t id = open.top().second;
+        open.pop();
+        if (m_nodeClosed[id] == m_stamp) { continue; }
+        m_nodeClosed[id] = m_stamp;
+        m_stats.expanded++;
+        if (id == goalID) { break; }
+
+        if (id == startID)
+        {
+            for (size_t i = 0; i < sc.entrances.size(); i++)
+            {
+                if (m_startCosts[i] >= 0) { relax(id, (int32_t)(sc.firstNode + i), m_startCosts[i], sc.entrances[i]); }
+            }
+            if (direct >= 0) { relax(id, goalID, direct, goal); }
+            continue;
+        }
+
+        int32_t clusterIndex;
+        cellOf(id, clusterIndex);
+        const Cluster & c = m_clusters[clusterIndex];
+        const size_t i = id - c.firstNode;
+        const size_t n = c.entrances.size();
+
+        for (size_t j = 0; j < n; j++)
+        {
+            int32_t d = c.distances[i * n + j];
+            if (j != i && d >= 0) { relax(id, (int32_t)(c.firstNode + j), d, c.entrances[j]); }
+        }
+
+        for (auto & link : c.links[i])
+        {
+            const Cluster & other = m_clusters[clusterOf(link.cell)];
+            relax(id, (int32_t)(other.firstNode + m_entranceIndex.get(link.cell)), link.cost, link.cell);
+        }
+
+        if (clusterIndex == goalCluster && m_goalCosts[i] >= 0) { relax(id, goalID, m_goalCosts[i], goal); }
+    }
+
+    if (m_nodeClosed[goalID] != m_stamp) { return false; }
+
+    m_stats.cost = m_nodeCost[goalID];
+    for (int32_t id = goalID; id != -1; id = m_nodeParent[id])
+    {
+        int32_t cluster;
+        State cell = cellOf(id, cluster);
+        if (waypoints.empty() || !(waypoints.back() == cell)) { waypoints.push_back(cell); }
+    }
+    std::reverse(waypoints.begin(), waypoints.end());
+    return true;
+}
+
+bool HierarchicalPathfinder::refineSegment(State from, State to, std::vector<State> & cells)
+{
+    if (from == to) { return true; }
+
+    // waypoints in different clusters are the two sides of a transition
+    if (clusterOf(from) != clusterOf(to))
+    {
+        State d(to.x - from.x, to.y - from.y);
+        if (std::max(std::abs(d.x), std::abs(d.y)) != 1) { return false; }
+        cells.push_back(to);
+        return true;
+    }
+
+    const Cluster & c = m_clusters[clusterOf(from)];
+    searchCluster(c, from, to);
+    if (localCost(c, to) < 0) { return false; }
+
+    size_t first = cells.size();
+    const int32_t fromIndex = (from.y - c.y) * c.width + (from.x - c.x);
+    for (int32_t index = (to.y - c.y) * c.width + (to.x - c.x); index != fromIndex; index = m_localParent[index])
+    {
+        cells.push_back(State(c.x + index % c.width, c.y + index / c.width));
+    }
+    std::reverse(cells.begin() + first, cells.end());
+    return true;
+}
+
+bool HierarchicalPathfinder::search(State start, State goal, std::vector<State> & path)
+{
+    path.clear();
+    std::vector<State> waypoints;
+    if (!findWaypoints(start, goal, waypoints)) { return false; }
+
+    path.push_back(waypoints.front());
+    for (size_t i = 1; i < waypoints.size(); i++)
+    {
+        if (!refineSegment(waypoints[i - 1], waypoints[i], path))
+        {
+            path.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t HierarchicalPathfinder::memoryUsage() const
+{
+    size_t bytes = m_heights.width() * m_heights.height() * (sizeof(float) + 2 * sizeof(int32_t));
+    for (auto & c : m_clusters)
+    {
+        bytes += sizeof(Cluster) + c.entrances.capacity() * sizeof(State) + c.distances.capacity() * sizeof(int32_t);
+        for (auto & l : c.links) { bytes += sizeof(l) + l.capacity() * sizeof(Link); }
+    }
+    for (auto & b : m_bordersRight) { bytes += sizeof(b) + b.capacity() * sizeof(Transition); }
+    for (auto & b : m_bordersDown)  { bytes += sizeof(b) + b.capacity() * sizeof(Transition); }
+    bytes += (m_nodeCost.capacity() + m_nodeParent.capacity() + m_localCost.capacity() + m_localParent.capacity()) * sizeof(int32_t);
+    bytes += (m_nodeSeen.capacity() + m_nodeClosed.capacity()) * sizeof(uint32_t);
+    return bytes;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "AStar.h"
+
+#include <vector>
+
+// Hierarchical pathfinding (HPA*, Botea, Mueller and Schaeffer 2004)
+// The grid is cut into square clusters. Every step from one cluster into another, straight or diagonal, can be
+// crossed at a transition: the crossings that join the same two slope connected parts of the clusters form runs,
+// every run gets one transition in its middle, or one at each end when it is long, and the cells on either side
+// become entrances of their clusters, so every part of a cluster that a path can cross into has an entrance.
+// Diagonal crossings only get transitions between parts that no straight crossing joins.
+// The cost between every pair of entrances of a cluster is found once with a search that stays inside the
+// cluster and is cached.
+// A query connects start and goal to the entrances of their clusters and searches the small graph of entrances.
+// The cells between two waypoints are only filled in when that segment is refined.
+// update() compares new heights with the ones the graph was built from and only rebuilds the clusters
+// whose cells changed, plus the borders they share with their neighbours.
+// Paths are close to optimal but not always optimal, they are bound to go through the entrances.
+class HierarchicalPathfinder
+{
+    struct Link
+    {
+        State       cell;                   // entrance of the neighbouring cluster
+        int32_t     cost = 0;
+    };
+
+    struct Transition
+    {
+        State       a;                      // in the cluster the border belongs to
+        State       b;                      // one step right, or one step down, in another cluster
+        int32_t     cost = 0;
+    };
+
+    struct Cluster
+    {
+        int         x = 0;                  // first cell covered
+        int         y = 0;
+        int         width = 0;
+        int         height = 0;
+        std::vector<State> entrances;
+        std::vector<std::vector<Link>> links;   // per entrance, the steps into neighbouring clusters
+        std::vector<int32_t> distances;     // entrances x entrances, -1 when not connected inside the cluster
+        size_t      firstNode = 0;          // id of the first entrance in the abstract graph
+    };
+
+    int                 m_clusterSize = 16;
+    int                 m_clustersX = 0;
+    int                 m_clustersY = 0;
+    Grid<float>         m_heights;          // what the graph was built from
+    TraversalCosts      m_costs;
+    bool                m_built = false;
+
+    std::vector<Cluster> m_clusters;
+    std::vector<std::vector<Transition>> m_bordersRight;   // steps from the last column of cluster i into the next column
+    std::vector<std::vector<Transition>> m_bordersDown;    // steps from the last row of cluster i into the cluster below
+    Grid<int32_t>       m_entranceIndex;    // index of an entrance cell in its cluster, -1 for other cells
+    Grid<int32_t>       m_components;       // the first cell of the part of its cluster a cell can reach, -1 when it can't be entered
+    size_t              m_nodeCount = 0;
+
+    // scratch for searches inside one cluster
+    std::vector<int32_t> m_localCost;
+    std::vector<int32_t> m_localParent;
+
+    // scratch for the search over the abstract graph, stamps avoid clearing it between queries
+    std::vector<int32_t> m_nodeCost;
+    std::vector<int32_t> m_nodeParent;
+    std::vector<uint32_t> m_nodeSeen;
+    std::vector<uint32_t> m_nodeClosed;
+    uint32_t            m_stamp = 0;
+    std::vector<int32_t> m_startCosts;     // start to the entrances of its cluster
+    std::vector<int32_t> m_goalCosts;      // goal to the entrances of its cluster
+
+    SearchStats         m_stats;
+    size_t              m_rebuilt = 0;
+
+    inline int clusterOf(State s) const { return (s.y / m_clusterSize) * m_clustersX + (s.x / m_clusterSize); }
+
+    void labelComponents(const Cluster & cluster);
+    void buildBorder(int cluster, bool right);
+    void collectEntrances(int cluster, std::vector<State> & entrances, std::vector<std::vector<Link>> & links) const;
+    void computeDistances(Cluster & cluster);
+
+    // Dijkstra from a cell over the cells of one cluster, fills m_localCost and m_localParent
+    // stops early once target is settled when target is inside the cluster
+    void searchCluster(const Cluster & cluster, State from, State target);
+    int32_t localCost(const Cluster & cluster, State s) const;
+
+public:
+
+    HierarchicalPathfinder(int clusterSize = 16);
+
+    // brings the graph up to date with the heights, returns how many clusters had their distances recomputed
+    // everything is rebuilt when the size or the costs changed, otherwise only clusters whose cells changed
+    size_t update(const Grid<float> & heights, const TraversalCosts & costs);
+
+    // the waypoints of a path from start to goal, consecutive waypoints are in the same or in neighbouring clusters
+    bool findWaypoints(State start, State goal, std::vector<State> & waypoints);
+
+    // appends the cells after from up to and including to, for two consecutive waypoints
+    bool refineSegment(State from, State to, std::vector<State> & cells);
+
+    // findWaypoints and every segment refined, path receives every cell from start to goal
+    bool search(State start, State goal, std::vector<State> & path);
+
+    inline const SearchStats & stats() const { return m_stats; }
+    inline size_t clusterCount() const { return m_clusters.size(); }
+    inline size_t nodeCount() const { return m_nodeCount; }
+    inline size_t lastRebuilt() const { return m_rebuilt; }
+
+    // bytes held by the graph and the search scratch
+    size_t memoryUsage() const;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+
+// Binary min heap of nodes that knows where every node sits, so a node whose key improved
+// can be moved up in O(log n) without searching for it (decrease-key).
+// The position is kept in the node's inOpen field as index + 1, 0 means the node is not in the heap.
+// Compare(a, b) returns true when a has to come out before b, e.g. MinFMinG.
+template <class T, class Compare>
+class IndexedHeap
+{
+    std::vector<T *>    m_heap;
+    Compare             m_less;
+
+    inline void place(T * node, size_t index)
+    {
+        m_heap[index] = node;
+        node->inOpen = (int)index + 1;
+    }
+
+    void siftUp(size_t index)
+    {
+        T * node = m_heap[index];
+        while (index > 0)
+        {
+            size_t parent = (index - 1) / 2;
+            if (!m_less(node, m_heap[parent])) { break; }
+            place(m_heap[parent], index);
+            index = parent;
+        }
+        place(node, index);
+    }
+
+    void siftDown(size_t index)
+    {
+        T * node = m_heap[index];
+        const size_t count = m_heap.size();
+        while (true)
+        {
+            size_t child = 2 * index + 1;
+            if (child >= count) { break; }
+            if (child + 1 < count && m_less(m_heap[child + 1], m_heap[child])) { child++; }
+            if (!m_less(m_heap[child], node)) { break; }
+            place(m_heap[child], index);
+            index = child;
+        }
+        place(node, index);
+    }
+
+public:
+
+    inline bool empty() const { return m_heap.empty(); }
+    inline size_t size() const { return m_heap.size(); }
+    inline size_t capacity() const { return m_heap.capacity(); }
+    inline T * top() const { return m_heap.front(); }
+    inline bool contains(const T * node) const { return node->inOpen != 0; }
+
+    void reserve(size_t count)
+    {
+        m_heap.reserve(count);
+    }
+
+    void push(T * node)
+    {
+        m_heap.push_back(node);
+        siftUp(m_heap.size() - 1);
+    }
+
+    T * pop()
+    {
+        T * node = m_heap.front();
+        node->inOpen = 0;
+
+        T * last = m_heap.back();
+        m_heap.pop_back();
+        if (!m_heap.empty())
+        {
+            m_heap[0] = last;
+            siftDown(0);
+        }
+        return node;
+    }
+
+    // restores the order after the key of a node already in the heap decreased
+    void decreased(T * node)
+    {
+        siftUp((size_t)node->inOpen - 1);
+    }
+
+    // empties the heap, the nodes still in it are marked as not in the heap
+    void clear()
+    {
+        for (T * node : m_heap) { node->inOpen = 0; }
+        m_heap.clear();
+    }
+};
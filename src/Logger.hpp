@@ -4,18 +4,311 @@
 #include <fstream>
 #include <memory>
 #include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
 #include <string>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class LogLevel
+{
+    Debug,
+    Info,
+    Warning,
+    Error
+};
+
+// Per call site state used by LOG_RATE_LIMITED, one static instance lives at each call site
+struct LogRateLimit
+{
+    std::atomic<long long>  nextAllowed = 0;
+    std::atomic<int>        suppressed  = 0;
+};
+
+// Log macros, these format on the calling thread and hand the record to the background writer
+#define LOG_DEBUG(msg, ...)   Logger::Log(LogLevel::Debug,   (msg), ##__VA_ARGS__)
+#define LOG_INFO(msg, ...)    Logger::Log(LogLevel::Info,    (msg), ##__VA_ARGS__)
+#define LOG_WARNING(msg, ...) Logger::Log(LogLevel::Warning, (msg), ##__VA_ARGS__)
+#define LOG_ERROR(msg, ...)   Logger::Log(LogLevel::Error,   (msg), ##__VA_ARGS__)
+
+// Logs at most once every intervalMS from this call site, the number of dropped messages is appended to the next one
+#define LOG_RATE_LIMITED(level, intervalMS, msg, ...) \
+    do \
+    { \
+        static LogRateLimit logRateLimit##__LINE__; \
+        Logger::LogLimited(logRateLimit##__LINE__, (intervalMS), (level), (msg), ##__VA_ARGS__); \
+    } while(0)
 
 class Logger {
 
-    Logger() = default;
-    ~Logger() = default;
+    static constexpr size_t RecordTextSize  = 1024;
+    static constexpr size_t QueueCapacity   = 1024;     // must be a power of two
+    static constexpr size_t WakeThreshold   = QueueCapacity / 2;
+
+    // A preformatted message waiting to be written by the background thread
+    struct Record
+    {
+        LogLevel    level = LogLevel::Info;
+        long long   time = 0;               // microseconds since epoch
+        size_t      length = 0;
+        bool        raw = false;            // raw records are written without the time / level prefix
+        std::array<char, RecordTextSize> text;
+    };
+
+    // Slot in the bounded lock-free multi-producer single-consumer ring buffer
+    // The sequence number tells producers and the consumer who currently owns the slot
+    struct Cell
+    {
+        std::atomic<size_t> sequence = 0;
+        Record              record;
+    };
+
+    std::vector<Cell>           m_cells;
+    std::atomic<size_t>         m_enqueuePos = 0;
+    size_t                      m_dequeuePos = 0;
+
+    std::atomic<LogLevel>       m_minLevel = LogLevel::Debug;
+    std::atomic<size_t>         m_dropped = 0;
+    std::atomic<size_t>         m_written = 0;
+
+    std::string                 m_logFileName = "log.txt";
+    std::ofstream               m_logFile;
+    std::string                 m_batch;
+    int                         m_flushIntervalMS = 100;
+
+    std::thread                 m_writer;
+    std::mutex                  m_lock;
+    std::condition_variable     m_wake;
+    std::condition_variable     m_flushed;
+    bool                        m_running = true;
+    size_t                      m_flushRequested = 0;
+    size_t                      m_flushCompleted = 0;
+    bool                        m_truncateRequested = false;
+    bool                        m_reopenRequested = false;
+
+    Logger()
+        : m_cells(QueueCapacity)
+    {
+        for (size_t i = 0; i < QueueCapacity; i++)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_batch.reserve(QueueCapacity * 128);
+        m_writer = std::thread(&Logger::writerLoop, this);
+    }
+
+    ~Logger()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_running = false;
+        }
+        m_wake.notify_one();
+        if (m_writer.joinable()) { m_writer.join(); }
+    }
+
+    static long long now()
+    {
+        return std::chrono::time_point_cast<std::chrono::microseconds>(std::chrono::system_clock::now()).time_since_epoch().count();
+    }
+
+    static const char * levelName(LogLevel level)
+    {
+        switch (level)
+        {
+        case LogLevel::Debug:   return "DEBUG";
+        case LogLevel::Info:    return "INFO";
+        case LogLevel::Warning: return "WARNING";
+        case LogLevel::Error:   return "ERROR";
+        }
+        return "";
+    }
+
+    // Claims a slot in the ring buffer, returns nullptr if the writer has fallen a full queue behind
+    Cell * acquire()
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell & cell = m_cells[pos & (QueueCapacity - 1)];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { return &cell; }
+            }
+            else if (diff < 0)
+            {
+                return nullptr;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void publish(Cell * cell)
+    {
+        size_t pos = cell->sequence.load(std::memory_order_relaxed);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        // only wake the writer early if it is falling behind or something went wrong
+        size_t pending = m_enqueuePos.load(std::memory_order_relaxed) - m_written.load(std::memory_order_relaxed);
+        if (cell->record.level == LogLevel::Error || pending >= WakeThreshold)
+        {
+            m_wake.notify_one();
+        }
+    }
+
+    void enqueue(LogLevel level, bool raw, const char * format, va_list args, const char * suffix = nullptr)
+    {
+        if (level < m_minLevel.load(std::memory_order_relaxed)) { return; }
+
+        Cell * cell = acquire();
+        if (!cell)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Record & r = cell->record;
+        r.level = level;
+        r.raw = raw;
+        r.time = now();
+        int n = vsnprintf(r.text.data(), RecordTextSize, format, args);
+        r.length = (n < 0) ? 0 : std::min((size_t)n, RecordTextSize - 1);
+        if (suffix)
+        {
+            int s = snprintf(r.text.data() + r.length, RecordTextSize - r.length, "%s", suffix);
+            r.length = (s < 0) ? r.length : std::min(r.length + (size_t)s, RecordTextSize - 1);
+        }
+
+        publish(cell);
+    }
+
+    void enqueueString(LogLevel level, bool raw, const std::string & message)
+    {
+        // split long messages so nothing is lost, each piece is a separate record
+        size_t offset = 0;
+        do
+        {
+            std::string piece = message.substr(offset, RecordTextSize - 1);
+            enqueueFormatted(level, raw, "%s", piece.c_str());
+            offset += RecordTextSize - 1;
+            raw = true;
+        } while (offset < message.size());
+    }
+
+    void enqueueFormatted(LogLevel level, bool raw, const char * format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        enqueue(level, raw, format, args);
+        va_end(args);
+    }
+
+    // Drains every published record into one batch string, returns the number of records taken
+    size_t drain()
+    {
+        size_t count = 0;
+        while (true)
+        {
+            Cell & cell = m_cells[m_dequeuePos & (QueueCapacity - 1)];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            if ((intptr_t)seq - (intptr_t)(m_dequeuePos + 1) < 0) { break; }
+
+            const Record & r = cell.record;
+            if (!r.raw)
+            {
+                char prefix[64];
+                std::time_t seconds = (std::time_t)(r.time / 1000000);
+                std::tm tm;
+#ifdef _WIN32
+                localtime_s(&tm, &seconds);
+#else
+                localtime_r(&seconds, &tm);
+#endif
+                size_t len = std::strftime(prefix, sizeof(prefix), "[%Y-%m-%d %H:%M:%S", &tm);
+                snprintf(prefix + len, sizeof(prefix) - len, ".%03d][%s] ", (int)((r.time / 1000) % 1000), levelName(r.level));
+                m_batch += prefix;
+            }
+            m_batch.append(r.text.data(), r.length);
+            m_batch += '\n';
+
+            cell.sequence.store(m_dequeuePos + QueueCapacity, std::memory_order_release);
+            m_dequeuePos++;
+            count++;
+        }
 
-    std::string m_logFileName = "log.txt";
+        size_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+            m_batch += "[Logger] queue full, dropped " + std::to_string(dropped) + " messages\n";
+        }
+
+        return count;
+    }
+
+    void openFile(const std::string & fileName, bool truncate)
+    {
+        if (m_logFile.is_open()) { m_logFile.close(); }
+        m_logFile.open(fileName, truncate ? std::ios_base::trunc : std::ios_base::app);
+    }
+
+    void writerLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        while (true)
+        {
+            m_wake.wait_for(lock, std::chrono::milliseconds(m_flushIntervalMS));
+
+            bool running = m_running;
+            size_t flushTarget = m_flushRequested;
+            bool truncate = m_truncateRequested;
+            bool reopen = m_reopenRequested || truncate || !m_logFile.is_open();
+            std::string fileName = m_logFileName;
+            m_truncateRequested = false;
+            m_reopenRequested = false;
+
+            // the file is only touched by this thread, so the lock is not needed while writing
+            lock.unlock();
+
+            if (reopen) { openFile(fileName, truncate); }
+
+            size_t count = drain();
+            if (!m_batch.empty())
+            {
+                if (m_logFile.is_open())
+                {
+                    m_logFile.write(m_batch.data(), (std::streamsize)m_batch.size());
+                    m_logFile.flush();
+                }
+                m_batch.clear();
+            }
+            m_written.fetch_add(count, std::memory_order_relaxed);
+
+            lock.lock();
+            if (flushTarget > m_flushCompleted)
+            {
+                m_flushCompleted = flushTarget;
+                m_flushed.notify_all();
+            }
+
+            if (!running) { break; }
+        }
+    }
 
 public:
 
-    static Logger& Instance() 
+    static Logger& Instance()
     {
         static Logger instance;
         return instance;
@@ -29,59 +322,123 @@ public:
         Instance().appendToLog(message);
     }
 
+    static void Log(LogLevel level, const std::string& message)
+    {
+        Instance().enqueueString(level, false, message);
+    }
+
     static void Log(const char* format, ...)
     {
-        Instance().appendToLog(format);
+        va_list args;
+        va_start(args, format);
+        Instance().enqueue(LogLevel::Info, false, format, args);
+        va_end(args);
     }
 
-    void appendToLog(const std::string& message) 
+    static void Log(LogLevel level, const char* format, ...)
     {
-        std::ofstream logFile(m_logFileName, std::ios_base::app);
-        if (logFile.is_open()) { logFile << message << std::endl; }
+        va_list args;
+        va_start(args, format);
+        Instance().enqueue(level, false, format, args);
+        va_end(args);
     }
 
-    void appendToLog(const char* format, ...) 
+    static void LogLimited(LogRateLimit & limit, int intervalMS, LogLevel level, const char* format, ...)
     {
-        std::ofstream logFile(m_logFileName, std::ios_base::app);
-        if (logFile.is_open()) 
+        long long t = now();
+        long long next = limit.nextAllowed.load(std::memory_order_relaxed);
+        if (t < next || !limit.nextAllowed.compare_exchange_strong(next, t + (long long)intervalMS * 1000, std::memory_order_relaxed))
         {
-            va_list args;
-            va_start(args, format);
-            char buffer[1024];
-            vsnprintf(buffer, sizeof(buffer), format, args);
-            logFile << buffer << std::endl;
-            va_end(args);
+            limit.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
         }
+
+        char suffix[48] = "";
+        int suppressed = limit.suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed > 0) { snprintf(suffix, sizeof(suffix), " (suppressed %d)", suppressed); }
+
+        va_list args;
+        va_start(args, format);
+        Instance().enqueue(level, false, format, args, suffix);
+        va_end(args);
     }
 
-    void overwriteLog(const std::string& message) 
+    // Blocks until everything logged before this call is written to disk
+    static void Flush()
     {
-        std::ofstream logFile(m_logFileName, std::ios_base::trunc);
-        if (logFile.is_open()) 
-        {
-            logFile << message << std::endl;
-        }
+        Instance().flush();
     }
 
-    void overwriteLog(const char* format, ...) 
+    void appendToLog(const std::string& message)
     {
-        std::ofstream logFile(m_logFileName, std::ios_base::trunc);
-        if (logFile.is_open()) 
-        {
-            va_list args;
-            va_start(args, format);
-            char buffer[1024];
-            vsnprintf(buffer, sizeof(buffer), format, args);
-            logFile << buffer << std::endl;
-            va_end(args);
-        }
+        enqueueString(LogLevel::Info, false, message);
+    }
+
+    void appendToLog(const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        enqueue(LogLevel::Info, false, format, args);
+        va_end(args);
+    }
+
+    void overwriteLog(const std::string& message)
+    {
+        requestTruncate();
+        enqueueString(LogLevel::Info, false, message);
+    }
+
+    void overwriteLog(const char* format, ...)
+    {
+        requestTruncate();
+        va_list args;
+        va_start(args, format);
+        enqueue(LogLevel::Info, false, format, args);
+        va_end(args);
+    }
+
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (!m_running || std::this_thread::get_id() == m_writer.get_id()) { return; }
+        size_t target = ++m_flushRequested;
+        m_wake.notify_one();
+        m_flushed.wait(lock, [&]() { return m_flushCompleted >= target || !m_running; });
+    }
+
+    // Messages below this level are discarded on the calling thread
+    void setMinLevel(LogLevel level)
+    {
+        m_minLevel = level;
+    }
+
+    // How long the writer waits to batch up messages before writing them
+    void setFlushInterval(int milliseconds)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_flushIntervalMS = std::max(1, milliseconds);
     }
 
     // Set the log file name
-    void setLogFileName(const std::string& fileName) 
+    void setLogFileName(const std::string& fileName)
     {
+        flush();
+        std::lock_guard<std::mutex> lock(m_lock);
         m_logFileName = fileName;
+        m_reopenRequested = true;
     }
 
 private:
+
+    // messages queued before the truncate are written out first, then the file is cleared
+    // before anything logged after this call can reach the writer
+    void requestTruncate()
+    {
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_truncateRequested = true;
+        }
+        flush();
+    }
 };
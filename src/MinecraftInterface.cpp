@@ -18,9 +18,20 @@ MinecraftInterface::MinecraftInterface()
     m_profile = std::make_shared<MonochromeProfile>();
 }
 
+MinecraftInterface::~MinecraftInterface()
+{
+    m_sender->stop();
+}
+
 void MinecraftInterface::setup()
 {
-    m_handle.setOpt(curlpp::options::Port(9000));
+    m_handle.setOpt(curlpp::options::Port(m_port));
+
+    // the old sender finishes on its own, a server that stopped answering can't hold up the new one
+    SenderSettings settings;
+    settings.port = m_port;
+    if (m_sender) { m_sender->stop(); }
+    m_sender = MinecraftSender::start(settings);
 }
 
 void MinecraftInterface::command(const std::string & command, int x, int y, int z, Dimension dimension)
@@ -53,66 +64,30 @@ void MinecraftInterface::command(const std::string & command, int x, int y, int
 
 void MinecraftInterface::projectHeightmap(const cv::Mat & heightMap, int blockScale)
 {
-    int nextCubeId = (m_currentCube + 1) % 2;
-    m_profile->generate(m_cubes[nextCubeId], heightMap, blockScale);
-    
-    int wx = heightMap.cols;
-    int wz = heightMap.rows;
-    // Clear space
-    fill(m_x - 1, m_y - 1, m_z - 1, m_x + wx, m_y + blockScale, m_z + wz, "minecraft:spruce_planks", "outline");
-    fill(m_x, m_y, m_z, m_x + wx - 1, m_y + blockScale, m_z + wz - 1, "minecraft:air");
-
-    const Cube<uint8_t> & cube = m_cubes[nextCubeId];
-    BlockPlacer placer;
-    for (size_t x = 0; x < wx; ++x)
-    {
-        for (size_t y = 0; y < blockScale; ++y)
-        {
-            for (size_t z = 0; z < wz; ++z)
-            {
-                uint8_t block = cube.get(x, y, z);
-                if (block > 0 && block < m_profile->numberOfBlocks())
-                {
-                    placer.addBlock((int)x + m_x, (int)y + m_y, (int)z + m_z, m_profile->blockName(block));
-                }
-            }
-        }
-    }
-
-    m_currentCube = nextCubeId;
-    std::cout << "Sending Blocks" << std::endl;
-    placer.send(m_handle);
+    m_profile->generate(m_volume, heightMap, blockScale);
+    submit(true);
 }
 
 void MinecraftInterface::projectHeightmapChanges(const cv::Mat & heightMap, int blockScale)
 {
-    int nextCubeId = (m_currentCube + 1) % 2;
-    m_profile->generate(m_cubes[nextCubeId], heightMap, blockScale);
-
-    int wx = heightMap.cols;
-    int wz = heightMap.rows;
-
-    const Cube<uint8_t> & cube = m_cubes[nextCubeId];
-    const Cube<uint8_t> & pastCube = m_cubes[m_currentCube];
-    BlockPlacer placer;
-    for (size_t x = 0; x < wx; ++x)
-    {
-        for (size_t y = 0; y < blockScale; ++y)
-        {
-            for (size_t z = 0; z < wz; ++z)
-            {
-                uint8_t block = cube.get(x, y, z);
-                if (block != pastCube.get(x,y,z) && block < m_profile->numberOfBlocks())
-                {
-                    placer.addBlock((int)x + m_x, (int)y + m_y, (int)z + m_z, m_profile->blockName(block));
-                }
-            }
-        }
-    }
+    m_profile->generate(m_volume, heightMap, blockScale);
+    submit(false);
+}
 
-    m_currentCube = nextCubeId;
-    std::cout << "Sending Blocks" << std::endl;
-    placer.send(m_handle);
+void MinecraftInterface::submit(bool full)
+{
+    // the sender takes the volume and gives back an old one, so the next generate reuses its memory
+    MinecraftSender::Job job;
+    std::swap(job.volume, m_volume);
+    job.blockNames = m_profile->blockNames();
+    job.x = m_x;
+    job.y = m_y;
+    job.z = m_z;
+    job.full = full;
+    job.format = m_format;
+    job.compress = m_compress;
+    m_sender->submit(job);
+    std::swap(job.volume, m_volume);
 }
 
 inline void MinecraftInterface::fill(int x1, int y1, int z1, int x2, int y2, int z2, const std::string & block, const std::string & args)
@@ -131,10 +106,11 @@ void MinecraftInterface::imgui()
 {
     if (ImGui::Button("Test Connection"))
     {
-        command("say testing testing");
+        m_sender->sendCommands("say testing testing");
     }
 
     ImGui::Text("Size: %d, %d, %d", m_grid.cols, m_mcHeight, m_grid.rows);
+    ImGui::Text("Block Memory: %.1f MB", m_volume.memoryUsage() / (1024.0 * 1024.0));
     ImGui::SliderInt("Block Height", &m_mcHeight, 10, 100);
 
     if (ImGui::Button("Project Data"))
@@ -162,6 +138,32 @@ void MinecraftInterface::imgui()
         m_profile->imgui();
     }
 
+    const char * formats[] = { "Json Blocks", "Fill Commands", "Binary Columns" };
+    ImGui::Combo("Send As", (int *)&m_format, formats, IM_ARRAYSIZE(formats));
+    if (m_format == SendFormat::Binary)
+    {
+        ImGui::SameLine();
+        ImGui::Checkbox("LZ4", &m_compress);
+    }
+    ImGui::InputInt("Port", &m_port);
+    ImGui::SameLine();
+    if (ImGui::Button("Reconnect"))
+    {
+        setup();
+    }
+
+    const SenderStats stats = m_sender->stats();
+    ImGui::Text("Sent: %zu requests, %.1f MB, %zu failed", stats.requests, stats.bytes / (1024.0 * 1024.0), stats.failed);
+    if (stats.rawBytes > 0)
+    {
+        ImGui::Text("Binary before compression: %.1f MB", stats.rawBytes / (1024.0 * 1024.0));
+    }
+    ImGui::Text("Volumes: %zu submitted, %zu coalesced, %zu built", stats.submitted, stats.coalesced, stats.built);
+    ImGui::Text("Queue: %zu waiting, %zu most, builder waited %.0f ms", stats.queued, stats.maxQueued, stats.waitMS);
+    ImGui::Text("Last: %zu blocks as %zu records, build %.2f ms, request %.2f ms", stats.lastBlocks, stats.lastRecords, stats.lastBuildMS, stats.lastRequestMS);
+
+    benchmarkImgui();
+
     ImGui::Checkbox("Auto Update", &m_autoUpdate);
     ImGui::SliderInt("Update Delay", &m_updateDelay, 1, 60);
     if (m_autoUpdate && --m_countdown == 0)
@@ -176,68 +178,44 @@ void mc::MinecraftInterface::setGrid(const cv::Mat & grid)
     m_grid = grid;
 }
 
-MinecraftInterface::BlockPlacer::BlockPlacer()
+#else
+using namespace mc;
+MinecraftInterface::MinecraftInterface()
 {
-    m_blocks << "[";
+    m_profile = std::make_shared<MonochromeProfile>();
 }
 
-void MinecraftInterface::BlockPlacer::addBlock(int x, int y, int z, const std::string & name)
+MinecraftInterface::~MinecraftInterface()
 {
-    m_blocks << "{\"id\": \"" << name << "\", \"x\":" << x << ", \"y\": " << y << ", \"z\": " << z << "},";
+
 }
 
-void MinecraftInterface::BlockPlacer::addBlocks(int x1, int y1, int z1, int x2, int y2, int z2, const std::string & name)
+void MinecraftInterface::imgui()
 {
-    int xstep = (x2 - x1 >= 0) ? 1 : -1;
-    int ystep = (y2 - y1 >= 0) ? 1 : -1;
-    int zstep = (z2 - z1 >= 0) ? 1 : -1;
+    ImGui::Text("Minecraft connection not compiled, please define Use_Minecraft in MinecraftInterface.h");
+    benchmarkImgui();
+}
 
-    for (int x = x1; x <= x2; x += xstep)
-    {
-        for (int y = y1; y <= y2; y += ystep)
-        {
-            for (int z = z1; z <= z2; z += zstep)
-            {
-                addBlock(x, y, z, name);
-            }
-        }
-    }
-    
+void MinecraftInterface::setGrid(const cv::Mat& grid)
+{
+    m_grid = grid;
 }
+#endif
 
-void MinecraftInterface::BlockPlacer::send(curlpp::Easy & m_handle)
+void MinecraftInterface::benchmarkImgui()
 {
-    // remove last comma and close list
-    std::string total = m_blocks.str();
-    total.pop_back();
-    total.push_back(']');
-    curlpp::Cleanup clean;
-    try
+    if (ImGui::Button("Benchmark Generation"))
     {
-        m_handle.setOpt(curlpp::options::Url("http://localhost/blocks"));
-        std::list<std::string> header;
-        header.push_back("Content-Type: application/json");
-        m_handle.setOpt(curlpp::options::HttpHeader(header));
-        m_handle.setOpt(curlpp::options::CustomRequest("PUT"));
-        m_handle.setOpt(curlpp::options::PostFields(total));
-        m_handle.setOpt(curlpp::options::PostFieldSize((long)total.length()));
-        std::cout << m_handle << std::endl;
+        m_generationTimes = benchmarkGeneration(*m_profile, m_grid, m_mcHeight, 10);
+        std::cout << "Generation of " << m_generationTimes.voxels << " voxels: Cube " << m_generationTimes.denseMS << " ms ("
+                  << m_generationTimes.denseSingleMS << " ms on one thread), ColumnCube " << m_generationTimes.runsMS << " ms ("
+                  << m_generationTimes.runsSingleMS << " ms on one thread)" << std::endl;
     }
-    catch (curlpp::LibcurlRuntimeError e)
+
+    if (m_generationTimes.voxels > 0)
     {
-        std::cout << "Exception: " << e.what() << std::endl;
-        throw e;
+        const GenerationTimes & t = m_generationTimes;
+        ImGui::Text("Cube: %.2f ms, %.0f MVoxels/s (one thread %.2f ms)", t.denseMS, t.voxels / (t.denseMS * 1000.0), t.denseSingleMS);
+        ImGui::Text("ColumnCube: %.2f ms, %.0f MVoxels/s (one thread %.2f ms)", t.runsMS, t.voxels / (t.runsMS * 1000.0), t.runsSingleMS);
     }
-}
-
-#else
-using namespace mc;
-MinecraftInterface::MinecraftInterface(){}
-
-void MinecraftInterface::imgui()
-{
-    ImGui::Text("Minecraft connection not compiled, please define Use_Minecraft in MinecraftInterface.h");
-}
-
-void MinecraftInterface::setGrid(const cv::Mat& grid) {}
-#endif
\ No newline at end of file
+}
\ No newline at end of file
@@ -9,8 +9,9 @@
 #include <sstream>
 #include <opencv2/opencv.hpp>
 #include <SFML/Graphics.hpp>
-#include "Cube.hpp"
+#include "ColumnCube.hpp"
 #include "BlockGeneration.h"
+#include "MinecraftSender.h"
 
 namespace mc
 {
@@ -20,26 +21,19 @@ namespace mc
         curlpp::Easy m_handle;
         curlpp::Cleanup m_clean;
 
-        int m_mcHeight = 30;
-
-        class BlockPlacer
-        {
-            std::stringstream m_blocks;
-        public:
-
-            BlockPlacer();
+        std::shared_ptr<MinecraftSender> m_sender;  // requests go out from its threads so the render thread never waits
+        int m_port = 9000;
+        SendFormat m_format = SendFormat::Commands;
+        bool m_compress = true;             // LZ4 for the binary format
 
-            void addBlock(int x, int y, int z, const std::string & name);
-            void addBlocks(int x1, int y1, int z1, int x2, int y2, int z2, const std::string & name);
-            void send(curlpp::Easy & handle);
-        };
+        void submit(bool full);
 #endif // Use_Minecraft
         cv::Mat m_grid;
-        int m_currentCube = 0;
+        int m_mcHeight = 30;
         int m_x = 0;
         int m_y = 0;
         int m_z = 0;
-        Cube<uint8_t> m_cubes[2];
+        ColumnCube<uint8_t> m_volume;       // the volume being made, traded with the sender when it is submitted
 
         int m_countdown = 30;
         int m_updateDelay = 30;
@@ -47,6 +41,10 @@ namespace mc
 
         int m_currentProfile = 0;
         std::shared_ptr <GenerationProfile> m_profile;
+        GenerationTimes m_generationTimes;
+
+        // times the generation of the current grid, works without a connection
+        void benchmarkImgui();
 
     public:
 
@@ -58,6 +56,7 @@ namespace mc
         };
 
         MinecraftInterface();
+        ~MinecraftInterface();
 
         void setup();
 
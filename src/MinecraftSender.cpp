@@ -0,0 +1,370 @@
+#include "MinecraftInterface.h"
+
+#ifdef Use_Minecraft
+#include "MinecraftSender.h"
+
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <list>
+#include <sstream>
+#include <curlpp/Easy.hpp>
+#include <curlpp/cURLpp.hpp>
+#include <curlpp/Options.hpp>
+
+namespace
+{
+    // a fill command can't change more than this many blocks
+    constexpr size_t MaxFillVolume = 32768;
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+namespace mc
+{
+    MinecraftSender::MinecraftSender(const SenderSettings & settings)
+        : m_settings(settings)
+        , m_body(settings.chunkBytes + 1024)
+    {
+
+    }
+
+    std::shared_ptr<MinecraftSender> MinecraftSender::start(const SenderSettings & settings)
+    {
+        std::shared_ptr<MinecraftSender> sender(new MinecraftSender(settings));
+
+        // each thread keeps the sender alive, so stop() never has to wait for a request that hangs
+        std::thread([sender]() { sender->builderLoop(); }).detach();
+        std::thread([sender]() { sender->networkLoop(); }).detach();
+        return sender;
+    }
+
+    void MinecraftSender::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_running = false;
+        }
+        m_jobReady.notify_all();
+        m_requestReady.notify_all();
+        m_requestTaken.notify_all();
+    }
+
+    bool MinecraftSender::running()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        return m_running;
+    }
+
+    void MinecraftSender::submit(Job & job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stats.submitted++;
+
+            // a newer volume replaces one the builder has not started on, a full projection is never dropped for a diff
+            if (m_hasPending)
+            {
+                m_stats.coalesced++;
+                job.full = job.full || m_pending.full;
+            }
+            std::swap(m_pending, job);
+            m_hasPending = true;
+        }
+        m_jobReady.notify_one();
+    }
+
+    void MinecraftSender::sendCommands(const std::string & commands)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_requests.push_back({ SendFormat::Commands, commands });
+            m_stats.maxQueued = std::max(m_stats.maxQueued, m_requests.size());
+        }
+        m_requestReady.notify_one();
+    }
+
+    SenderStats MinecraftSender::stats()
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        SenderStats stats = m_stats;
+        stats.queued = m_requests.size();
+        return stats;
+    }
+
+    void MinecraftSender::builderLoop()
+    {
+        Job job;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_jobReady.wait(lock, [&]() { return !m_running || m_hasPending; });
+                if (!m_running) { return; }
+                std::swap(job, m_pending);
+                m_hasPending = false;
+
+                // diffing against blocks the server never received would leave them wrong for good
+                job.full = job.full || m_failed || (m_failedColumns && job.format != SendFormat::Binary);
+                if (m_failedColumns) { m_encoder.reset(); }
+                m_failed = false;
+                m_failedColumns = false;
+            }
+
+            build(job);
+        }
+    }
+
+    void MinecraftSender::build(Job & job)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        size_t blocks = 0;
+        m_records = 0;
+        m_body.clear();
+
+        const ColumnCube<uint8_t> & volume = job.volume;
+        auto validBlock = [&](uint8_t block) { return block < job.blockNames.size(); };
+
+        if (job.full)
+        {
+            // clear the space first, the outline marks where the sandbox is
+            const int wx = (int)volume.sizeX(), wy = (int)volume.sizeY(), wz = (int)volume.sizeZ();
+            m_bodyFormat = SendFormat::Commands;
+            m_body << "fill " << job.x - 1 << ' ' << job.y - 1 << ' ' << job.z - 1 << ' '
+                   << job.x + wx << ' ' << job.y + wy << ' ' << job.z + wz << " minecraft:spruce_planks outline";
+            endRecord();
+
+            // binary columns replace every block up to the top of the volume, only the layer above is left to clear
+            const int clearFrom = job.format == SendFormat::Binary ? job.y + wy : job.y;
+            splitBox({ job.x, clearFrom, job.z, job.x + wx - 1, job.y + wy, job.z + wz - 1, 0 }, MaxFillVolume, [&](const BlockBox & piece)
+            {
+                addCommand(piece, "minecraft:air");
+            });
+            flush();
+            m_encoder.reset();
+        }
+        m_bodyFormat = job.format;
+
+        // commands and json blocks change columns behind the encoder's back, a later binary volume has to send them all
+        if (job.format != SendFormat::Binary) { m_encoder.reset(); }
+
+        if (job.format == SendFormat::Binary)
+        {
+            m_encoder.encode(volume, job.blockNames, job.x, job.y, job.z, m_settings.chunkBytes, job.compress, [&](std::string & message)
+            {
+                Request request;
+                request.format = SendFormat::Binary;
+                request.body.swap(message);
+                queue(request);
+            });
+            std::swap(m_sent, job.volume);
+
+            const DeltaStats & delta = m_encoder.stats();
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stats.built++;
+            m_stats.rawBytes += delta.rawBytes;
+            m_stats.lastBlocks = delta.blocks;
+            m_stats.lastRecords = delta.columns;
+            m_stats.lastBuildMS = millisecondsSince(start);
+            return;
+        }
+
+        m_merger.clear();
+        auto addSpan = [&](size_t x, size_t y1, size_t y2, size_t z, uint8_t block)
+        {
+            blocks += y2 - y1;
+            if (job.format == SendFormat::Commands)
+            {
+                m_merger.add((int)x + job.x, (int)y1 + job.y, (int)y2 - 1 + job.y, (int)z + job.z, block);
+            }
+            else
+            {
+                for (size_t y = y1; y < y2; ++y)
+                {
+                    addBlock((int)x + job.x, (int)y + job.y, (int)z + job.z, job.blockNames[block]);
+                }
+            }
+        };
+
+        if (job.full)
+        {
+            // the space is all air now, so only the other blocks are sent
+            for (size_t z = 0; z < volume.sizeZ(); ++z)
+            {
+                for (size_t x = 0; x < volume.sizeX(); ++x)
+                {
+                    const ColumnCube<uint8_t>::Run * runs = volume.columnRuns(x, z);
+                    size_t y = 0;
+                    for (size_t r = 0; r < volume.runCount(x, z); ++r)
+                    {
+                        if (runs[r].value > 0 && validBlock(runs[r].value)) { addSpan(x, y, runs[r].top, z, runs[r].value); }
+                        y = runs[r].top;
+                    }
+                }
+            }
+        }
+        else
+        {
+            // only the spans of a column whose runs changed, everything is sent when the size changed
+            volume.forEachDifference(m_sent, [&](size_t x, size_t y1, size_t y2, size_t z, uint8_t block)
+            {
+                if (validBlock(block)) { addSpan(x, y1, y2, z, block); }
+            });
+        }
+
+        if (job.format == SendFormat::Commands)
+        {
+            for (const BlockBox & box : m_merger.finish())
+            {
+                splitBox(box, MaxFillVolume, [&](const BlockBox & piece) { addCommand(piece, job.blockNames[piece.block]); });
+            }
+        }
+        flush();
+
+        // the queued requests lead to this volume, the next one is diffed against it
+        std::swap(m_sent, job.volume);
+
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stats.built++;
+        m_stats.lastBlocks = blocks;
+        m_stats.lastRecords = m_records;
+        m_stats.lastBuildMS = millisecondsSince(start);
+    }
+
+    void MinecraftSender::addCommand(const BlockBox & box, const std::string & name)
+    {
+        if (box.volume() == 1)
+        {
+            m_body << "setblock " << box.x1 << ' ' << box.y1 << ' ' << box.z1 << ' ' << name;
+        }
+        else
+        {
+            m_body << "fill " << box.x1 << ' ' << box.y1 << ' ' << box.z1 << ' ' << box.x2 << ' ' << box.y2 << ' ' << box.z2 << ' ' << name;
+        }
+        endRecord();
+    }
+
+    void MinecraftSender::addBlock(int x, int y, int z, const std::string & name)
+    {
+        if (m_body.empty()) { m_body << '['; }
+        m_body << "{\"id\": \"" << name << "\", \"x\":" << x << ", \"y\": " << y << ", \"z\": " << z << "}";
+        endRecord();
+    }
+
+    void MinecraftSender::endRecord()
+    {
+        m_records++;
+        if (m_body.size() >= m_settings.chunkBytes)
+        {
+            flush();
+        }
+        else
+        {
+            // commands are one per line, json blocks are separated by commas
+            m_body << (m_bodyFormat == SendFormat::Commands ? '\n' : ',');
+        }
+    }
+
+    void MinecraftSender::flush()
+    {
+        if (m_body.empty()) { return; }
+
+        std::string & body = m_body.str();
+        if (body.back() == '\n' || body.back() == ',') { body.pop_back(); }
+        if (m_bodyFormat == SendFormat::Blocks) { body.push_back(']'); }
+
+        Request request;
+        request.format = m_bodyFormat;
+        request.body = body;
+        m_body.clear();
+        queue(request);
+    }
+
+    void MinecraftSender::queue(Request & request)
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        if (m_requests.size() >= m_settings.maxQueued)
+        {
+            // backpressure, the network is behind so the builder waits instead of piling up requests
+            const auto start = std::chrono::steady_clock::now();
+            m_requestTaken.wait(lock, [&]() { return !m_running || m_requests.size() < m_settings.maxQueued; });
+            m_stats.waitMS += millisecondsSince(start);
+        }
+        if (!m_running) { return; }
+
+        m_requests.push_back(std::move(request));
+        m_stats.maxQueued = std::max(m_stats.maxQueued, m_requests.size());
+        m_requestReady.notify_one();
+    }
+
+    void MinecraftSender::networkLoop()
+    {
+        // the handle belongs to this thread, curl handles can't be shared between threads
+        curlpp::Cleanup clean;
+        curlpp::Easy handle;
+        handle.setOpt(curlpp::options::Port(m_settings.port));
+        handle.setOpt(curlpp::options::FailOnError(true));     // a 4xx or 5xx answer throws like a dropped connection
+        handle.setOpt(curlpp::options::ConnectTimeout(m_settings.connectSeconds));
+        handle.setOpt(curlpp::options::Timeout(m_settings.requestSeconds));
+
+        // curl asks about once a second even when nothing arrives, a stopped sender aborts the request
+        handle.setOpt(curlpp::options::NoProgress(false));
+        handle.setOpt(curlpp::options::ProgressFunction([this](double, double, double, double) { return running() ? 0 : 1; }));
+
+        while (true)
+        {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_requestReady.wait(lock, [&]() { return !m_running || !m_requests.empty(); });
+                if (!m_running) { return; }
+                request = std::move(m_requests.front());
+                m_requests.pop_front();
+            }
+            m_requestTaken.notify_one();
+
+            const auto start = std::chrono::steady_clock::now();
+            bool sent = false;
+            try
+            {
+                std::ostringstream response;
+                std::list<std::string> header;
+                if (request.format == SendFormat::Commands)
+                {
+                    // the same query MinecraftInterface::command sends, the commands carry absolute coordinates
+                    handle.setOpt(curlpp::options::Url(std::format("http://{}/commands?x=0&y=0&z=0&dimension=overworld", m_settings.host)));
+                    handle.setOpt(curlpp::options::CustomRequest("POST"));
+                    header.push_back("Content-Type: text/plain; charset=UTF-8");
+                }
+                else
+                {
+                    handle.setOpt(curlpp::options::Url(std::format("http://{}/blocks", m_settings.host)));
+                    handle.setOpt(curlpp::options::CustomRequest("PUT"));
+                    header.push_back(request.format == SendFormat::Binary ? "Content-Type: application/octet-stream" : "Content-Type: application/json");
+                }
+                handle.setOpt(curlpp::options::HttpHeader(header));
+                handle.setOpt(curlpp::options::PostFields(request.body));
+                handle.setOpt(curlpp::options::PostFieldSize((long)request.body.size()));
+                handle.setOpt(curlpp::options::WriteStream(&response));
+                handle.perform();
+                sent = true;
+            }
+            catch (curlpp::RuntimeError & e)
+            {
+                std::cout << "Minecraft send failed: " << e.what() << std::endl;
+            }
+
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stats.requests++;
+            m_stats.failed += sent ? 0 : 1;
+            if (!sent && request.format == SendFormat::Binary) { m_failedColumns = true; }
+            else if (!sent) { m_failed = true; }
+            m_stats.bytes += sent ? request.body.size() : 0;
+            m_stats.lastRequestMS = millisecondsSince(start);
+        }
+    }
+}
+#endif // Use_Minecraft
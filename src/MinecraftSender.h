@@ -0,0 +1,145 @@
+#pragma once
+
+#include "BlockBoxes.h"
+#include "BlockDelta.h"
+#include "ColumnCube.hpp"
+#include "TextBuilder.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mc
+{
+    // What the sender has done so far, copied out for the UI
+    struct SenderStats
+    {
+        size_t  submitted = 0;              // volumes handed to submit
+        size_t  coalesced = 0;              // volumes replaced by a newer one before they were diffed
+        size_t  built = 0;                  // volumes diffed and queued
+        size_t  requests = 0;               // requests sent
+        size_t  failed = 0;                 // requests the server did not take
+        size_t  bytes = 0;
+        size_t  rawBytes = 0;               // binary bytes before compression
+        size_t  queued = 0;                 // requests waiting right now
+        size_t  maxQueued = 0;
+        double  waitMS = 0.0;               // time the builder waited for room in the queue
+        double  lastBuildMS = 0.0;          // diff and request bodies of the last volume
+        double  lastRequestMS = 0.0;
+        size_t  lastBlocks = 0;             // blocks changed by the last volume
+        size_t  lastRecords = 0;            // commands, json blocks or binary columns sent for them
+    };
+
+    // how blocks go over the wire
+    enum class SendFormat
+    {
+        Blocks,         // a json record per block to /blocks
+        Commands,       // fill commands for boxes of one block to /commands
+        Binary          // changed columns in the BlockDeltaEncoder format to /blocks
+    };
+
+    struct SenderSettings
+    {
+        std::string host = "localhost";
+        int         port = 9000;
+        size_t      chunkBytes = 256 * 1024;    // requests are cut at the first record past this size
+        size_t      maxQueued = 8;              // requests waiting before the builder has to wait
+        long        connectSeconds = 3;         // a server that is not there
+        long        requestSeconds = 30;        // a server that took the connection and never answers
+    };
+
+    // Sends block volumes to the Minecraft HTTP interface from two background threads
+    // submit() hands over the newest volume and returns at once. The builder thread diffs it against the volume
+    // it built last, turns the changes into fill commands (or json blocks) and cuts them into requests of about
+    // chunkBytes, the network thread posts those one after the other. In the binary format the encoder keeps
+    // its own record of the columns it sent and the diff is left to it.
+    // A volume that arrives while the builder is busy waits in a single slot and is replaced by any newer one,
+    // so only the latest diff goes out. The request queue is bounded, when the network falls behind the builder
+    // waits for room and the time it waits is counted.
+    // After a request fails the server no longer has what the diffs are taken against, the next volume is sent full,
+    // or with every column when only binary requests failed, they replace the whole column anyway.
+    // The threads share ownership of the sender, stop() returns at once and a request still on the wire
+    // is aborted, the last thread to finish frees the sender.
+    class MinecraftSender : public std::enable_shared_from_this<MinecraftSender>
+    {
+    public:
+
+        // a volume and where it goes
+        struct Job
+        {
+            ColumnCube<uint8_t>         volume;
+            std::vector<std::string>    blockNames;
+            int                         x = 0, y = 0, z = 0;
+            bool                        full = false;           // clear the space and send every block instead of a diff
+            SendFormat                  format = SendFormat::Commands;
+            bool                        compress = true;        // LZ4 for the binary format
+        };
+
+    private:
+
+        struct Request
+        {
+            SendFormat  format = SendFormat::Commands;
+            std::string body;
+        };
+
+        SenderSettings              m_settings;
+
+        std::mutex                  m_lock;
+        std::condition_variable     m_jobReady;
+        std::condition_variable     m_requestReady;
+        std::condition_variable     m_requestTaken;
+        bool                        m_running = true;
+
+        Job                         m_pending;              // the newest volume not yet taken by the builder
+        bool                        m_hasPending = false;
+        std::deque<Request>         m_requests;
+        bool                        m_failed = false;       // a request failed, the server is missing blocks m_sent has
+        bool                        m_failedColumns = false; // a binary request failed, the encoder thinks its columns were sent
+        SenderStats                 m_stats;
+
+        // builder thread only
+        ColumnCube<uint8_t>         m_sent;                 // the volume the queued requests lead to
+        BoxMerger                   m_merger;
+        TextBuilder                 m_body;
+        SendFormat                  m_bodyFormat = SendFormat::Commands;
+        BlockDeltaEncoder           m_encoder;
+        size_t                      m_records = 0;
+
+        MinecraftSender(const SenderSettings & settings);
+
+        bool running();
+        void builderLoop();
+        void networkLoop();
+
+        void build(Job & job);
+        void addCommand(const BlockBox & box, const std::string & name);
+        void addBlock(int x, int y, int z, const std::string & name);
+        void endRecord();
+        void flush();
+        void queue(Request & request);
+
+    public:
+
+        // a sender with its threads running
+        static std::shared_ptr<MinecraftSender> start(const SenderSettings & settings = SenderSettings());
+
+        MinecraftSender(const MinecraftSender &) = delete;
+        MinecraftSender & operator = (const MinecraftSender &) = delete;
+
+        // tells the threads to finish without waiting for them, nothing queued is sent any more
+        void stop();
+
+        // takes the job's volume and hands back a volume to reuse, the one a coalesced job held or an empty one
+        void submit(Job & job);
+
+        // commands, one per line, that go out after the requests already queued, never waits for room in the queue
+        void sendCommands(const std::string & commands);
+
+        SenderStats stats();
+    };
+}
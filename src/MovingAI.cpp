@@ -0,0 +1,150 @@
+#include "MovingAI.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+bool MovingAI::loadMap(const std::string & filename, Grid<uint8_t> & passable)
+{
+    std::ifstream fin(filename);
+    if (!fin.good())
+    {
+        std::cout << "Could not open map " << filename << std::endl;
+        return false;
+    }
+
+    // header: type, height, width, then the keyword map
+    size_t width = 0, height = 0;
+    std::string token;
+    while (fin >> token && token != "map")
+    {
+        if (token == "height") { fin >> height; }
+        if (token == "width")  { fin >> width; }
+        if (token == "type")   { fin >> token; }
+    }
+
+    if (width == 0 || height == 0)
+    {
+        std::cout << "Map " << filename << " has no size" << std::endl;
+        return false;
+    }
+
+    passable.refill(width, height, 0);
+    std::string row;
+    for (size_t y = 0; y < height; y++)
+    {
+        if (!(fin >> row) || row.size() < width)
+        {
+            std::cout << "Map " << filename << " ends at row " << y << std::endl;
+            return false;
+        }
+
+        for (size_t x = 0; x < width; x++)
+        {
+            char c = row[x];
+            passable.set(x, y, (c == '.' || c == 'G' || c == 'S') ? 1 : 0);
+        }
+    }
+    return true;
+}
+
+Grid<float> MovingAI::toHeights(const Grid<uint8_t> & passable)
+{
+    Grid<float> heights(passable.width(), passable.height(), 0.0f);
+    for (size_t i = 0; i < passable.width() * passable.height(); i++)
+    {
+        if (!passable.get(i)) { heights.set(i, -1.0f); }
+    }
+    return heights;
+}
+
+bool MovingAI::loadScenarios(const std::string & filename, std::vector<Scenario> & scenarios)
+{
+    std::ifstream fin(filename);
+    if (!fin.good()) { return false; }
+
+    std::string line;
+    while (std::getline(fin, line))
+    {
+        if (line.empty() || line.rfind("version", 0) == 0) { continue; }
+
+        // bucket, map, map width, map height, start x, start y, goal x, goal y, optimal length
+        std::stringstream ss(line);
+        Scenario scenario;
+        std::string map;
+        int mapWidth, mapHeight, sx, sy, gx, gy;
+        if (ss >> scenario.bucket >> map >> mapWidth >> mapHeight >> sx >> sy >> gx >> gy >> scenario.optimalLength)
+        {
+            scenario.start = State(sx, sy);
+            scenario.goal = State(gx, gy);
+            scenarios.push_back(scenario);
+        }
+    }
+    return true;
+}
+
+std::vector<Scenario> MovingAI::randomScenarios(const Grid<uint8_t> & passable, size_t count, unsigned int seed)
+{
+    const int width = (int)passable.width();
+    const int height = (int)passable.height();
+
+    // label the connected areas, diagonal steps can't cut corners so 4 neighbours decide what is connected
+    Grid<int> area(width, height, -1);
+    std::vector<State> open;
+    int areas = 0;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            if (!passable.get(x, y) || area.get(x, y) >= 0) { continue; }
+
+            area.set(x, y, areas);
+            open.push_back(State(x, y));
+            while (!open.empty())
+            {
+                State s = open.back();
+                open.pop_back();
+                for (const Action & action : Actions4())
+                {
+                    State n = s + action.dir;
+                    if (n.x < 0 || n.y < 0 || n.x >= width || n.y >= height) { continue; }
+                    if (!passable.get(n) || area.get(n) >= 0) { continue; }
+                    area.set(n, areas);
+                    open.push_back(n);
+                }
+            }
+            areas++;
+        }
+    }
+
+    std::vector<State> cells;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            if (passable.get(x, y)) { cells.push_back(State(x, y)); }
+        }
+    }
+
+    std::vector<Scenario> scenarios;
+    if (cells.empty()) { return scenarios; }
+
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> pick(0, cells.size() - 1);
+    for (size_t attempt = 0; scenarios.size() < count && attempt < count * 100; attempt++)
+    {
+        Scenario scenario;
+        scenario.start = cells[pick(rng)];
+        scenario.goal = cells[pick(rng)];
+        if (area.get(scenario.goal) != area.get(scenario.start) || scenario.goal == scenario.start) { continue; }
+
+        // buckets of 4 cells of straight line octile distance, the way the .scen files group their lines
+        State d = scenario.start.absdiff(scenario.goal);
+        double octile = std::max(d.x, d.y) + (std::sqrt(2.0) - 1.0) * std::min(d.x, d.y);
+        scenario.bucket = (int)(octile / 4.0);
+        scenarios.push_back(scenario);
+    }
+    return scenarios;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Action.hpp"
+#include "Grid.hpp"
+
+#include <string>
+#include <vector>
+
+// A start / goal pair, either from a MovingAI .scen file or generated
+struct Scenario
+{
+    int     bucket = 0;
+    State   start;
+    State   goal;
+    double  optimalLength = -1.0;       // octile length given by the scenario file, -1 when unknown
+};
+
+// Readers for the MovingAI grid benchmark formats, see https://movingai.com/benchmarks/formats.html
+namespace MovingAI
+{
+    // reads an octile .map, passable cells ('.', 'G', 'S') become 1 and everything else 0
+    bool loadMap(const std::string & filename, Grid<uint8_t> & passable);
+
+    // heights the search engines can plan over, passable cells are at 0 and blocked cells are below TraversalCosts::minHeight
+    Grid<float> toHeights(const Grid<uint8_t> & passable);
+
+    // reads a .scen file, the map named in each line is not checked
+    bool loadScenarios(const std::string & filename, std::vector<Scenario> & scenarios);
+
+    // count start / goal pairs in the same connected area, the same seed always gives the same pairs
+    std::vector<Scenario> randomScenarios(const Grid<uint8_t> & passable, size_t count, unsigned int seed);
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "IndexedHeap.hpp"
+#include "SearchNode.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Where a search keeps its nodes and its open list
+// Both stores give every cell of the grid one node, addressed by its index y * width + x,
+// and order the open list by lowest f and then lowest g. The engine only talks to them through cells.
+
+constexpr uint32_t NoParent = UINT32_MAX;
+
+// One Node object per cell and an open list of Node pointers
+// Every field of a node sits next to the others, so a node spans most of a cache line,
+// and the heap compares nodes by following pointers into the arena.
+class NodeArenaStore
+{
+    std::vector<Node>           m_nodes;
+    std::vector<Node *>         m_touched;          // nodes the last search wrote to
+    IndexedHeap<Node, MinFMinG> m_open;
+
+public:
+
+    void prepare(size_t cells)
+    {
+        m_open.clear();
+        if (m_nodes.size() != cells)
+        {
+            m_nodes = std::vector<Node>(cells);
+            m_touched.clear();
+            return;
+        }
+
+        // only what the previous search wrote to has to be cleaned
+        for (Node * node : m_touched)
+        {
+            node->parent = nullptr;
+            node->g = -1;
+            node->isValid = false;
+        }
+        m_touched.clear();
+    }
+
+    inline bool seen(uint32_t cell) const { return m_nodes[cell].isValid; }
+    inline bool isOpen(uint32_t cell) const { return m_open.contains(&m_nodes[cell]); }
+    inline int32_t g(uint32_t cell) const { return m_nodes[cell].g; }
+    inline bool empty() const { return m_open.empty(); }
+
+    inline uint32_t parent(uint32_t cell) const
+    {
+        const Node * p = m_nodes[cell].parent;
+        return p ? (uint32_t)(p - m_nodes.data()) : NoParent;
+    }
+
+    // puts a cell the search hasn't seen yet into the open list
+    void open(uint32_t cell, int32_t g, int32_t h, uint32_t parent)
+    {
+        Node * node = &m_nodes[cell];
+        node->isValid = true;
+        node->g = g;
+        node->h = h;
+        node->f = g + h;
+        node->parent = parent == NoParent ? nullptr : &m_nodes[parent];
+        m_touched.push_back(node);
+        m_open.push(node);
+    }
+
+    // a cheaper way to an open cell was found
+    void improve(uint32_t cell, int32_t g, uint32_t parent)
+    {
+        Node * node = &m_nodes[cell];
+        node->g = g;
+        node->f = g + node->h;
+        node->parent = &m_nodes[parent];
+        m_open.decreased(node);
+    }
+
+    uint32_t pop()
+    {
+        return (uint32_t)(m_open.pop() - m_nodes.data());
+    }
+
+    size_t memoryUsage() const
+    {
+        return m_nodes.capacity() * sizeof(Node) + m_touched.capacity() * sizeof(Node *) + m_open.capacity() * sizeof(Node *);
+    }
+};
+
+// Structure of arrays, one array per field the search reads together
+// Parents are 32 bit cell indices and g and h share 8 bytes. A cell belongs to the current search only
+// when its generation matches, so nothing is cleared between searches, only the counter goes up.
+// The open list holds the sort key next to the cell, f in the high and g in the low half of one integer,
+// so sifting compares keys in the heap array itself and never looks at the nodes.
+class CompactNodeStore
+{
+    struct Costs
+    {
+        int32_t g = 0;
+        int32_t h = 0;
+    };
+
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t cell;
+    };
+
+    std::vector<uint32_t>   m_generation;
+    std::vector<uint32_t>   m_parent;
+    std::vector<Costs>      m_costs;
+    std::vector<uint32_t>   m_heapIndex;        // index + 1 in the open list, 0 once taken out
+    std::vector<Entry>      m_heap;
+    uint32_t                m_current = 0;
+
+    static inline uint64_t key(int32_t g, int32_t h)
+    {
+        return ((uint64_t)(uint32_t)(g + h) << 32) | (uint32_t)g;
+    }
+
+    inline void place(const Entry & entry, size_t index)
+    {
+        m_heap[index] = entry;
+        m_heapIndex[entry.cell] = (uint32_t)index + 1;
+    }
+
+    void siftUp(size_t index)
+    {
+        Entry entry = m_heap[index];
+        while (index > 0)
+        {
+            size_t parent = (index - 1) / 2;
+            if (m_heap[parent].key <= entry.key) { break; }
+            place(m_heap[parent], index);
+            index = parent;
+        }
+        place(entry, index);
+    }
+
+    void siftDown(size_t index)
+    {
+        Entry entry = m_heap[index];
+        const size_t count = m_heap.size();
+        while (true)
+        {
+            size_t child = 2 * index + 1;
+            if (child >= count) { break; }
+            if (child + 1 < count && m_heap[child + 1].key < m_heap[child].key) { child++; }
+            if (entry.key <= m_heap[child].key) { break; }
+            place(m_heap[child], index);
+            index = child;
+        }
+        place(entry, index);
+    }
+
+public:
+
+    void prepare(size_t cells)
+    {
+        m_heap.clear();
+        if (m_generation.size() != cells)
+        {
+            m_generation.assign(cells, 0);
+            m_parent.resize(cells);
+            m_costs.resize(cells);
+            m_heapIndex.resize(cells);
+            m_current = 0;
+        }
+
+        // once in four billion searches the counter wraps and the old generations have to go
+        if (++m_current == 0)
+        {
+            std::fill(m_generation.begin(), m_generation.end(), 0);
+            m_current = 1;
+        }
+    }
+
+    inline bool seen(uint32_t cell) const { return m_generation[cell] == m_current; }
+    inline bool isOpen(uint32_t cell) const { return seen(cell) && m_heapIndex[cell] != 0; }
+    inline int32_t g(uint32_t cell) const { return seen(cell) ? m_costs[cell].g : -1; }
+    inline uint32_t parent(uint32_t cell) const { return seen(cell) ? m_parent[cell] : NoParent; }
+    inline bool empty() const { return m_heap.empty(); }
+
+    void open(uint32_t cell, int32_t g, int32_t h, uint32_t parent)
+    {
+        m_generation[cell] = m_current;
+        m_parent[cell] = parent;
+        m_costs[cell] = { g, h };
+        m_heap.push_back({ key(g, h), cell });
+        siftUp(m_heap.size() - 1);
+    }
+
+    void improve(uint32_t cell, int32_t g, uint32_t parent)
+    {
+        m_parent[cell] = parent;
+        m_costs[cell].g = g;
+        size_t index = m_heapIndex[cell] - 1;
+        m_heap[index].key = key(g, m_costs[cell].h);
+        siftUp(index);
+    }
+
+    uint32_t pop()
+    {
+        uint32_t cell = m_heap.front().cell;
+        m_heapIndex[cell] = 0;
+
+        Entry last = m_heap.back();
+        m_heap.pop_back();
+        if (!m_heap.empty())
+        {
+            m_heap[0] = last;
+            siftDown(0);
+        }
+        return cell;
+    }
+
+    size_t memoryUsage() const
+    {
+        return m_generation.capacity() * sizeof(uint32_t) + m_parent.capacity() * sizeof(uint32_t) + m_costs.capacity() * sizeof(Costs)
+             + m_heapIndex.capacity() * sizeof(uint32_t) + m_heap.capacity() * sizeof(Entry);
+    }
+};
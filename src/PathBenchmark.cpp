@@ -0,0 +1,111 @@
+#include "PathBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    // nearest rank percentile of sorted samples
+    double percentile(const std::vector<double> & sorted, double fraction)
+    {
+        if (sorted.empty()) { return 0.0; }
+        size_t rank = std::max((size_t)1, (size_t)std::ceil(fraction * sorted.size()));
+        return sorted[std::min(rank, sorted.size()) - 1];
+    }
+}
+
+PathBenchmark::PathBenchmark(const std::vector<Scenario> & scenarios)
+    : m_scenarios(scenarios)
+{
+
+}
+
+const BenchmarkResult & PathBenchmark::run(const std::string & name, const SearchFunction & search, const std::function<size_t()> & memory)
+{
+    BenchmarkResult result;
+    result.name = name;
+    result.queries = m_scenarios.size();
+
+    std::vector<double> latencies;
+    latencies.reserve(m_scenarios.size());
+
+    const BenchmarkResult * reference = m_results.empty() ? nullptr : &m_results.front();
+    result.costs.reserve(m_scenarios.size());
+    size_t stretched = 0;
+
+    for (size_t i = 0; i < m_scenarios.size(); i++)
+    {
+        const Scenario & scenario = m_scenarios[i];
+        SearchStats stats;
+        auto start = std::chrono::steady_clock::now();
+        bool found = search(scenario, stats);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        latencies.push_back(seconds * 1e6);
+        result.seconds += seconds;
+        result.expanded += stats.expanded;
+        result.costs.push_back(found ? stats.cost : -1);
+        if (found) { result.solved++; }
+
+        if (reference)
+        {
+            const int32_t expected = reference->costs[i];
+            if (expected >= 0 && !found) { result.missed++; }
+            if (result.costs.back() != expected) { result.lengthMismatches++; }
+            if (found && expected > 0)
+            {
+                const double stretch = (double)stats.cost / expected;
+                result.meanStretch += stretch;
+                result.maxStretch = std::max(result.maxStretch, stretch);
+                stretched++;
+            }
+        }
+        // the engines use 100 / 141 for the step costs, the scenario files use 1 / sqrt(2)
+        else if (found && scenario.optimalLength >= 0.0 && std::abs(stats.cost / 100.0 - scenario.optimalLength) > 0.01 * scenario.optimalLength + 0.01)
+        {
+            result.lengthMismatches++;
+        }
+    }
+
+    result.meanStretch = stretched > 0 ? result.meanStretch / stretched : 1.0;
+    result.maxStretch = stretched > 0 ? result.maxStretch : 1.0;
+
+    std::sort(latencies.begin(), latencies.end());
+    result.p50 = percentile(latencies, 0.50);
+    result.p90 = percentile(latencies, 0.90);
+    result.p99 = percentile(latencies, 0.99);
+    result.max = latencies.empty() ? 0.0 : latencies.back();
+    result.memory = memory();
+
+    m_results.push_back(result);
+    return m_results.back();
+}
+
+const BenchmarkResult & PathBenchmark::runHierarchical(const std::string & name, HierarchicalPathfinder & pathfinder)
+{
+    std::vector<State> path;
+    return run(name, [&](const Scenario & scenario, SearchStats & stats)
+    {
+        bool found = pathfinder.search(scenario.start, scenario.goal, path);
+        stats = pathfinder.stats();
+        return found;
+    },
+    [&]() { return pathfinder.memoryUsage(); });
+}
+
+void PathBenchmark::print(std::ostream & out) const
+{
+    char line[256];
+    snprintf(line, sizeof(line), "%-24s %8s %8s %8s %8s %8s %8s %12s %10s %10s %10s %10s %10s %10s\n",
+        "Engine", "Queries", "Solved", "Missed", "Wrong", "Stretch", "Max", "Mexp/s", "Queries/s", "p50 us", "p90 us", "p99 us", "max us", "Mem KB");
+    out << line;
+
+    for (auto & r : m_results)
+    {
+        snprintf(line, sizeof(line), "%-24s %8zu %8zu %8zu %8zu %8.3f %8.2f %12.2f %10.0f %10.1f %10.1f %10.1f %10.1f %10zu\n",
+            r.name.c_str(), r.queries, r.solved, r.missed, r.lengthMismatches, r.meanStretch, r.maxStretch, r.expandedPerSecond() / 1e6, r.queriesPerSecond(), r.p50, r.p90, r.p99, r.max, r.memory / 1024);
+        out << line;
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "AStar.h"
+#include "HierarchicalPathfinder.h"
+#include "MovingAI.h"
+#include "RegionMap.h"
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct BenchmarkResult
+{
+    std::string name;
+    size_t      queries = 0;
+    size_t      solved = 0;
+    size_t      missed = 0;                 // queries the reference solved and this engine did not
+    size_t      lengthMismatches = 0;       // queries whose solved flag or cost differs from the reference
+    double      meanStretch = 0.0;          // cost over the reference cost, for queries both solved
+    double      maxStretch = 0.0;
+    size_t      expanded = 0;
+    double      seconds = 0.0;
+    double      p50 = 0.0;                  // query latency percentiles in microseconds
+    double      p90 = 0.0;
+    double      p99 = 0.0;
+    double      max = 0.0;
+    size_t      memory = 0;                 // bytes one search keeps allocated
+    std::vector<int32_t> costs;             // per scenario, -1 when no path was found
+
+    inline double expandedPerSecond() const { return seconds > 0.0 ? expanded / seconds : 0.0; }
+    inline double queriesPerSecond() const { return seconds > 0.0 ? queries / seconds : 0.0; }
+};
+
+// Runs a list of scenarios through search engines and compares them
+// Every query is timed on its own so the latency distribution can be reported next to the throughput.
+// This is the regression harness for the pathfinding code, every engine is run on the same scenarios.
+// The first engine run is the reference, it should be A*: every later engine is compared to it query by query,
+// the reference itself is compared to the optimal lengths of the scenario file when there is one.
+class PathBenchmark
+{
+public:
+
+    // solves one scenario, returns whether a path was found and fills the stats of the search
+    typedef std::function<bool(const Scenario & scenario, SearchStats & stats)> SearchFunction;
+
+private:
+
+    std::vector<Scenario>           m_scenarios;
+    std::vector<BenchmarkResult>    m_results;
+
+public:
+
+    PathBenchmark(const std::vector<Scenario> & scenarios);
+
+    // runs every scenario through search, memory is asked for once all of them are done
+    const BenchmarkResult & run(const std::string & name, const SearchFunction & search, const std::function<size_t()> & memory);
+
+    // A* in the given mode and with the given heuristic weight over heights, Engine picks the node layout
+    // with regions, queries between two regions are turned down without searching
+    template <class Engine = AStar>
+    const BenchmarkResult & runAStar(const std::string & name, const Grid<float> & heights, const TraversalCosts & costs,
+                                     SearchMode mode = SearchMode::AStar, float weight = 1.0f, const RegionMap * regions = nullptr)
+    {
+        Engine astar(true, mode);
+        astar.setWeight(weight);
+        std::vector<State> path;
+        return run(name, [&](const Scenario & scenario, SearchStats & stats)
+        {
+            if (regions && !regions->connected(scenario.start, scenario.goal))
+            {
+                stats = SearchStats();
+                return false;
+            }
+            bool found = astar.search(heights, scenario.start, scenario.goal, costs, path);
+            stats = astar.stats();
+            return found;
+        },
+        [&]() { return astar.memoryUsage() + (regions ? regions->memoryUsage() : 0); });
+    }
+
+    // queries through a graph that update() was already called on, every path is refined to cells
+    const BenchmarkResult & runHierarchical(const std::string & name, HierarchicalPathfinder & pathfinder);
+
+    inline const std::vector<BenchmarkResult> & results() const { return m_results; }
+
+    void print(std::ostream & out) const;
+};
@@ -34,6 +34,18 @@ void Processor_Colorizer::render(sf::RenderWindow & window)
 {
     PROFILE_FUNCTION();
 
+    // processTopography can run on a worker thread, so the texture upload happens here on the render thread
+    if (m_imageUpdated)
+    {
+        PROFILE_SCOPE("SFML Texture Update");
+        if (Tools::updateTexture(m_sfTransformedDepthTexture, m_transformedDepthRGBA, m_changedRegions))
+        {
+            m_sfTransformedDepthSprite.setTexture(m_sfTransformedDepthTexture, true);
+        }
+        m_changedRegions.clear();
+        m_imageUpdated = false;
+    }
+
     {
         PROFILE_SCOPE("Draw Transformed Image");
 
@@ -78,29 +90,31 @@ void Processor_Colorizer::load(const Save & save)
 }
 
 void Processor_Colorizer::processTopography(const cv::Mat & data)
+{
+    processFrame(std::make_shared<const TopographyFrame>(data));
+}
+
+void Processor_Colorizer::processFrame(const TopographyFrame::Ptr & frame)
 {
     PROFILE_FUNCTION();
-    {
-        PROFILE_SCOPE("Calibration TransformProjection");
-        m_projector.project(data, m_cvTransformedDepthImage32f);
-    }
 
-    // Draw warped depth image
-    int dw = m_cvTransformedDepthImage32f.cols;
-    int dh = m_cvTransformedDepthImage32f.rows;
+    // the projected image is cached on the frame, so another processor with the same projection gets it for free,
+    // and only the regions that changed since the previous frame are reported
+    std::vector<cv::Rect> changed;
+    const cv::Mat & rgba = m_projector.projectRGBA(*frame, &changed);
 
     // if something went wrong above, quit the function
-    if (dw == 0 || dh == 0) { return; }
+    if (rgba.cols == 0 || rgba.rows == 0) { return; }
+
+    // the changes are relative to the previous frame, if we did not see that one the whole texture is stale
+    if (frame->previousID() != m_lastFrameID)
     {
-        {
-            PROFILE_SCOPE("Transformed Image SFML Image");
-            m_sfTransformedDepthImage = Tools::matToSfImage(m_cvTransformedDepthImage32f);
-
-            {
-                PROFILE_SCOPE("SFML Texture From Image");
-                m_sfTransformedDepthTexture.loadFromImage(m_sfTransformedDepthImage);
-                m_sfTransformedDepthSprite.setTexture(m_sfTransformedDepthTexture, true);
-            }
-        }
+        changed = { cv::Rect(0, 0, rgba.cols, rgba.rows) };
     }
+
+    m_frame = frame;
+    m_lastFrameID = frame->id();
+    m_transformedDepthRGBA = rgba;
+    m_changedRegions.insert(m_changedRegions.end(), changed.begin(), changed.end());
+    m_imageUpdated = m_imageUpdated || !changed.empty();
 }
@@ -8,10 +8,13 @@
 class Processor_Colorizer : public TopographyProcessor 
 {
     SandBoxProjector    m_projector;
-    cv::Mat             m_cvTransformedDepthImage32f;
-    sf::Image           m_sfTransformedDepthImage;
+    TopographyFrame::Ptr m_frame;                       // kept so the next frame can reuse its projection
+    cv::Mat             m_transformedDepthRGBA;
+    std::vector<cv::Rect> m_changedRegions;             // parts of the texture that are out of date
+    size_t              m_lastFrameID = SIZE_MAX;
     sf::Texture         m_sfTransformedDepthTexture;
     sf::Sprite          m_sfTransformedDepthSprite;
+    bool                m_imageUpdated = false;
     sf::Shader          m_shader;
     int                 m_selectedShaderIndex = 0;
     bool                m_drawContours = true;
@@ -26,4 +29,5 @@ public:
     void load(const Save & save);
 
     void processTopography(const cv::Mat & data);
+    void processFrame(const TopographyFrame::Ptr & frame);
 };
\ No newline at end of file
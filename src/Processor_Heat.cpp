@@ -24,6 +24,7 @@ void Processor_Heat::setInitialHeatSources()
     m_heatGrid.addSource(HeatSource(cv::Rect(300, 100, 10, 10), -100.0f));
     m_heatGrid.addSource(HeatSource(cv::Rect(300, 200, 10, 10), 100.0f));
     m_heatGrid.addSource(HeatSource(cv::Rect(100, 200, 10, 10), 100.0f));
+    m_heatChanged = true;
 }
 
 void Processor_Heat::imgui()
@@ -44,6 +45,7 @@ void Processor_Heat::imgui()
     {
         m_iterations = 0;
         m_heatGrid.reset();
+        m_heatChanged = true;
     }
     
     std::vector<std::string> sourceStrings; 
@@ -66,6 +68,7 @@ void Processor_Heat::imgui()
     if (ImGui::Button("Clear Sources"))
     {
         m_heatGrid.clearSources();
+        m_heatChanged = true;
     }
 
     ImGui::Separator();
@@ -87,6 +90,24 @@ void Processor_Heat::imgui()
 void Processor_Heat::render(sf::RenderWindow& window)
 {
     PROFILE_FUNCTION();
+
+    // processTopography can run on a worker thread, so the texture uploads happen here on the render thread
+    if (m_imagesUpdated)
+    {
+        PROFILE_SCOPE("SFML Texture From Image");
+        if (Tools::updateTexture(m_sfTransformedDepthTextureColor, m_transformedDepthRGBAColor, m_changedRegionsColor))
+        {
+            m_sfTransformedDepthSpriteColor.setTexture(m_sfTransformedDepthTextureColor, true);
+        }
+        m_changedRegionsColor.clear();
+        if (m_heatImageUpdated)
+        {
+            m_sfTransformedDepthTextureHeat.loadFromImage(m_sfTransformedDepthImageHeat);
+            m_sfTransformedDepthSpriteHeat.setTexture(m_sfTransformedDepthTextureHeat, true);
+            m_heatImageUpdated = false;
+        }
+        m_imagesUpdated = false;
+    }
     if (m_drawProjection)
     {
         PROFILE_SCOPE("Draw Transformed Image");
@@ -145,6 +166,7 @@ void Processor_Heat::processEvent(const sf::Event& event, const sf::Vector2f& mo
             m_heatGrid.getSources()[m_selectedSource].m_area.x += (int)diff.x;
             m_heatGrid.getSources()[m_selectedSource].m_area.y += (int)diff.y;
             m_heatGrid.updateSources();
+            m_heatChanged = true;
         }
     }
 
@@ -164,42 +186,58 @@ void Processor_Heat::load(const Save& save)
     m_numberOfContourLines = save.numberOfContourLines;
     m_drawProjection = save.drawProjection;
     m_projector.load(save);
+    m_heatChanged = true;
 }
 
 void Processor_Heat::processTopography(const cv::Mat& data)
+{
+    processFrame(std::make_shared<const TopographyFrame>(data));
+}
+
+// the simulation moves on every frame it runs iterations, even when the sand is still
+bool Processor_Heat::isAnimating() const
+{
+    return m_iterations > 0 || m_doStep;
+}
+
+void Processor_Heat::processFrame(const TopographyFrame::Ptr& frame)
 {
     PROFILE_FUNCTION();
 
+    const cv::Mat& data = frame->topography();
+
     {
         PROFILE_SCOPE("Color");
 
-        {
-            PROFILE_SCOPE("Calibration TransformProjection");
-            m_projector.project(data, m_cvTransformedDepthImage32fColor);
-        }
-
-        // Draw warped depth image
-        int dw = m_cvTransformedDepthImage32fColor.cols;
-        int dh = m_cvTransformedDepthImage32fColor.rows;
+        // the projected image is cached on the frame and shared with any other processor using the same projection
+        std::vector<cv::Rect> changed;
+        const cv::Mat& rgba = m_projector.projectRGBA(*frame, &changed);
 
         // if something went wrong above, quit the function
-        if (m_drawProjection && dw == 0 || dh == 0) { return; }
+        if (m_drawProjection && rgba.cols == 0 || rgba.rows == 0) { return; }
+
+        // the changes are relative to the previous frame, if we did not see that one the whole texture is stale
+        if (frame->previousID() != m_lastFrameID)
         {
-            {
-                PROFILE_SCOPE("Transformed Image SFML Image");
-                m_sfTransformedDepthImageColor = Tools::matToSfImage(m_cvTransformedDepthImage32fColor);
-
-                {
-                    PROFILE_SCOPE("SFML Texture From Image");
-                    m_sfTransformedDepthTextureColor.loadFromImage(m_sfTransformedDepthImageColor);
-                    m_sfTransformedDepthSpriteColor.setTexture(m_sfTransformedDepthTextureColor, true);
-                }
-            }
+            changed = { cv::Rect(0, 0, rgba.cols, rgba.rows) };
         }
+
+        m_frame = frame;
+        m_lastFrameID = frame->id();
+        m_transformedDepthRGBAColor = rgba;
+        m_changedRegionsColor.insert(m_changedRegionsColor.end(), changed.begin(), changed.end());
+        m_imagesUpdated = true;
+    }
+
+    // without iterations the heat only changes when the sources or the projection do, so there is nothing to redo
+    if (m_iterations == 0 && !m_doStep && !m_heatChanged && m_heatProjectionVersion == m_projector.getVersion())
+    {
+        return;
     }
 
     {
         PROFILE_SCOPE("Heat");
+        m_heatChanged = false;
         m_heatGrid.update(data, m_iterations);
 
         if (m_doStep)
@@ -211,6 +249,7 @@ void Processor_Heat::processTopography(const cv::Mat& data)
         {
             PROFILE_SCOPE("Calibration TransformProjection");
             m_projector.project(m_heatGrid.normalizedData(), m_cvTransformedDepthImage32fHeat);
+            m_heatProjectionVersion = m_projector.getVersion();
         }
 
         // Draw warped depth image
@@ -220,16 +259,10 @@ void Processor_Heat::processTopography(const cv::Mat& data)
         // if something went wrong above, quit the function
         if (m_drawProjection && dw == 0 || dh == 0) { return; }
         {
-            {
-                PROFILE_SCOPE("Transformed Image SFML Image");
-                m_sfTransformedDepthImageHeat = Tools::matToSfImage(m_cvTransformedDepthImage32fHeat);
-
-                {
-                    PROFILE_SCOPE("SFML Texture From Image");
-                    m_sfTransformedDepthTextureHeat.loadFromImage(m_sfTransformedDepthImageHeat);
-                    m_sfTransformedDepthSpriteHeat.setTexture(m_sfTransformedDepthTextureHeat, true);
-                }
-            }
+            PROFILE_SCOPE("Transformed Image SFML Image");
+            m_sfTransformedDepthImageHeat = Tools::matToSfImage(m_cvTransformedDepthImage32fHeat);
+            m_heatImageUpdated = true;
+            m_imagesUpdated = true;
         }
     }
 }
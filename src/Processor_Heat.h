@@ -13,8 +13,10 @@ class Processor_Heat : public TopographyProcessor
     SandBoxProjector m_projector;
     bool        m_drawProjection = true;
 
-    cv::Mat     m_cvTransformedDepthImage32fColor;
-    sf::Image   m_sfTransformedDepthImageColor;
+    TopographyFrame::Ptr m_frame;       // kept so the next frame can reuse its projection
+    cv::Mat     m_transformedDepthRGBAColor;
+    std::vector<cv::Rect> m_changedRegionsColor;
+    size_t      m_lastFrameID = SIZE_MAX;
     sf::Texture m_sfTransformedDepthTextureColor;
     sf::Sprite  m_sfTransformedDepthSpriteColor;
     sf::Shader  m_shader_color;
@@ -24,6 +26,10 @@ class Processor_Heat : public TopographyProcessor
     sf::Texture m_sfTransformedDepthTextureHeat;
     sf::Sprite  m_sfTransformedDepthSpriteHeat;
     sf::Shader  m_shader_heat;
+    bool        m_imagesUpdated = false;
+    bool        m_heatChanged = true;           // the heat image has to be rebuilt even without iterations
+    bool        m_heatImageUpdated = false;
+    size_t      m_heatProjectionVersion = SIZE_MAX;
 
     bool        m_drawContours = false;
     int         m_numberOfContourLines = 19;
@@ -48,4 +54,6 @@ public:
     void load(const Save& save);
 
     void processTopography(const cv::Mat& data);
+    bool isAnimating() const;
+    void processFrame(const TopographyFrame::Ptr& frame);
 };
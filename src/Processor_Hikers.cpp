@@ -0,0 +1,274 @@
+#include "Processor_Hikers.h"
+#include "Profiler.hpp"
+#include "Timer.hpp"
+#include "Tools.h"
+
+#include "imgui.h"
+#include "imgui-SFML.h"
+
+namespace {
+    const std::string shaderPathColor = "shaders/shader_contour_color.frag";
+}
+
+void Processor_Hikers::init()
+{
+    m_shader_color.loadFromFile(shaderPathColor, sf::Shader::Fragment);
+}
+
+void Processor_Hikers::imgui()
+{
+    PROFILE_FUNCTION();
+
+    ImGui::SliderInt("Hikers", &m_hikerCount, 0, 64);
+    ImGui::SliderInt("Speed", &m_speed, 1, 8);
+    ImGui::SliderFloat("Heuristic Weight", &m_weight, 1.0f, 5.0f);
+    ImGui::SliderFloat("Water Level", &m_costs.minHeight, 0.0f, 1.0f);
+    ImGui::SliderFloat("Max Step", &m_costs.maxStep, 0.001f, 0.2f, "%.3f");
+    ImGui::SliderFloat("Slope Penalty", &m_costs.slopePenalty, 0.0f, 20000.0f, "%.0f");
+    ImGui::Text("Planned %zu paths in %.2f ms, %zu regions", m_planned, m_planMS, m_regions.regionCount());
+
+    if (ImGui::Button("Scatter"))
+    {
+        m_hikers.clear();
+    }
+
+    ImGui::Separator();
+    m_projector.imgui();
+
+    if (ImGui::Button("Reload Shader"))
+    {
+        m_shader_color.loadFromFile(shaderPathColor, sf::Shader::Fragment);
+    }
+
+    ImGui::Checkbox("##Contours", &m_drawContours);
+    ImGui::SameLine();
+    ImGui::SliderInt("Contour Lines", &m_numberOfContourLines, 0, 19);
+}
+
+void Processor_Hikers::render(sf::RenderWindow& window)
+{
+    PROFILE_FUNCTION();
+
+    // processTopography can run on a worker thread, so the texture uploads happen here on the render thread
+    if (m_imagesUpdated)
+    {
+        PROFILE_SCOPE("SFML Texture From Image");
+        if (Tools::updateTexture(m_sfTransformedDepthTextureColor, m_transformedDepthRGBAColor, m_changedRegionsColor))
+        {
+            m_sfTransformedDepthSpriteColor.setTexture(m_sfTransformedDepthTextureColor, true);
+        }
+        m_changedRegionsColor.clear();
+        if (m_trailsImageUpdated)
+        {
+            m_sfTransformedTextureTrails.loadFromImage(m_sfTransformedImageTrails);
+            m_sfTransformedSpriteTrails.setTexture(m_sfTransformedTextureTrails, true);
+            m_trailsImageUpdated = false;
+        }
+        m_imagesUpdated = false;
+    }
+    if (m_drawProjection)
+    {
+        PROFILE_SCOPE("Draw Transformed Image");
+
+        float scale = m_projector.getTransformedScale();
+
+        // the sand underneath in the terrain colors
+        m_sfTransformedDepthSpriteColor.setPosition(m_projector.getTransformedPosition());
+        m_sfTransformedDepthSpriteColor.setScale(scale, scale);
+
+        static sf::Clock time;
+        m_shader_color.setUniform("shaderIndex", 3);
+        m_shader_color.setUniform("contour", m_drawContours);
+        m_shader_color.setUniform("numberOfContourLines", m_numberOfContourLines);
+        m_shader_color.setUniform("u_time", time.getElapsedTime().asSeconds());
+        window.draw(m_sfTransformedDepthSpriteColor, &m_shader_color);
+
+        // the trails are black where there is nothing, so adding them leaves the sand as it is
+        m_sfTransformedSpriteTrails.setPosition(m_projector.getTransformedPosition());
+        m_sfTransformedSpriteTrails.setScale(scale, scale);
+        window.draw(m_sfTransformedSpriteTrails, sf::BlendAdd);
+    }
+
+    m_projector.render(window);
+}
+
+void Processor_Hikers::processEvent(const sf::Event& event, const sf::Vector2f& mouse)
+{
+    PROFILE_FUNCTION();
+
+    m_projector.processEvent(event, mouse);
+}
+
+void Processor_Hikers::save(Save& save) const
+{
+    save.drawContours = m_drawContours;
+    save.numberOfContourLines = m_numberOfContourLines;
+    save.drawProjection = m_drawProjection;
+    save.hikerCount = m_hikerCount;
+    save.hikerSpeed = m_speed;
+    save.hikerWeight = m_weight;
+    save.hikerWaterLevel = m_costs.minHeight;
+    save.hikerMaxStep = m_costs.maxStep;
+    save.hikerSlopePenalty = m_costs.slopePenalty;
+    m_projector.save(save);
+}
+
+void Processor_Hikers::load(const Save& save)
+{
+    m_drawContours = save.drawContours;
+    m_numberOfContourLines = save.numberOfContourLines;
+    m_drawProjection = save.drawProjection;
+    m_hikerCount = save.hikerCount;
+    m_speed = save.hikerSpeed;
+    m_weight = save.hikerWeight;
+    m_costs.minHeight = save.hikerWaterLevel;
+    m_costs.maxStep = save.hikerMaxStep;
+    m_costs.slopePenalty = save.hikerSlopePenalty;
+    m_projector.load(save);
+}
+
+void Processor_Hikers::processTopography(const cv::Mat& data)
+{
+    processFrame(std::make_shared<const TopographyFrame>(data));
+}
+
+// the hikers walk on every frame, even when the sand is still
+bool Processor_Hikers::isAnimating() const
+{
+    return m_hikerCount > 0;
+}
+
+bool Processor_Hikers::randomCell(int32_t region, State & cell)
+{
+    if (m_heights.width() == 0 || m_heights.height() == 0) { return false; }
+
+    // most of the sand is usually dry, a few tries find a cell without keeping a list of them
+    for (int attempt = 0; attempt < 64; attempt++)
+    {
+        State s((int)(m_rng() % m_heights.width()), (int)(m_rng() % m_heights.height()));
+        int32_t label = m_regions.label(s);
+        if (label >= 0 && (region < 0 || label == region))
+        {
+            cell = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Processor_Hikers::planHikers()
+{
+    PROFILE_FUNCTION();
+
+    m_astar.setWeight(m_weight);
+    m_hikers.resize(m_hikerCount);
+    m_planned = 0;
+    for (auto & hiker : m_hikers)
+    {
+        // new hikers and ones the water rose over start again somewhere dry
+        int32_t region = m_regions.label(hiker.position);
+        if (region < 0)
+        {
+            hiker.path.clear();
+            if (!randomCell(-1, hiker.position)) { continue; }
+            region = m_regions.label(hiker.position);
+        }
+
+        // a goal that was reached, flooded or cut off is replaced by one the hiker can walk to
+        if (hiker.position == hiker.goal || !m_regions.connected(hiker.position, hiker.goal))
+        {
+            if (!randomCell(region, hiker.goal)) { hiker.goal = hiker.position; }
+        }
+
+        m_astar.search(m_heights, hiker.position, hiker.goal, m_costs, hiker.path);
+        m_planned++;
+
+        // the path starts where the hiker stands
+        if (!hiker.path.empty())
+        {
+            hiker.position = hiker.path[std::min(hiker.path.size() - 1, (size_t)m_speed)];
+        }
+    }
+}
+
+void Processor_Hikers::drawTrails()
+{
+    PROFILE_FUNCTION();
+
+    m_trails.create((int)m_heights.height(), (int)m_heights.width(), CV_32F);
+    m_trails.setTo(0.0f);
+    for (auto & hiker : m_hikers)
+    {
+        for (const State & s : hiker.path)
+        {
+            m_trails.at<float>(s.y, s.x) = 0.4f;
+        }
+
+        // the hiker itself a few cells wide so it can be seen from the side of the box
+        if (hiker.position.x < 0) { continue; }
+        cv::Rect dot(hiker.position.x - 1, hiker.position.y - 1, 3, 3);
+        m_trails(dot & cv::Rect(0, 0, m_trails.cols, m_trails.rows)).setTo(1.0f);
+    }
+}
+
+void Processor_Hikers::processFrame(const TopographyFrame::Ptr& frame)
+{
+    PROFILE_FUNCTION();
+
+    const cv::Mat& data = frame->topography();
+
+    {
+        PROFILE_SCOPE("Color");
+
+        // the projected image is cached on the frame and shared with any other processor using the same projection
+        std::vector<cv::Rect> changed;
+        const cv::Mat& rgba = m_projector.projectRGBA(*frame, &changed);
+
+        // if something went wrong above, quit the function
+        if (rgba.cols == 0 || rgba.rows == 0) { return; }
+
+        // the changes are relative to the previous frame, if we did not see that one the whole texture is stale
+        if (frame->previousID() != m_lastFrameID)
+        {
+            changed = { cv::Rect(0, 0, rgba.cols, rgba.rows) };
+        }
+
+        m_frame = frame;
+        m_lastFrameID = frame->id();
+        m_transformedDepthRGBAColor = rgba;
+        m_changedRegionsColor.insert(m_changedRegionsColor.end(), changed.begin(), changed.end());
+        m_imagesUpdated = true;
+    }
+
+    {
+        PROFILE_SCOPE("Hikers");
+
+        Timer timer;
+        m_heights.refill(data.cols, data.rows, 0.0f);
+        for (int y = 0; y < data.rows; y++)
+        {
+            const float * row = data.ptr<float>(y);
+            std::copy(row, row + data.cols, m_heights.data() + (size_t)y * data.cols);
+        }
+
+        // the sand may have changed anywhere, labelling it again is cheaper than one search into a dead end
+        m_regions.update(m_heights, m_costs);
+        planHikers();
+        m_planMS = timer.elapsed() / 1000.0f;
+
+        drawTrails();
+        {
+            PROFILE_SCOPE("Calibration TransformProjection");
+            m_projector.project(m_trails, m_cvTransformedTrails);
+        }
+
+        // if something went wrong above, quit the function
+        if (m_cvTransformedTrails.cols == 0 || m_cvTransformedTrails.rows == 0) { return; }
+        {
+            PROFILE_SCOPE("Transformed Image SFML Image");
+            m_sfTransformedImageTrails = Tools::matToSfImage(m_cvTransformedTrails);
+            m_trailsImageUpdated = true;
+            m_imagesUpdated = true;
+        }
+    }
+}
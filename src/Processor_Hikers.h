@@ -0,0 +1,76 @@
+#pragma once
+
+#include "AStar.h"
+#include "Profiler.hpp"
+#include "RegionMap.h"
+#include "SandboxProjector.h"
+#include "Tools.h"
+#include "TopographyProcessor.h"
+
+#include <random>
+
+// Hikers walking between random places on the sand
+// Every frame the regions are labelled again and every hiker plans a new path from where it stands to its goal,
+// so the routes bend around the sand while it is being shaped. Weighted A* keeps a plan to a fraction of a
+// millisecond, the paths cost at most the weight times the cheapest one. A hiker whose goal was flooded or
+// cut off picks a new one it can reach, without a search that would have to expand its whole region first.
+class Processor_Hikers : public TopographyProcessor
+{
+    struct Hiker
+    {
+        State               position = State(-1, -1);
+        State               goal = State(-1, -1);
+        std::vector<State>  path;                   // from position to goal
+    };
+
+    SandBoxProjector m_projector;
+    bool        m_drawProjection = true;
+
+    TopographyFrame::Ptr m_frame;       // kept so the next frame can reuse its projection
+    cv::Mat     m_transformedDepthRGBAColor;
+    std::vector<cv::Rect> m_changedRegionsColor;
+    size_t      m_lastFrameID = SIZE_MAX;
+    sf::Texture m_sfTransformedDepthTextureColor;
+    sf::Sprite  m_sfTransformedDepthSpriteColor;
+    sf::Shader  m_shader_color;
+
+    cv::Mat     m_trails;                       // paths and hikers over the topography, 0 to 1
+    cv::Mat     m_cvTransformedTrails;
+    sf::Image   m_sfTransformedImageTrails;
+    sf::Texture m_sfTransformedTextureTrails;
+    sf::Sprite  m_sfTransformedSpriteTrails;
+    bool        m_imagesUpdated = false;
+    bool        m_trailsImageUpdated = false;
+
+    bool        m_drawContours = false;
+    int         m_numberOfContourLines = 19;
+
+    Grid<float> m_heights;
+    TraversalCosts m_costs = { 5000.0f, 0.05f, 0.2f };
+    RegionMap   m_regions;
+    AStar       m_astar;
+    std::vector<Hiker> m_hikers;
+    int         m_hikerCount = 16;
+    int         m_speed = 1;                    // cells walked per frame
+    float       m_weight = 3.0f;
+    std::mt19937 m_rng;
+    float       m_planMS = 0.0f;                // labelling and planning of the last frame
+    size_t      m_planned = 0;
+
+    // a random cell of the region, of any region that can be entered when region is -1
+    bool randomCell(int32_t region, State & cell);
+    void planHikers();
+    void drawTrails();
+
+public:
+    void init();
+    void imgui();
+    void render(sf::RenderWindow& window);
+    void processEvent(const sf::Event& event, const sf::Vector2f& mouse);
+    void save(Save& save) const;
+    void load(const Save& save);
+
+    void processTopography(const cv::Mat& data);
+    bool isAnimating() const;
+    void processFrame(const TopographyFrame::Ptr& frame);
+};
@@ -0,0 +1,272 @@
+#include "Processor_Water.h"
+#include "Profiler.hpp"
+#include "Tools.h"
+
+#include "imgui.h"
+#include "imgui-SFML.h"
+
+namespace {
+    const std::string shaderPathColor = "shaders/shader_contour_color.frag";
+    const std::string shaderPathWater = "shaders/shader_water.frag";
+}
+
+void Processor_Water::init()
+{
+    setInitialSources();
+    m_shader_color.loadFromFile(shaderPathColor, sf::Shader::Fragment);
+    m_shader_water.loadFromFile(shaderPathWater, sf::Shader::Fragment);
+}
+
+void Processor_Water::setInitialSources()
+{
+    m_waterGrid.clearSources();
+    m_waterGrid.addSource(WaterSource(cv::Rect(100, 100, 10, 10), 0.5f));
+    m_waterGrid.addSource(WaterSource(cv::Rect(300, 200, 10, 10), 0.5f));
+}
+
+void Processor_Water::imgui()
+{
+    PROFILE_FUNCTION();
+
+    WaterParameters & parameters = m_waterGrid.m_parameters;
+    ImGui::SliderInt("Iterations Per Frame", &m_iterations, 0, 200);
+    ImGui::SliderFloat("Time Budget (ms)", &m_budgetMS, 0.0f, 30.0f);
+    ImGui::Text("Iterations Last Frame: %d, Volume: %.0f", m_lastIterations, m_waterGrid.volume());
+    ImGui::SliderFloat("Rain", &parameters.rain, 0.0f, 0.01f, "%.4f");
+    ImGui::SliderFloat("Evaporation", &parameters.evaporation, 0.0f, 0.01f, "%.4f");
+    ImGui::SliderFloat("Conductance", &parameters.conductance, 0.01f, 0.25f);
+    ImGui::SliderFloat("Damping", &parameters.damping, 0.9f, 1.0f, "%.3f");
+    ImGui::SliderFloat("Height Scale", &parameters.heightScale, 1.0f, 200.0f);
+    ImGui::SliderFloat("Full Depth", &m_fullDepth, 0.1f, 10.0f);
+
+    if (ImGui::Button("Step"))
+    {
+        m_doStep = true;
+    }   ImGui::SameLine();
+
+    if (ImGui::Button("Reset Water"))
+    {
+        m_waterGrid.reset();
+    }
+
+    std::vector<std::string> sourceStrings;
+    sourceStrings.reserve(m_waterGrid.getSources().size());
+    std::vector<const char*> sourceCStrings;
+    sourceCStrings.reserve(m_waterGrid.getSources().size());
+
+    for (size_t s = 0; s < m_waterGrid.getSources().size(); s++)
+    {
+        auto& source = m_waterGrid.getSources()[s];
+        std::stringstream ss;
+        ss << source.m_rate << " : (" << source.m_area.x << ", " << source.m_area.y << ")";
+        sourceStrings.push_back(ss.str());
+        sourceCStrings.push_back(sourceStrings.back().c_str());
+    }
+
+    ImGui::Combo("Source", &m_selectedSource, sourceCStrings.data(), (int)sourceCStrings.size());
+    if (!m_waterGrid.getSources().empty())
+    {
+        ImGui::SliderFloat("Source Rate", &m_waterGrid.getSources()[m_selectedSource].m_rate, -1.0f, 1.0f);
+    }
+
+    // new sources start in the middle of the sand and are dragged into place
+    const cv::Mat & depth = m_waterGrid.depth();
+    if (ImGui::Button("Add Spring"))
+    {
+        m_waterGrid.addSource(WaterSource(cv::Rect(depth.cols / 2, depth.rows / 2, 10, 10), 0.5f));
+        m_selectedSource = (int)m_waterGrid.getSources().size() - 1;
+    }   ImGui::SameLine();
+
+    if (ImGui::Button("Add Drain"))
+    {
+        m_waterGrid.addSource(WaterSource(cv::Rect(depth.cols / 2, depth.rows / 2, 10, 10), -0.5f));
+        m_selectedSource = (int)m_waterGrid.getSources().size() - 1;
+    }   ImGui::SameLine();
+
+    if (ImGui::Button("Clear Sources"))
+    {
+        m_waterGrid.clearSources();
+        m_selectedSource = 0;
+    }
+
+    ImGui::Separator();
+    m_projector.imgui();
+
+    if (ImGui::Button("Reload Shader"))
+    {
+        m_shader_color.loadFromFile(shaderPathColor, sf::Shader::Fragment);
+        m_shader_water.loadFromFile(shaderPathWater, sf::Shader::Fragment);
+    }
+
+    ImGui::Checkbox("##Contours", &m_drawContours);
+    ImGui::SameLine();
+    ImGui::SliderInt("Contour Lines", &m_numberOfContourLines, 0, 19);
+}
+
+void Processor_Water::render(sf::RenderWindow& window)
+{
+    PROFILE_FUNCTION();
+
+    // processTopography can run on a worker thread, so the texture uploads happen here on the render thread
+    if (m_imagesUpdated)
+    {
+        PROFILE_SCOPE("SFML Texture From Image");
+        if (Tools::updateTexture(m_sfTransformedDepthTextureColor, m_transformedDepthRGBAColor, m_changedRegionsColor))
+        {
+            m_sfTransformedDepthSpriteColor.setTexture(m_sfTransformedDepthTextureColor, true);
+        }
+        m_changedRegionsColor.clear();
+        if (m_waterImageUpdated)
+        {
+            m_sfTransformedTextureWater.loadFromImage(m_sfTransformedImageWater);
+            m_sfTransformedSpriteWater.setTexture(m_sfTransformedTextureWater, true);
+            m_waterImageUpdated = false;
+        }
+        m_imagesUpdated = false;
+    }
+    if (m_drawProjection)
+    {
+        PROFILE_SCOPE("Draw Transformed Image");
+
+        float scale = m_projector.getTransformedScale();
+
+        // the sand underneath in the terrain colors
+        m_sfTransformedDepthSpriteColor.setPosition(m_projector.getTransformedPosition());
+        m_sfTransformedDepthSpriteColor.setScale(scale, scale);
+
+        static sf::Clock time;
+        m_shader_color.setUniform("shaderIndex", 3);
+        m_shader_color.setUniform("contour", m_drawContours);
+        m_shader_color.setUniform("numberOfContourLines", m_numberOfContourLines);
+        m_shader_color.setUniform("u_time", time.getElapsedTime().asSeconds());
+        window.draw(m_sfTransformedDepthSpriteColor, &m_shader_color);
+
+        // the water blended over it
+        m_sfTransformedSpriteWater.setPosition(m_projector.getTransformedPosition());
+        m_sfTransformedSpriteWater.setScale(scale, scale);
+        window.draw(m_sfTransformedSpriteWater, &m_shader_water);
+    }
+
+    m_projector.render(window);
+}
+
+void Processor_Water::processEvent(const sf::Event& event, const sf::Vector2f& mouse)
+{
+    PROFILE_FUNCTION();
+
+    const bool draggingProjection = m_projector.processEvent(event, mouse);
+
+    // the selected source follows the mouse while the left button is held
+    auto & sources = m_waterGrid.getSources();
+    if (!draggingProjection && !sources.empty() && sf::Mouse::isButtonPressed(sf::Mouse::Left))
+    {
+        sf::Vector2f diff = mouse - m_previousMouse;
+
+        if (diff.x != 0 || diff.y != 0)
+        {
+            sources[m_selectedSource].m_area.x += (int)diff.x;
+            sources[m_selectedSource].m_area.y += (int)diff.y;
+        }
+    }
+
+    m_previousMouse = mouse;
+}
+
+void Processor_Water::save(Save& save) const
+{
+    save.drawContours = m_drawContours;
+    save.numberOfContourLines = m_numberOfContourLines;
+    save.drawProjection = m_drawProjection;
+    save.waterIterations = m_iterations;
+    save.waterBudget = m_budgetMS;
+    save.waterRain = m_waterGrid.m_parameters.rain;
+    save.waterEvaporation = m_waterGrid.m_parameters.evaporation;
+    save.waterConductance = m_waterGrid.m_parameters.conductance;
+    save.waterDamping = m_waterGrid.m_parameters.damping;
+    save.waterHeightScale = m_waterGrid.m_parameters.heightScale;
+    save.waterFullDepth = m_fullDepth;
+    m_projector.save(save);
+}
+
+void Processor_Water::load(const Save& save)
+{
+    m_drawContours = save.drawContours;
+    m_numberOfContourLines = save.numberOfContourLines;
+    m_drawProjection = save.drawProjection;
+    m_iterations = save.waterIterations;
+    m_budgetMS = save.waterBudget;
+    m_waterGrid.m_parameters.rain = save.waterRain;
+    m_waterGrid.m_parameters.evaporation = save.waterEvaporation;
+    m_waterGrid.m_parameters.conductance = save.waterConductance;
+    m_waterGrid.m_parameters.damping = save.waterDamping;
+    m_waterGrid.m_parameters.heightScale = save.waterHeightScale;
+    m_fullDepth = save.waterFullDepth;
+    m_projector.load(save);
+}
+
+void Processor_Water::processTopography(const cv::Mat& data)
+{
+    processFrame(std::make_shared<const TopographyFrame>(data));
+}
+
+// the simulation moves on every frame it runs iterations, even when the sand is still
+bool Processor_Water::isAnimating() const
+{
+    return m_iterations > 0 || m_doStep;
+}
+
+void Processor_Water::processFrame(const TopographyFrame::Ptr& frame)
+{
+    PROFILE_FUNCTION();
+
+    const cv::Mat& data = frame->topography();
+
+    {
+        PROFILE_SCOPE("Color");
+
+        // the projected image is cached on the frame and shared with any other processor using the same projection
+        std::vector<cv::Rect> changed;
+        const cv::Mat& rgba = m_projector.projectRGBA(*frame, &changed);
+
+        // if something went wrong above, quit the function
+        if (rgba.cols == 0 || rgba.rows == 0) { return; }
+
+        // the changes are relative to the previous frame, if we did not see that one the whole texture is stale
+        if (frame->previousID() != m_lastFrameID)
+        {
+            changed = { cv::Rect(0, 0, rgba.cols, rgba.rows) };
+        }
+
+        m_frame = frame;
+        m_lastFrameID = frame->id();
+        m_transformedDepthRGBAColor = rgba;
+        m_changedRegionsColor.insert(m_changedRegionsColor.end(), changed.begin(), changed.end());
+        m_imagesUpdated = true;
+    }
+
+    {
+        PROFILE_SCOPE("Water");
+
+        m_lastIterations = m_waterGrid.update(data, m_iterations, m_budgetMS);
+
+        if (m_doStep)
+        {
+            m_lastIterations += m_waterGrid.update(data, 1, 0.0f);
+            m_doStep = false;
+        }
+
+        {
+            PROFILE_SCOPE("Calibration TransformProjection");
+            m_projector.project(m_waterGrid.normalizedData(m_fullDepth), m_cvTransformedWater);
+        }
+
+        // if something went wrong above, quit the function
+        if (m_cvTransformedWater.cols == 0 || m_cvTransformedWater.rows == 0) { return; }
+        {
+            PROFILE_SCOPE("Transformed Image SFML Image");
+            m_sfTransformedImageWater = Tools::matToSfImage(m_cvTransformedWater);
+            m_waterImageUpdated = true;
+            m_imagesUpdated = true;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Profiler.hpp"
+#include "SandboxProjector.h"
+#include "Tools.h"
+#include "TopographyProcessor.h"
+#include "WaterGrid.h"
+
+class Processor_Water : public TopographyProcessor
+{
+    WaterGrid   m_waterGrid;
+
+    SandBoxProjector m_projector;
+    bool        m_drawProjection = true;
+
+    TopographyFrame::Ptr m_frame;       // kept so the next frame can reuse its projection
+    cv::Mat     m_transformedDepthRGBAColor;
+    std::vector<cv::Rect> m_changedRegionsColor;
+    size_t      m_lastFrameID = SIZE_MAX;
+    sf::Texture m_sfTransformedDepthTextureColor;
+    sf::Sprite  m_sfTransformedDepthSpriteColor;
+    sf::Shader  m_shader_color;
+
+    cv::Mat     m_cvTransformedWater;
+    sf::Image   m_sfTransformedImageWater;
+    sf::Texture m_sfTransformedTextureWater;
+    sf::Sprite  m_sfTransformedSpriteWater;
+    sf::Shader  m_shader_water;
+    bool        m_imagesUpdated = false;
+    bool        m_waterImageUpdated = false;
+
+    bool        m_drawContours = false;
+    int         m_numberOfContourLines = 19;
+    int         m_iterations = 40;
+    float       m_budgetMS = 8.0f;              // time the simulation may take per frame
+    float       m_fullDepth = 2.0f;             // depth drawn with the deepest color
+    int         m_lastIterations = 0;
+    bool        m_doStep = false;
+
+    int         m_selectedSource = 0;
+
+    sf::Vector2f m_previousMouse;
+
+    void setInitialSources();
+
+public:
+    void init();
+    void imgui();
+    void render(sf::RenderWindow& window);
+    void processEvent(const sf::Event& event, const sf::Vector2f& mouse);
+    void save(Save& save) const;
+    void load(const Save& save);
+
+    void processTopography(const cv::Mat& data);
+    bool isAnimating() const;
+    void processFrame(const TopographyFrame::Ptr& frame);
+};
@@ -5,6 +5,7 @@
 #include <mutex>
 #include <map>
 #include <string>
+#include <thread>
 #include <algorithm>
 
 //#define PROFILING 1
@@ -0,0 +1,76 @@
+#include "RegionMap.h"
+#include "Profiler.hpp"
+
+#include <cmath>
+
+RegionMap::RegionMap(bool diagonal)
+    : m_diagonal(diagonal)
+{
+
+}
+
+int32_t RegionMap::find(int32_t cell)
+{
+    // path halving, every other cell on the way points to its grandparent
+    while (m_parent[cell] != cell)
+    {
+        m_parent[cell] = m_parent[m_parent[cell]];
+        cell = m_parent[cell];
+    }
+    return cell;
+}
+
+void RegionMap::join(int32_t a, int32_t b)
+{
+    a = find(a);
+    b = find(b);
+    if (a < b) { m_parent[b] = a; }
+    else if (b < a) { m_parent[a] = b; }
+}
+
+void RegionMap::update(const Grid<float> & heights, const TraversalCosts & costs)
+{
+    PROFILE_FUNCTION();
+
+    const int width = (int)heights.width();
+    const int height = (int)heights.height();
+    m_labels.refill(width, height, -1);
+    m_parent.resize((size_t)width * height);
+    m_regions = 0;
+
+    // the same rules as AStar::stepCost, written out on rows so the checks stay cheap
+    auto open = [&](const float * row, int x) { return row[x] >= costs.minHeight; };
+    auto climbable = [&](float a, float b) { return !(std::abs(b - a) > costs.maxStep); };
+
+    for (int32_t cell = 0; cell < width * height; cell++) { m_parent[cell] = cell; }
+
+    // every cell joins the neighbours it can step to on the right and in the row below
+    for (int y = 0; y < height; y++)
+    {
+        const float * row = &heights.get(0, y);
+        const float * below = y + 1 < height ? &heights.get(0, y + 1) : nullptr;
+        for (int x = 0; x < width; x++)
+        {
+            if (!open(row, x)) { continue; }
+
+            const int32_t cell = y * width + x;
+            if (x + 1 < width && open(row, x + 1) && climbable(row[x], row[x + 1])) { join(cell, cell + 1); }
+            if (!below || !open(below, x)) { continue; }
+            if (climbable(row[x], below[x])) { join(cell, cell + width); }
+            if (!m_diagonal) { continue; }
+
+            // diagonal steps can't cut the corner of a blocked cell, both cells beside the step have to be open
+            if (x + 1 < width && open(row, x + 1) && open(below, x + 1) && climbable(row[x], below[x + 1])) { join(cell, cell + width + 1); }
+            if (x > 0 && open(row, x - 1) && open(below, x - 1) && climbable(row[x], below[x - 1])) { join(cell, cell + width - 1); }
+        }
+    }
+
+    // a root is the first cell of its region, so it gets its label before any other cell of the region
+    for (int32_t cell = 0; cell < width * height; cell++)
+    {
+        if (!(heights.get(cell) >= costs.minHeight)) { continue; }
+        const int32_t root = find(cell);
+        if (root == cell) { m_labels.set(cell, (int32_t)m_regions++); }
+        else { m_labels.set(cell, m_labels.get(root)); }
+    }
+}
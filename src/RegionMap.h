@@ -0,0 +1,48 @@
+#pragma once
+
+#include "AStar.h"
+
+#include <vector>
+
+// Which cells can reach each other, every cell is labelled with the connected region it belongs to
+// The regions follow the same step rules as AStar. Steps are symmetric, so two cells with the same label are
+// connected both ways and a search between two labels can be turned down without expanding a node.
+// A search towards an unreachable goal expands every cell of its region, on the sand with a water line
+// those are by far the slowest queries.
+// Every cell is joined with the neighbours it can step to to the right and below in a union-find forest,
+// half of the steps a flood fill would try, so the sand can be labelled again every frame.
+class RegionMap
+{
+    Grid<int32_t>       m_labels;           // -1 for cells that can't be entered
+    std::vector<int32_t> m_parent;          // union-find forest over the cells
+    bool                m_diagonal = true;
+    size_t              m_regions = 0;
+
+    int32_t find(int32_t cell);
+    void join(int32_t a, int32_t b);
+
+public:
+
+    RegionMap(bool diagonal = true);
+
+    // labels every cell again, close to linear in the size of the grid
+    void update(const Grid<float> & heights, const TraversalCosts & costs);
+
+    // -1 for cells outside the grid or that can't be entered
+    inline int32_t label(State s) const
+    {
+        if (s.x < 0 || s.y < 0 || s.x >= (int)m_labels.width() || s.y >= (int)m_labels.height()) { return -1; }
+        return m_labels.get(s);
+    }
+
+    // whether a path from a to b exists
+    inline bool connected(State a, State b) const
+    {
+        int32_t region = label(a);
+        return region >= 0 && region == label(b);
+    }
+
+    inline size_t regionCount() const { return m_regions; }
+
+    inline size_t memoryUsage() const { return m_labels.width() * m_labels.height() * sizeof(int32_t) + m_parent.capacity() * sizeof(int32_t); }
+};
@@ -22,22 +22,38 @@ SandBoxProjector::SandBoxProjector()
     m_projectionCircles = std::vector<sf::CircleShape>(4, circle);
 }
 
-void SandBoxProjector::project(const cv::Mat & input, cv::Mat & output)
+void SandBoxProjector::updateDataSize(int width, int height)
 {
     // Check to see if data matrix has changed in size and generate the projection matrix again if so
-    int width = input.cols;
-    int height = input.rows;
     if (width != m_dataWidth || height != m_dataHeight || m_projectionMatrix.rows == 0 || m_projectionMatrix.cols == 0)
     {
         m_dataWidth = width;
         m_dataHeight = height;
         generateProjection();
     }
+}
+
+void SandBoxProjector::project(const cv::Mat & input, cv::Mat & output)
+{
+    updateDataSize(input.cols, input.rows);
 
     // Apply projection
     cv::warpPerspective(input, output, m_projectionMatrix, cv::Size(m_finalWidth, m_finalHeight));
 }
 
+// the warp is cached on the frame, so processors sharing the same projection points only warp it once
+const cv::Mat & SandBoxProjector::project(const TopographyFrame & frame)
+{
+    updateDataSize(frame.topography().cols, frame.topography().rows);
+    return frame.projected(m_projectionMatrix, cv::Size(m_finalWidth, m_finalHeight));
+}
+
+const cv::Mat & SandBoxProjector::projectRGBA(const TopographyFrame & frame, std::vector<cv::Rect> * changed)
+{
+    updateDataSize(frame.topography().cols, frame.topography().rows);
+    return frame.projectedRGBA(m_projectionMatrix, cv::Size(m_finalWidth, m_finalHeight), changed);
+}
+
 void SandBoxProjector::imgui()
 {
     PROFILE_FUNCTION();
@@ -143,6 +159,7 @@ void SandBoxProjector::generateProjection()
     }
 
     m_projectionMatrix = cv::getPerspectiveTransform(dataCorners, boxPoints);
+    m_version++;
 }
 
 void SandBoxProjector::save(Save& save) const
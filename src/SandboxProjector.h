@@ -5,6 +5,7 @@
 #include <fstream>
 
 #include "Save.hpp"
+#include "TopographyFrame.h"
 
 class SandBoxProjector
 {
@@ -20,8 +21,10 @@ class SandBoxProjector
     sf::Vector2f                    m_boxScale;
     bool                            m_drawLines = true;
     bool                            m_drawProjection = true;
+    size_t                          m_version = 0;          // bumped whenever the projection matrix is regenerated
 
     void generateProjection();
+    void updateDataSize(int width, int height);
 
 public:
 
@@ -30,6 +33,8 @@ public:
     void save(Save & save) const;
     void load(const Save & save);
     void project(const cv::Mat & input, cv::Mat & output);
+    const cv::Mat & project(const TopographyFrame & frame);
+    const cv::Mat & projectRGBA(const TopographyFrame & frame, std::vector<cv::Rect> * changed = nullptr);
     bool processEvent(const sf::Event & event, const sf::Vector2f & mouse);
     void render(sf::RenderWindow & window);
 
@@ -37,6 +42,8 @@ public:
 
     inline sf::Vector2f getTransformedPosition() const { return m_minXY; }
 
+    inline size_t getVersion() const { return m_version; }
+
     inline cv::Mat getProjectionMatrix()
     {
         generateProjection();
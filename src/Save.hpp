@@ -1,6 +1,8 @@
 #pragma once
 
 #include <fstream>
+#include <string>
+#include <vector>
 #include <opencv2/opencv.hpp>
 
 struct Save
@@ -8,10 +10,26 @@ struct Save
     // main
     std::string source = "Camera";
     std::string processor = "Colorizer";
+    std::vector<std::string> pipeline;
+
+    // dirty tiles
+    bool trackDirtyTiles = true;
+    float dirtyEnterThreshold = 0.01f;
+    float dirtyExitThreshold = 0.004f;
+    int dirtyHoldFrames = 3;
+
+    // frame governor
+    bool adaptiveFrameRate = true;
+    bool skipIdleProcessing = true;
+    int activeFPS = 0;
+    int idleFPS = 5;
+    float idleDelay = 3.0f;
 
     // camera
     int align = 0;
     bool gaussianBlur = true;
+    int blurMethod = 1;                 // saves from before the running sum blur used the OpenCV kernel
+    float blurSigma = 9.5f;
     float maxDistance = 1.13f;
     float minDistance = 0.90f;
     bool drawDepth = true;
@@ -24,12 +42,43 @@ struct Save
     int seedSize = 9;
     float persistance = 0.5f;
     bool drawGrid = false;
+    int noiseType = 0;
+
+    // procedural
+    int proceduralSeed = 0;
+    int proceduralOctaves = 10;
+    float proceduralPersistance = 0.5f;
+    int proceduralNoiseType = 1;
+    int proceduralWidth = 1280;
+    int proceduralHeight = 720;
+    float proceduralZoom = 1.0f;
+    float proceduralScrollX = 0.0f;
+    float proceduralScrollY = 0.0f;
+    int proceduralCacheTiles = 256;
+
+    // synthetic
+    int syntheticSeed = 0;
+    int syntheticFpsSetting = 1;
+    int syntheticHands = 2;
+    float syntheticSpeed = 1.0f;
+    int syntheticPose = 0;
+    float syntheticPoseSeconds = 2.0f;
+    float syntheticHandScale = 1.0f;
+    float syntheticDepthNoise = 1.0f;
+    float syntheticMaxDistance = 1.13f;
+    float syntheticMinDistance = 0.90f;
+    bool syntheticDetectHands = true;
 
     // filters
     float temporalAlpha = 0.047f;
     int temporalDelta = 72;
     int temporalPersistance = 3;
+    bool temporalNative = false;        // saves from before the native filter used the realsense one
     int holeFill = 1;
+    bool edgeFilter = false;
+    float edgeSigmaSpatial = 8.0f;
+    float edgeSigmaRange = 6.0f;
+    int edgeIterations = 2;
 
     // data warper
     cv::Point2f warpPoints[4] = { {100, 100}, {200, 100}, {100, 200}, {200, 200} };
@@ -46,6 +95,24 @@ struct Save
     int numberOfContourLines = 15;
     bool drawProjection = true;
 
+    // water
+    int waterIterations = 40;
+    float waterBudget = 8.0f;
+    float waterRain = 0.0f;
+    float waterEvaporation = 0.0005f;
+    float waterConductance = 0.2f;
+    float waterDamping = 0.995f;
+    float waterHeightScale = 60.0f;
+    float waterFullDepth = 2.0f;
+
+    // hikers
+    int hikerCount = 16;
+    int hikerSpeed = 1;
+    float hikerWeight = 3.0f;
+    float hikerWaterLevel = 0.2f;
+    float hikerMaxStep = 0.05f;
+    float hikerSlopePenalty = 5000.0f;
+
 
     void saveToFile(const std::string & filename)
     {
@@ -59,8 +126,28 @@ struct Save
 
         fout << "source " << source << '\n';
         fout << "processor " << processor << '\n';
+
+        fout << "pipeline " << pipeline.size() << " ";
+        for (auto & p : pipeline)
+        {
+            fout << p << " ";
+        }
+        fout << '\n';
+
+        fout << "trackDirtyTiles " << trackDirtyTiles << '\n';
+        fout << "dirtyEnterThreshold " << dirtyEnterThreshold << '\n';
+        fout << "dirtyExitThreshold " << dirtyExitThreshold << '\n';
+        fout << "dirtyHoldFrames " << dirtyHoldFrames << '\n';
+        fout << "adaptiveFrameRate " << adaptiveFrameRate << '\n';
+        fout << "skipIdleProcessing " << skipIdleProcessing << '\n';
+        fout << "activeFPS " << activeFPS << '\n';
+        fout << "idleFPS " << idleFPS << '\n';
+        fout << "idleDelay " << idleDelay << '\n';
+
         fout << "align " << align << '\n';
         fout << "gaussianBlur " << gaussianBlur << '\n';
+        fout << "blurMethod " << blurMethod << '\n';
+        fout << "blurSigma " << blurSigma << '\n';
         fout << "maxDistance " << maxDistance << '\n';
         fout << "minDistance " << minDistance << '\n';
         fout << "drawDepth " << drawDepth << '\n';
@@ -71,10 +158,37 @@ struct Save
         fout << "seedSize " << seedSize << '\n';
         fout << "persistance " << persistance << '\n';
         fout << "drawGrid " << drawGrid << '\n';
+        fout << "noiseType " << noiseType << '\n';
+        fout << "proceduralSeed " << proceduralSeed << '\n';
+        fout << "proceduralOctaves " << proceduralOctaves << '\n';
+        fout << "proceduralPersistance " << proceduralPersistance << '\n';
+        fout << "proceduralNoiseType " << proceduralNoiseType << '\n';
+        fout << "proceduralWidth " << proceduralWidth << '\n';
+        fout << "proceduralHeight " << proceduralHeight << '\n';
+        fout << "proceduralZoom " << proceduralZoom << '\n';
+        fout << "proceduralScrollX " << proceduralScrollX << '\n';
+        fout << "proceduralScrollY " << proceduralScrollY << '\n';
+        fout << "proceduralCacheTiles " << proceduralCacheTiles << '\n';
+        fout << "syntheticSeed " << syntheticSeed << '\n';
+        fout << "syntheticFpsSetting " << syntheticFpsSetting << '\n';
+        fout << "syntheticHands " << syntheticHands << '\n';
+        fout << "syntheticSpeed " << syntheticSpeed << '\n';
+        fout << "syntheticPose " << syntheticPose << '\n';
+        fout << "syntheticPoseSeconds " << syntheticPoseSeconds << '\n';
+        fout << "syntheticHandScale " << syntheticHandScale << '\n';
+        fout << "syntheticDepthNoise " << syntheticDepthNoise << '\n';
+        fout << "syntheticMaxDistance " << syntheticMaxDistance << '\n';
+        fout << "syntheticMinDistance " << syntheticMinDistance << '\n';
+        fout << "syntheticDetectHands " << syntheticDetectHands << '\n';
         fout << "temporalAlpha " << temporalAlpha << '\n';
         fout << "temporalDelta " << temporalDelta << '\n';
         fout << "temporalPersistance " << temporalPersistance << '\n';
+        fout << "temporalNative " << temporalNative << '\n';
         fout << "holeFill " << holeFill << '\n';
+        fout << "edgeFilter " << edgeFilter << '\n';
+        fout << "edgeSigmaSpatial " << edgeSigmaSpatial << '\n';
+        fout << "edgeSigmaRange " << edgeSigmaRange << '\n';
+        fout << "edgeIterations " << edgeIterations << '\n';
 
         fout << "warpPoints ";
         for (auto p : warpPoints)
@@ -104,6 +218,20 @@ struct Save
         fout << "drawContours " << drawContours << '\n';
         fout << "numberOfContourLines " << numberOfContourLines << '\n';
         fout << "drawProjection " << drawProjection << '\n';
+        fout << "waterIterations " << waterIterations << '\n';
+        fout << "waterBudget " << waterBudget << '\n';
+        fout << "waterRain " << waterRain << '\n';
+        fout << "waterEvaporation " << waterEvaporation << '\n';
+        fout << "waterConductance " << waterConductance << '\n';
+        fout << "waterDamping " << waterDamping << '\n';
+        fout << "waterHeightScale " << waterHeightScale << '\n';
+        fout << "waterFullDepth " << waterFullDepth << '\n';
+        fout << "hikerCount " << hikerCount << '\n';
+        fout << "hikerSpeed " << hikerSpeed << '\n';
+        fout << "hikerWeight " << hikerWeight << '\n';
+        fout << "hikerWaterLevel " << hikerWaterLevel << '\n';
+        fout << "hikerMaxStep " << hikerMaxStep << '\n';
+        fout << "hikerSlopePenalty " << hikerSlopePenalty << '\n';
     }
 
     void loadFromFile(const std::string & filename)
@@ -121,8 +249,29 @@ struct Save
         {
             if (temp == "source") { fin >> source; }
             if (temp == "processor") { fin >> processor; }
+            if (temp == "pipeline")
+            {
+                size_t count = 0;
+                fin >> count;
+                pipeline = std::vector<std::string>(count);
+                for (auto & p : pipeline)
+                {
+                    fin >> p;
+                }
+            }
+            if (temp == "trackDirtyTiles") { fin >> trackDirtyTiles; }
+            if (temp == "dirtyEnterThreshold") { fin >> dirtyEnterThreshold; }
+            if (temp == "dirtyExitThreshold") { fin >> dirtyExitThreshold; }
+            if (temp == "dirtyHoldFrames") { fin >> dirtyHoldFrames; }
+            if (temp == "adaptiveFrameRate") { fin >> adaptiveFrameRate; }
+            if (temp == "skipIdleProcessing") { fin >> skipIdleProcessing; }
+            if (temp == "activeFPS") { fin >> activeFPS; }
+            if (temp == "idleFPS") { fin >> idleFPS; }
+            if (temp == "idleDelay") { fin >> idleDelay; }
             if (temp == "align") { fin >> align; }
             if (temp == "gaussianBlur") { fin >> gaussianBlur; }
+            if (temp == "blurMethod") { fin >> blurMethod; }
+            if (temp == "blurSigma") { fin >> blurSigma; }
             if (temp == "maxDistance") { fin >> maxDistance; }
             if (temp == "minDistance") { fin >> minDistance; }
             if (temp == "drawDepth") { fin >> drawDepth; }
@@ -133,10 +282,37 @@ struct Save
             if (temp == "seedSize") { fin >> seedSize; }
             if (temp == "persistance") { fin >> persistance; }
             if (temp == "drawGrid") { fin >> drawGrid; }
+            if (temp == "noiseType") { fin >> noiseType; }
+            if (temp == "proceduralSeed") { fin >> proceduralSeed; }
+            if (temp == "proceduralOctaves") { fin >> proceduralOctaves; }
+            if (temp == "proceduralPersistance") { fin >> proceduralPersistance; }
+            if (temp == "proceduralNoiseType") { fin >> proceduralNoiseType; }
+            if (temp == "proceduralWidth") { fin >> proceduralWidth; }
+            if (temp == "proceduralHeight") { fin >> proceduralHeight; }
+            if (temp == "proceduralZoom") { fin >> proceduralZoom; }
+            if (temp == "proceduralScrollX") { fin >> proceduralScrollX; }
+            if (temp == "proceduralScrollY") { fin >> proceduralScrollY; }
+            if (temp == "proceduralCacheTiles") { fin >> proceduralCacheTiles; }
+            if (temp == "syntheticSeed") { fin >> syntheticSeed; }
+            if (temp == "syntheticFpsSetting") { fin >> syntheticFpsSetting; }
+            if (temp == "syntheticHands") { fin >> syntheticHands; }
+            if (temp == "syntheticSpeed") { fin >> syntheticSpeed; }
+            if (temp == "syntheticPose") { fin >> syntheticPose; }
+            if (temp == "syntheticPoseSeconds") { fin >> syntheticPoseSeconds; }
+            if (temp == "syntheticHandScale") { fin >> syntheticHandScale; }
+            if (temp == "syntheticDepthNoise") { fin >> syntheticDepthNoise; }
+            if (temp == "syntheticMaxDistance") { fin >> syntheticMaxDistance; }
+            if (temp == "syntheticMinDistance") { fin >> syntheticMinDistance; }
+            if (temp == "syntheticDetectHands") { fin >> syntheticDetectHands; }
             if (temp == "temporalAlpha") { fin >> temporalAlpha; }
             if (temp == "temporalDelta") { fin >> temporalDelta; }
             if (temp == "temporalPersistance") { fin >> temporalPersistance; }
+            if (temp == "temporalNative") { fin >> temporalNative; }
             if (temp == "holeFill") { fin >> holeFill; }
+            if (temp == "edgeFilter") { fin >> edgeFilter; }
+            if (temp == "edgeSigmaSpatial") { fin >> edgeSigmaSpatial; }
+            if (temp == "edgeSigmaRange") { fin >> edgeSigmaRange; }
+            if (temp == "edgeIterations") { fin >> edgeIterations; }
             if (temp == "warpPoints")
             {
                 float x, y;
@@ -169,6 +345,20 @@ struct Save
             if (temp == "drawContours") { fin >> drawContours; }
             if (temp == "numberOfContourLines") { fin >> numberOfContourLines; }
             if (temp == "drawProjection") { fin >> drawProjection; }
+            if (temp == "waterIterations") { fin >> waterIterations; }
+            if (temp == "waterBudget") { fin >> waterBudget; }
+            if (temp == "waterRain") { fin >> waterRain; }
+            if (temp == "waterEvaporation") { fin >> waterEvaporation; }
+            if (temp == "waterConductance") { fin >> waterConductance; }
+            if (temp == "waterDamping") { fin >> waterDamping; }
+            if (temp == "waterHeightScale") { fin >> waterHeightScale; }
+            if (temp == "waterFullDepth") { fin >> waterFullDepth; }
+            if (temp == "hikerCount") { fin >> hikerCount; }
+            if (temp == "hikerSpeed") { fin >> hikerSpeed; }
+            if (temp == "hikerWeight") { fin >> hikerWeight; }
+            if (temp == "hikerWaterLevel") { fin >> hikerWaterLevel; }
+            if (temp == "hikerMaxStep") { fin >> hikerMaxStep; }
+            if (temp == "hikerSlopePenalty") { fin >> hikerSlopePenalty; }
         }
     }
 };
\ No newline at end of file
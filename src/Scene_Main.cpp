@@ -2,12 +2,17 @@
 #include "GameEngine.h"
 #include "Assets.h"
 #include "Profiler.hpp"
+#include "Timer.hpp"
 
 #include "Processor_Colorizer.h"
 #include "Processor_Minecraft.h"
 #include "Processor_Heat.h"
+#include "Processor_Hikers.h"
+#include "Processor_Water.h"
 #include "Source_Camera.h"
 #include "Source_Perlin.h"
+#include "Source_Procedural.h"
+#include "Source_Synthetic.h"
 #include "Source_Snapshot.h"
 
 #include <fstream>
@@ -35,23 +40,62 @@ void Scene_Main::init()
 
     registerSource<Source_Camera>("Camera");
     registerSource<Source_Perlin>("Perlin");
+    registerSource<Source_Procedural>("Procedural");
+    registerSource<Source_Synthetic>("Synthetic");
     registerSource<Source_Snapshot>("Snapshot");
 
     registerProcessor<Processor_Colorizer>("Colorizer");
     registerProcessor<Processor_Minecraft>("Minecraft");
     registerProcessor<Processor_Heat>("Heat");
+    registerProcessor<Processor_Water>("Water");
+    registerProcessor<Processor_Hikers>("Hikers");
     m_processorMap.emplace("None", []() {return nullptr; });
 
     load();
 }
 
+namespace
+{
+    // smooth the per node timings the same way the engine smooths the framerate
+    inline float smoothMS(float previous, long long elapsedMicroseconds)
+    {
+        return previous * 0.75f + 0.25f * (float)elapsedMicroseconds / 1000.0f;
+    }
+}
+
 void Scene_Main::onFrame()
 {
-    m_topography = m_source->getTopography();
-    m_source->getGestures();
-    if (m_processor && m_topography.rows > 0 && m_topography.cols > 0)
     {
-        m_processor->processTopography(m_topography);
+        Timer timer;
+        cv::Mat topography = m_source->getTopography();
+        std::vector<Gesture> gestures = m_source->getGestures();
+        size_t calibrationVersion = m_source->getCalibrationVersion();
+
+        // only tiles that really changed are passed on as dirty, the rest of the frame keeps the previous values
+        TileMask dirtyTiles;
+        topography = m_tileTracker.update(topography, calibrationVersion, dirtyTiles);
+        m_frame = std::make_shared<const TopographyFrame>(topography, m_source->getRawDepth(), gestures, m_frameID++, calibrationVersion, dirtyTiles, m_frame);
+        m_sourceMS = smoothMS(m_sourceMS, timer.elapsed());
+    }
+
+    // a running simulation changes the output without any change in the sand
+    bool animating = false;
+    for (auto & node : m_pipeline)
+    {
+        animating |= node.enabled && node.processor->isAnimating();
+    }
+
+    // moving sand or hands keep the engine at full rate
+    if (m_frame->dirtyTiles().any() || !m_frame->gestures().empty() || animating)
+    {
+        m_game->governor().reportActivity();
+    }
+
+    // a still frame while idle changes nothing the processors have not already seen
+    bool skipProcessing = m_game->governor().shouldSkipProcessing() && !m_frame->dirtyTiles().any() && !animating;
+    if (!m_frame->empty() && !skipProcessing)
+    {
+        sProcess();
     }
 
     sUserInput();
@@ -119,6 +163,7 @@ void Scene_Main::sUserInput()
     sf::Event event;
     while (main.pollEvent(event))
     {
+        m_game->governor().reportActivity();
         ImGui::SFML::ProcessEvent(main, event);
         m_viewController.processEvent(main, event);
         sProcessEvent(event);
@@ -131,9 +176,12 @@ void Scene_Main::sUserInput()
         }
 
         if (m_source) { m_source->processEvent(event, m_mouseWorld); }
-        if (m_processor && !displayOpen)
+
+        // only the selected node receives input, otherwise every projector would grab the same drag
+        auto node = selectedNode();
+        if (node && !displayOpen)
         {
-            m_processor->processEvent(event, m_mouseWorld);
+            node->processor->processEvent(event, m_mouseWorld);
         }
     }
 
@@ -143,9 +191,11 @@ void Scene_Main::sUserInput()
         sf::Event displayEvent;
         while (display.pollEvent(displayEvent))
         {
+            m_game->governor().reportActivity();
             sProcessEvent(displayEvent);
 
-            if (m_processor) { m_processor->processEvent(displayEvent, m_mouseDisplay); }
+            auto node = selectedNode();
+            if (node) { node->processor->processEvent(displayEvent, m_mouseDisplay); }
 
             // happens whenever the mouse is being moved
             if (displayEvent.type == sf::Event::MouseMoved)
@@ -156,7 +206,37 @@ void Scene_Main::sUserInput()
     }
 }
 
+// runs every enabled processor on the current frame
+// the nodes are independent of each other, so they are spread over the task pool and all share the same immutable frame,
+// anything derived from it (8 bit image, projections) is computed by whichever node asks first and reused by the rest
+void Scene_Main::sProcess()
+{
+    PROFILE_FUNCTION();
+
+    const TopographyFrame::Ptr frame = m_frame;
+    auto processNode = [&](size_t i)
+    {
+        ProcessorNode & node = m_pipeline[i];
+        if (!node.enabled) { return; }
+
+        PROFILE_SCOPE(node.id);
+        Timer timer;
+        node.processor->processFrame(frame);
+        node.processMS = smoothMS(node.processMS, timer.elapsed());
+    };
+
+    if (m_parallelPipeline)
+    {
+        m_taskPool.run(m_pipeline.size(), processNode);
+    }
+    else
+    {
+        for (size_t i = 0; i < m_pipeline.size(); i++) { processNode(i); }
+    }
+}
+
 // renders the scene
+// the composition stage of the pipeline is here: nodes are drawn in pipeline order, so later nodes layer over earlier ones
 void Scene_Main::sRender()
 {
     PROFILE_FUNCTION();
@@ -165,14 +245,15 @@ void Scene_Main::sRender()
     m_game->displayWindow().clear();
 
     if (m_source) { m_source->render(mainWindow()); }
-    if (!m_processor) { return; }
-    if (m_game->displayWindow().isOpen())
-    {
-        m_processor->render(displayWindow());
-    }
-    else
+
+    sf::RenderWindow & target = m_game->displayWindow().isOpen() ? displayWindow() : mainWindow();
+    for (auto & node : m_pipeline)
     {
-        m_processor->render(mainWindow());
+        if (!node.enabled) { continue; }
+
+        Timer timer;
+        node.processor->render(target);
+        node.renderMS = smoothMS(node.renderMS, timer.elapsed());
     }
 }
 
@@ -204,7 +285,7 @@ void Scene_Main::renderUI()
             ImGui::EndMenu();
         }
 
-        ImGui::Text("Framerate: %d", (int)m_game->framerate());
+        ImGui::Text("Framerate: %d (%s)", (int)m_game->framerate(), m_game->governor().modeName());
 
         ImGui::EndMainMenuBar();
     }
@@ -240,22 +321,71 @@ void Scene_Main::renderUI()
 
     if (ImGui::BeginTabItem("Processor"))
     {
-        if (ImGui::BeginCombo("Selected Processor", m_processorID.c_str()))
+        if (ImGui::BeginCombo("Add Processor", "Select..."))
         {
             for (auto & [name, _] : m_processorMap)
             {
-                bool selected = name == m_processorID;
-                if (ImGui::Selectable(name.c_str(), &selected))
+                if (name == "None") { continue; }
+                if (ImGui::Selectable(name.c_str(), false))
                 {
-                    setProcessor(name);
+                    addProcessor(name);
                 }
             }
             ImGui::EndCombo();
         }
+
+        ImGui::Checkbox("Run Processors In Parallel", &m_parallelPipeline);
+        m_tileTracker.imgui();
+        ImGui::Text("Source: %.2f ms", m_sourceMS);
+
+        // the pipeline, one row per node with its own timings
+        int removeIndex = -1;
+        for (size_t i = 0; i < m_pipeline.size(); i++)
+        {
+            auto & node = m_pipeline[i];
+            ImGui::PushID((int)i);
+            ImGui::Checkbox("##enabled", &node.enabled);
+            ImGui::SameLine();
+            if (ImGui::Selectable(node.id.c_str(), m_selectedNode == (int)i, 0, ImVec2(200, 0)))
+            {
+                m_selectedNode = (int)i;
+            }
+            ImGui::SameLine();
+            ImGui::Text("process %.2f ms, render %.2f ms", node.processMS, node.renderMS);
+            ImGui::SameLine();
+            if (ImGui::ArrowButton("##up", ImGuiDir_Up) && i > 0)
+            {
+                std::swap(m_pipeline[i], m_pipeline[i - 1]);
+                if (m_selectedNode == (int)i) { m_selectedNode--; }
+            }
+            ImGui::SameLine();
+            if (ImGui::ArrowButton("##down", ImGuiDir_Down) && i + 1 < m_pipeline.size())
+            {
+                std::swap(m_pipeline[i], m_pipeline[i + 1]);
+                if (m_selectedNode == (int)i) { m_selectedNode++; }
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Remove"))
+            {
+                removeIndex = (int)i;
+            }
+            ImGui::PopID();
+        }
+        if (removeIndex != -1) { removeProcessor(removeIndex); }
+
         ImGui::Separator();
 
-        if (m_processor) { m_processor->imgui(); }
+        auto node = selectedNode();
+        if (node) { node->processor->imgui(); }
+
+        ImGui::EndTabItem();
+    }
 
+    // Power
+
+    if (ImGui::BeginTabItem("Power"))
+    {
+        m_game->governor().imgui();
         ImGui::EndTabItem();
     }
 
@@ -271,10 +401,14 @@ void Scene_Main::save()
     current.close();
 
     if (m_source) { m_source->save(m_save); }
-    if (m_processor) { m_processor->save(m_save); }
+    for (auto & node : m_pipeline) { node.processor->save(m_save); }
+    m_tileTracker.save(m_save);
+    m_game->governor().save(m_save);
 
     m_save.source = m_sourceID;
-    m_save.processor = m_processorID;
+    m_save.pipeline.clear();
+    for (auto & node : m_pipeline) { m_save.pipeline.push_back(node.id); }
+    m_save.processor = m_pipeline.empty() ? "None" : m_pipeline.front().id;
 
     m_save.saveToFile("saves/" + m_saveFile);
 }
@@ -293,16 +427,22 @@ void Scene_Main::load()
 
     // First find and initialize the source and processor
     m_save.loadFromFile(file);
+    m_tileTracker.load(m_save);
+    m_game->governor().load(m_save);
 
     // This initializes the source and processor, even if there was no save file
     setSource(m_save.source);
-    setProcessor(m_save.processor);
+
+    // older saves only know about a single processor
+    if (m_save.pipeline.empty()) { setPipeline({ m_save.processor }); }
+    else                         { setPipeline(m_save.pipeline); }
 }
 
 void Scene_Main::setSource(const std::string & source)
 {
     if (m_source) { m_source->save(m_save); }
     m_sourceID = source;
+    m_tileTracker.reset();
     if (m_sourceMap.contains(source))
     {
         m_source = m_sourceMap.at(source)();
@@ -318,30 +458,56 @@ void Scene_Main::setSource(const std::string & source)
     }
 }
 
-void Scene_Main::setProcessor(const std::string & processor)
+void Scene_Main::setPipeline(const std::vector<std::string> & processors)
 {
-    if (m_processor) { m_processor->save(m_save); }
-    m_processorID = processor;
-    if (m_processorMap.contains(processor))
-    {
-        m_processor = m_processorMap.at(processor)();
-    }
-    else
+    m_pipeline.clear();
+    m_selectedNode = 0;
+
+    for (auto & processor : processors)
     {
-        m_processor = m_processorMap.at("Colorizer")();
+        addProcessor(processor);
     }
-    if (m_processor) 
+}
+
+void Scene_Main::addProcessor(const std::string & processor)
+{
+    auto it = m_processorMap.find(processor);
+    if (it == m_processorMap.end())
     {
-        m_processor->init();
-        m_processor->load(m_save);
+        it = m_processorMap.find("Colorizer");
     }
+
+    ProcessorNode node;
+    node.id = it->first;
+    node.processor = it->second();
+    if (!node.processor) { return; }
+
+    node.processor->init();
+    node.processor->load(m_save);
+    m_pipeline.push_back(node);
+    m_selectedNode = (int)m_pipeline.size() - 1;
+}
+
+void Scene_Main::removeProcessor(size_t index)
+{
+    if (index >= m_pipeline.size()) { return; }
+
+    m_pipeline[index].processor->save(m_save);
+    m_pipeline.erase(m_pipeline.begin() + index);
+    m_selectedNode = std::min(m_selectedNode, (int)m_pipeline.size() - 1);
+}
+
+ProcessorNode * Scene_Main::selectedNode()
+{
+    if (m_selectedNode < 0 || m_selectedNode >= (int)m_pipeline.size()) { return nullptr; }
+    return &m_pipeline[m_selectedNode];
 }
 
 void Scene_Main::saveDataDump()
 {
     auto now = std::chrono::system_clock::now();
     cv::FileStorage fout(std::format("dataDumps/{0:%F_%H-%M-%S}_snapshot.bin", now), cv::FileStorage::WRITE);
-    fout << "matrix" << m_topography;
+    fout << "matrix" << m_frame->topography();
 
 }
 
@@ -5,15 +5,29 @@
 #include "TopographyProcessor.h"
 #include "ViewController.hpp"
 #include "Save.hpp"
+#include "TaskPool.hpp"
+#include "DirtyTiles.h"
 
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
 
 #include <opencv2/opencv.hpp>   // Include OpenCV API
 
+// One processor in the pipeline, every enabled node processes the same topography each frame
+struct ProcessorNode
+{
+    std::string                             id;
+    std::shared_ptr<TopographyProcessor>    processor;
+    bool                                    enabled = true;
+    float                                   processMS = 0.0f;
+    float                                   renderMS = 0.0f;
+};
+
 class Scene_Main : public Scene
 {
-    cv::Mat             m_topography;
+    TopographyFrame::Ptr    m_frame = std::make_shared<const TopographyFrame>(cv::Mat());
+    size_t                  m_frameID = 0;
+    DirtyTileTracker        m_tileTracker;
 
     Save                m_save;
 
@@ -26,10 +40,13 @@ class Scene_Main : public Scene
     std::string         m_saveFile = "default.txt";
 
     std::string         m_sourceID = "Camera";
-    std::string         m_processorID = "Colorizer";
 
     std::shared_ptr<TopographySource>       m_source;
-    std::shared_ptr<TopographyProcessor>    m_processor;
+    std::vector<ProcessorNode>              m_pipeline;
+    int                                     m_selectedNode = 0;
+    bool                                    m_parallelPipeline = true;
+    float                                   m_sourceMS = 0.0f;
+    TaskPool                                m_taskPool;
 
     std::map<std::string, std::function<std::shared_ptr<TopographySource>()>> m_sourceMap;
     std::map<std::string, std::function<std::shared_ptr<TopographyProcessor>()>> m_processorMap;
@@ -40,13 +57,17 @@ class Scene_Main : public Scene
     void renderUI();
     void sUserInput();  
     void sProcessEvent(const sf::Event & event);
+    void sProcess();
     void sRender();
 
     void load();
     void save();
 
     void setSource(const std::string & source);
-    void setProcessor(const std::string & processor);
+    void setPipeline(const std::vector<std::string> & processors);
+    void addProcessor(const std::string & processor);
+    void removeProcessor(size_t index);
+    ProcessorNode * selectedNode();
 
     void saveDataDump();
 
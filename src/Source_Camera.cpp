@@ -92,7 +92,9 @@ void Source_Camera::captureImages()
     {
         PROFILE_SCOPE("Make OpenCV from Depth");
         // create an opencv image from the raw depth frame data, which is 16-bit unsigned int
-        m_cvDepthImage16u = cv::Mat(cv::Size(dw, dh), CV_16U, (void *)depthFrame.get_data(), cv::Mat::AUTO_STEP);
+        // it is copied out of the realsense frame because it is handed to processors and outlives depthFrame
+        m_cvDepthImage16u = cv::Mat(cv::Size(dw, dh), CV_16U, (void *)depthFrame.get_data(), cv::Mat::AUTO_STEP).clone();
+        m_filters.apply(m_cvDepthImage16u);
 
         // convert the 16u image to a 32 bit floating point representation
         m_cvDepthImage16u.convertTo(m_cvDepthImage32f, CV_32F);
@@ -118,7 +120,12 @@ void Source_Camera::captureImages()
     // Perform Gaussian Blur of data if turned on
     // Note: Guassian Blur must be applied before thresholding or else the zeros created by the threshold will blur with the real values.
     //       It must also be applied before the transformation, or else the values in the matrix that represent black space will blur with the image.
-    if (m_gaussianBlur)
+    if (m_gaussianBlur && m_blurMethod == 0)
+    {
+        PROFILE_SCOPE("Running Sum Blur");
+        m_blur.apply(m_cvDepthImage32f, m_cvBlurred32f);
+    }
+    else if (m_gaussianBlur)
     {
         PROFILE_SCOPE("OpenCV Gaussian Blur");
 
@@ -159,6 +166,9 @@ void Source_Camera::captureImages()
     // Calibration
     {
         PROFILE_SCOPE("Calibration TransformRect");
+
+        // frames share m_data with processors and must never change, so release it and warp into a fresh buffer
+        m_data = cv::Mat();
         m_warper.transformRect(m_cvNormalizedDepthImage32f, m_data);
     }
 }
@@ -188,8 +198,8 @@ void Source_Camera::imgui()
             {
                 ImGui::Indent();
 
-                ImGui::SliderFloat("Max Distance", &m_maxDistance, 0.0, 2.0);
-                ImGui::SliderFloat("Min Distance", &m_minDistance, 0.0, 2.0);
+                if (ImGui::SliderFloat("Max Distance", &m_maxDistance, 0.0, 2.0)) { m_calibrationVersion++; }
+                if (ImGui::SliderFloat("Min Distance", &m_minDistance, 0.0, 2.0)) { m_calibrationVersion++; }
                 ImGui::Unindent();
             }
 
@@ -217,7 +227,15 @@ void Source_Camera::imgui()
 
         if (ImGui::BeginTabItem("Filters"))
         {
-            ImGui::Checkbox("Gaussian Blur", &m_gaussianBlur);
+            if (ImGui::CollapsingHeader("Gaussian Blur"))
+            {
+                ImGui::Indent();
+                ImGui::Checkbox("Gaussian Blur", &m_gaussianBlur);
+                const char * methods[] = { "Running Sum (any sigma)", "OpenCV 17x17" };
+                ImGui::Combo("Blur Method", &m_blurMethod, methods, IM_ARRAYSIZE(methods));
+                m_blur.imgui(m_cvDepthImage32f);
+                ImGui::Unindent();
+            }
             m_filters.imgui();
 
             ImGui::EndTabItem();
@@ -282,6 +300,8 @@ void Source_Camera::save(Save & save) const
 {
     save.align = (int)m_alignment;
     save.gaussianBlur = m_gaussianBlur;
+    save.blurMethod = m_blurMethod;
+    m_blur.save(save);
     save.maxDistance = m_maxDistance;
     save.minDistance = m_minDistance;
     save.drawColor = m_drawColor;
@@ -294,8 +314,11 @@ void Source_Camera::load(const Save & save)
 {
     m_alignment = static_cast<alignment>(save.align);
     m_gaussianBlur = save.gaussianBlur;
+    m_blurMethod = save.blurMethod;
+    m_blur.load(save);
     m_maxDistance = save.maxDistance;
     m_minDistance = save.minDistance;
+    m_calibrationVersion++;
     m_drawColor = save.drawColor;
     m_drawDepth = save.drawDepth;
     m_fpsSetting = save.fpsSetting;
@@ -337,3 +360,13 @@ std::vector<Gesture> Source_Camera::getGestures()
     // Return reference to gesture array
     return m_handDetection.m_gestures;
 }
+
+cv::Mat Source_Camera::getRawDepth()
+{
+    return m_cvDepthImage16u;
+}
+
+size_t Source_Camera::getCalibrationVersion() const
+{
+    return m_calibrationVersion + m_warper.getVersion();
+}
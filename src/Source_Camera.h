@@ -30,6 +30,8 @@ class Source_Camera : public TopographySource
     rs2::align          m_alignment_depth = rs2::align(RS2_STREAM_DEPTH);
     rs2::align          m_alignment_color = rs2::align(RS2_STREAM_COLOR);
     bool                m_gaussianBlur = false;
+    int                 m_blurMethod = 1;           // 0 = running sum, 1 = OpenCV 17x17 kernel
+    RunningSumBlur      m_blur;
 
     int                 m_fpsSetting = 0;
 
@@ -49,6 +51,7 @@ class Source_Camera : public TopographySource
     float               m_depthFrameUnits = 0.0f;
     float               m_maxDistance = 1.13f;
     float               m_minDistance = 0.90f;
+    size_t              m_calibrationVersion = 0;
 
     bool                m_drawDepth = true;
     bool                m_drawColor = false;
@@ -71,5 +74,7 @@ public:
     cv::Mat getTopography();
 
     std::vector<Gesture> getGestures();
+    cv::Mat getRawDepth();
+    size_t getCalibrationVersion() const;
 
 };
\ No newline at end of file
@@ -11,10 +11,18 @@ void Source_Perlin::init()
 
 void Source_Perlin::calculateNoise()
 {
-    m_perlin = Perlin2DNew((int)(1 << m_seedSize), (int)(1 << m_seedSize), m_seed);
-    m_grid = m_perlin.GeneratePerlinNoise(m_octaves, m_persistance);
-    m_topography = cv::Mat(cv::Size((int)m_grid.width(), (int)m_grid.height()), CV_32F, (void *)m_grid.data(), cv::Mat::AUTO_STEP);
+    const int64 start = cv::getTickCount();
+    m_seedSize = std::clamp(m_seedSize, 1, 13);
+    m_octaves = std::clamp(m_octaves, 1, 20);
+
+    // a new mat every time so frames still held by processors stay valid
+    const int size = 1 << m_seedSize;
+    m_topography = cv::Mat(size, size, CV_32F);
+    fractalNoise(m_topography, m_seed, m_octaves, m_persistance, m_noiseType);
+    m_noiseMS = (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+
     m_image = Tools::matToSfImage(m_topography);
+    m_imageChanged = true;
 }
 
 
@@ -40,6 +48,14 @@ void Source_Perlin::imgui()
         calculateNoise();
     }
 
+    const char * noiseTypes[] = { "Value", "Gradient" };
+    if (ImGui::Combo("Noise", (int *)&m_noiseType, noiseTypes, IM_ARRAYSIZE(noiseTypes)))
+    {
+        calculateNoise();
+    }
+
+    ImGui::Text("Noise: %.2f ms", m_noiseMS);
+
     ImGui::Checkbox("Draw Grid", &m_drawGrid);
 }
 
@@ -49,8 +65,12 @@ void Source_Perlin::render(sf::RenderWindow & window)
 {
     const sf::Color gridColor(64, 64, 64);
 
-    m_texture.loadFromImage(m_image);
-    m_sprite.setTexture(m_texture, true);
+    if (m_imageChanged)
+    {
+        m_texture.loadFromImage(m_image);
+        m_sprite.setTexture(m_texture, true);
+        m_imageChanged = false;
+    }
 
 
     window.draw(m_sprite);
@@ -78,6 +98,7 @@ void Source_Perlin::save(Save & save) const
     save.seedSize = m_seedSize;
     save.persistance = m_persistance;
     save.drawGrid = m_drawGrid;
+    save.noiseType = (int)m_noiseType;
 }
 
 void Source_Perlin::load(const Save & save)
@@ -87,6 +108,7 @@ void Source_Perlin::load(const Save & save)
     m_seedSize = save.seedSize;
     m_persistance = save.persistance;
     m_drawGrid = save.drawGrid;
+    m_noiseType = (NoiseType)save.noiseType;
     calculateNoise();
 }
 
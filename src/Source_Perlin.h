@@ -2,27 +2,27 @@
 
 #include "Save.hpp"
 #include "TopographySource.h"
-#include "Perlin.hpp"
-#include "Grid.hpp"
+#include "FractalNoise.h"
 
 #include <opencv2/opencv.hpp>
 #include <SFML/Graphics.hpp>
 
 class Source_Perlin : public TopographySource
 {
-    Perlin2DNew         m_perlin;
     int                 m_octaves = 5;
     int                 m_seed = 0;
     int                 m_seedSize = 9;
     float               m_persistance = 0.5f;
     bool                m_drawGrid = false;
-    Grid<float>         m_grid;
+    NoiseType           m_noiseType = NoiseType::Value;
+    double              m_noiseMS = 0.0;
 
     cv::Mat             m_topography;
 
     sf::Image           m_image;
     sf::Texture         m_texture;
     sf::Sprite          m_sprite;
+    bool                m_imageChanged = true;  // the texture is only uploaded again after the noise changed
 
 
     void calculateNoise();
@@ -0,0 +1,242 @@
+#include "Source_Procedural.h"
+#include "Tools.h"
+#include "Profiler.hpp"
+
+#include "imgui.h"
+#include "imgui-SFML.h"
+
+#include <cmath>
+
+namespace
+{
+    const int       TileSize = 256;
+    const float     MinZoom = 1.0f / 16.0f;
+    const float     MaxZoom = 4096.0f;
+
+    int64_t floorDiv(double value, int divisor)
+    {
+        return (int64_t)std::floor(value / divisor);
+    }
+}
+
+void Source_Procedural::init()
+{
+    settingsChanged();
+}
+
+// the cached tiles belong to the old terrain
+void Source_Procedural::settingsChanged()
+{
+    m_octaves = std::clamp(m_octaves, 1, 30);
+    m_width = std::clamp(m_width, 8, 16384);
+    m_height = std::clamp(m_height, 8, 16384);
+    m_cacheTiles = std::max(m_cacheTiles, 1);
+    m_cache.clear();
+    m_viewChanged = true;
+}
+
+void Source_Procedural::calculateWindow()
+{
+    PROFILE_FUNCTION();
+
+    const int64 start = cv::getTickCount();
+    m_zoom = std::clamp(m_zoom, MinZoom, MaxZoom);
+
+    // a coarser level of detail as soon as one output pixel covers two pixels of the current one
+    m_lod = std::max(0, (int)std::floor(std::log2(m_zoom)));
+    const double lodScale = std::ldexp(1.0, m_lod);
+    const double step = m_zoom / lodScale;     // pixels of the level per output pixel
+
+    // the window in pixels of the level, one more pixel to the right and bottom for the bilinear filter
+    const double left = (m_centerX - m_width * 0.5 * m_zoom) / lodScale;
+    const double top = (m_centerY - m_height * 0.5 * m_zoom) / lodScale;
+    const int64_t tileX0 = floorDiv(left, TileSize);
+    const int64_t tileY0 = floorDiv(top, TileSize);
+    const int64_t tileX1 = floorDiv(left + m_width * step + 1, TileSize);
+    const int64_t tileY1 = floorDiv(top + m_height * step + 1, TileSize);
+    const int tilesX = (int)(tileX1 - tileX0 + 1);
+    const int tilesY = (int)(tileY1 - tileY0 + 1);
+
+    // keep at least this frame and the next one in the cache, or scrolling would generate every tile twice
+    m_visibleTiles = (size_t)tilesX * tilesY;
+    m_cache.setCapacity(std::max((size_t)m_cacheTiles, m_visibleTiles * 2));
+
+    std::vector<TileKey> keys;
+    std::vector<cv::Mat> tiles;
+    std::vector<size_t> missing;
+    for (int ty = 0; ty < tilesY; ty++)
+    {
+        for (int tx = 0; tx < tilesX; tx++)
+        {
+            const TileKey key = { tileX0 + tx, tileY0 + ty, m_lod };
+            keys.push_back(key);
+            tiles.push_back(m_cache.find(key));
+            if (tiles.back().empty()) { missing.push_back(keys.size() - 1); }
+        }
+    }
+    m_cacheMisses = missing.size();
+    m_cacheHits = keys.size() - missing.size();
+
+    // one tile per task, the strips inside fractalNoise run serially when called from a parallel loop
+    cv::parallel_for_(cv::Range(0, (int)missing.size()), [&](const cv::Range & range)
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            const TileKey & key = keys[missing[i]];
+            cv::Mat tile(TileSize, TileSize, CV_32F);
+            fractalNoise(tile, key.x * TileSize, key.y * TileSize, key.lod, m_seed, m_octaves, m_persistance, m_noiseType);
+            tiles[missing[i]] = tile;
+        }
+    });
+    for (size_t i : missing)
+    {
+        m_cache.insert(keys[i], tiles[i]);
+    }
+    m_generatedTiles += missing.size();
+
+    const int64 generated = cv::getTickCount();
+    m_generateMS = (generated - start) * 1000.0 / cv::getTickFrequency();
+
+    if (m_mosaic.rows != tilesY * TileSize || m_mosaic.cols != tilesX * TileSize)
+    {
+        m_mosaic = cv::Mat(tilesY * TileSize, tilesX * TileSize, CV_32F);
+    }
+    for (size_t i = 0; i < tiles.size(); i++)
+    {
+        const cv::Rect rect((int)(i % tilesX) * TileSize, (int)(i / tilesX) * TileSize, TileSize, TileSize);
+        tiles[i].copyTo(m_mosaic(rect));
+    }
+
+    // a new mat every time so frames still held by processors stay valid
+    const double offsetX = left - (double)tileX0 * TileSize;
+    const double offsetY = top - (double)tileY0 * TileSize;
+    const cv::Mat transform = (cv::Mat_<double>(2, 3) << step, 0, offsetX, 0, step, offsetY);
+    m_topography = cv::Mat(m_height, m_width, CV_32F);
+    cv::warpAffine(m_mosaic, m_topography, transform, m_topography.size(), cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_REPLICATE);
+    m_composeMS = (cv::getTickCount() - generated) * 1000.0 / cv::getTickFrequency();
+
+    m_viewChanged = false;
+    m_imageChanged = true;
+}
+
+
+void Source_Procedural::imgui()
+{
+    bool settings = false;
+    settings |= ImGui::InputInt("Seed", &m_seed, 1, 1000);
+    settings |= ImGui::InputInt("Octaves", &m_octaves, 1, 5);
+    settings |= ImGui::SliderFloat("Persistance", &m_persistance, 0, 2);
+
+    const char * noiseTypes[] = { "Value", "Gradient" };
+    settings |= ImGui::Combo("Noise", (int *)&m_noiseType, noiseTypes, IM_ARRAYSIZE(noiseTypes));
+
+    settings |= ImGui::InputInt("Width", &m_width, 64, 1024);
+    settings |= ImGui::InputInt("Height", &m_height, 64, 1024);
+    if (settings) { settingsChanged(); }
+
+    m_viewChanged |= ImGui::InputDouble("Center X", &m_centerX, 256.0, 4096.0, "%.1f");
+    m_viewChanged |= ImGui::InputDouble("Center Y", &m_centerY, 256.0, 4096.0, "%.1f");
+    m_viewChanged |= ImGui::SliderFloat("Zoom", &m_zoom, MinZoom, MaxZoom, "%.3f", ImGuiSliderFlags_Logarithmic);
+    ImGui::SliderFloat("Scroll X", &m_scrollX, -2000, 2000);
+    ImGui::SliderFloat("Scroll Y", &m_scrollY, -2000, 2000);
+
+    if (ImGui::InputInt("Cache Tiles", &m_cacheTiles, 16, 256))
+    {
+        m_cacheTiles = std::max(m_cacheTiles, 1);
+        m_viewChanged = true;
+    }
+
+    ImGui::Text("Level of Detail: %d", m_lod);
+    ImGui::Text("Tiles: %zu visible, %zu / %zu cached", m_visibleTiles, m_cache.size(), m_cache.capacity());
+    ImGui::Text("Last Frame: %zu hits, %zu misses", m_cacheHits, m_cacheMisses);
+    ImGui::Text("Generated: %zu tiles", m_generatedTiles);
+    ImGui::Text("Generate: %.2f ms", m_generateMS);
+    ImGui::Text("Compose: %.2f ms", m_composeMS);
+}
+
+
+
+void Source_Procedural::render(sf::RenderWindow & window)
+{
+    if (m_imageChanged && !m_topography.empty())
+    {
+        m_image = Tools::matToSfImage(m_topography);
+        m_texture.loadFromImage(m_image);
+        m_sprite.setTexture(m_texture, true);
+        m_imageChanged = false;
+    }
+
+    window.draw(m_sprite);
+}
+
+void Source_Procedural::processEvent(const sf::Event & event, const sf::Vector2f & mouse)
+{
+    // panning moves a quarter of the window, so it feels the same at every zoom
+    const double panX = m_width * 0.25 * m_zoom;
+    const double panY = m_height * 0.25 * m_zoom;
+
+    if (event.type == sf::Event::KeyPressed)
+    {
+        switch (event.key.code)
+        {
+        case sf::Keyboard::R: { m_seed += 1; settingsChanged(); break; }
+        case sf::Keyboard::Left: { m_centerX -= panX; m_viewChanged = true; break; }
+        case sf::Keyboard::Right: { m_centerX += panX; m_viewChanged = true; break; }
+        case sf::Keyboard::Up: { m_centerY -= panY; m_viewChanged = true; break; }
+        case sf::Keyboard::Down: { m_centerY += panY; m_viewChanged = true; break; }
+        }
+    }
+
+    if (event.type == sf::Event::MouseWheelScrolled)
+    {
+        m_zoom = std::clamp(m_zoom * std::pow(2.0f, -event.mouseWheelScroll.delta * 0.25f), MinZoom, MaxZoom);
+        m_viewChanged = true;
+    }
+}
+
+void Source_Procedural::save(Save & save) const
+{
+    save.proceduralSeed = m_seed;
+    save.proceduralOctaves = m_octaves;
+    save.proceduralPersistance = m_persistance;
+    save.proceduralNoiseType = (int)m_noiseType;
+    save.proceduralWidth = m_width;
+    save.proceduralHeight = m_height;
+    save.proceduralZoom = m_zoom;
+    save.proceduralScrollX = m_scrollX;
+    save.proceduralScrollY = m_scrollY;
+    save.proceduralCacheTiles = m_cacheTiles;
+}
+
+void Source_Procedural::load(const Save & save)
+{
+    m_seed = save.proceduralSeed;
+    m_octaves = save.proceduralOctaves;
+    m_persistance = save.proceduralPersistance;
+    m_noiseType = (NoiseType)save.proceduralNoiseType;
+    m_width = save.proceduralWidth;
+    m_height = save.proceduralHeight;
+    m_zoom = save.proceduralZoom;
+    m_scrollX = save.proceduralScrollX;
+    m_scrollY = save.proceduralScrollY;
+    m_cacheTiles = save.proceduralCacheTiles;
+    settingsChanged();
+}
+
+cv::Mat Source_Procedural::getTopography()
+{
+    // a long pause, like dragging the window, should not jump far ahead
+    const auto now = std::chrono::steady_clock::now();
+    const double dt = std::min(std::chrono::duration<double>(now - m_lastFrame).count(), 0.1);
+    m_lastFrame = now;
+
+    if (m_scrollX != 0.0f || m_scrollY != 0.0f)
+    {
+        m_centerX += m_scrollX * m_zoom * dt;
+        m_centerY += m_scrollY * m_zoom * dt;
+        m_viewChanged = true;
+    }
+
+    if (m_viewChanged) { calculateWindow(); }
+    return m_topography;
+}
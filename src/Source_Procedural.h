@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Save.hpp"
+#include "TopographySource.h"
+#include "FractalNoise.h"
+#include "TileCache.hpp"
+
+#include <opencv2/opencv.hpp>
+#include <SFML/Graphics.hpp>
+#include <chrono>
+
+// A window that scrolls and zooms over terrain that goes on forever
+// The terrain is generated in tiles of 256x256 when the window first reaches them and the most recently used tiles are
+// kept in a TileCache. Every tile is generated on its own from the lattice hashes of FractalNoise, so the missing
+// tiles of a frame are generated in parallel. Zoomed out, tiles of a coarser level of detail are used so a frame
+// never needs more than about twice its own pixels in tiles. The output size can be set much larger than the camera
+// to load test the processors.
+class Source_Procedural : public TopographySource
+{
+    int                 m_seed = 0;
+    int                 m_octaves = 10;
+    float               m_persistance = 0.5f;
+    NoiseType           m_noiseType = NoiseType::Gradient;
+    int                 m_width = 1280;
+    int                 m_height = 720;
+    double              m_centerX = 0.0;    // in pixels of the finest level
+    double              m_centerY = 0.0;
+    float               m_zoom = 1.0f;      // pixels of the finest level per output pixel
+    float               m_scrollX = 0.0f;   // in output pixels per second
+    float               m_scrollY = 0.0f;
+    int                 m_cacheTiles = 256;
+
+    TileCache           m_cache;
+    cv::Mat             m_mosaic;           // the visible tiles next to each other, reused between frames
+    cv::Mat             m_topography;
+    bool                m_viewChanged = true;
+    std::chrono::steady_clock::time_point m_lastFrame = std::chrono::steady_clock::now();
+
+    // stats of the last frame that changed
+    int                 m_lod = 0;
+    size_t              m_visibleTiles = 0;
+    size_t              m_generatedTiles = 0;
+    size_t              m_cacheHits = 0;
+    size_t              m_cacheMisses = 0;
+    double              m_generateMS = 0.0;
+    double              m_composeMS = 0.0;
+
+    sf::Image           m_image;
+    sf::Texture         m_texture;
+    sf::Sprite          m_sprite;
+    bool                m_imageChanged = true;  // the texture is only uploaded again after the window changed
+
+    void settingsChanged();
+    void calculateWindow();
+
+public:
+    void init();
+    void imgui();
+    void render(sf::RenderWindow & window);
+    void processEvent(const sf::Event & event, const sf::Vector2f & mouse);
+    void save(Save & save) const;
+    void load(const Save & save);
+
+    cv::Mat getTopography();
+};
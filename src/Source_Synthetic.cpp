@@ -0,0 +1,416 @@
+#include "Source_Synthetic.h"
+#include "FractalNoise.h"
+#include "Tools.h"
+#include "Profiler.hpp"
+
+#include <cmath>
+
+namespace
+{
+    const float DepthUnits = 0.001f;        // meters per raw depth unit, the default of the RealSense D400 cameras
+    const int   MaxHands = 16;
+    const char * PoseNames[] = { "None", "High Five", "OK", "Peace", "Rock", "Judgement" };
+
+    // lowbias32 from Chris Wellons' hash prospector, the same as FractalNoise
+    inline uint32_t hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // the random number k of a hand, in [0, 1)
+    inline float random(uint32_t key, uint32_t k)
+    {
+        return hash(key + k * 0x9E3779B9U) * (1.0f / 4294967296.0f);
+    }
+
+    // the D400 depth camera sees about 1.9 meters across for every meter away
+    inline float pixelsPerMeter(int width, float depth)
+    {
+        return width / (1.9f * depth);
+    }
+}
+
+void Source_Synthetic::init()
+{
+    makeSand();
+}
+
+void Source_Synthetic::makeSand()
+{
+    const int width = m_fpsSetting == 0 ? 1280 : 848;
+    const int height = m_fpsSetting == 0 ? 720 : 480;
+
+    // dunes of a few hundred pixels between 1.12 and 0.92 meters from the camera
+    m_sand = cv::Mat(height, width, CV_32F);
+    fractalNoise(m_sand, 0, 0, 0, m_seed, 8, 0.5f, NoiseType::Gradient);
+    m_sand = 1.12f - m_sand * 0.2f;
+    m_frame = 0;
+    m_handDetection.reset();
+}
+
+void Source_Synthetic::addFinger(const cv::Point2f & wrist, const cv::Point2f & along, const cv::Point2f & across, float pixelsPerMeter, float depth,
+                                 std::initializer_list<cv::Point2f> joints, float radius)
+{
+    // joints are in meters on the hand, along points from the wrist to the fingers and across to the thumb
+    auto toPixels = [&](const cv::Point2f & p) { return wrist + (along * p.x + across * p.y) * pixelsPerMeter; };
+
+    const cv::Point2f * previous = nullptr;
+    for (const cv::Point2f & joint : joints)
+    {
+        if (previous)
+        {
+            Capsule c;
+            c.a = toPixels(*previous);
+            c.b = toPixels(joint);
+            c.radiusA = c.radiusB = radius * pixelsPerMeter;
+            c.depthA = c.depthB = depth + 0.005f;
+            c.thickness = radius;
+            m_capsules.push_back(c);
+        }
+        previous = &joint;
+    }
+}
+
+void Source_Synthetic::addHand(int hand, double time, int width, int height)
+{
+    const uint32_t key = hash((uint32_t)m_seed * 0x9E3779B9U + (uint32_t)hand);
+    const float speed = m_speed;
+    const float tau = 6.2831853f;
+
+    // the hand wanders over the sandbox, the arm comes in from one of the edges
+    const float wx = (0.3f + 0.4f * random(key, 2)) * speed;
+    const float wy = (0.3f + 0.4f * random(key, 3)) * speed;
+    const cv::Point2f wrist(width * (0.5f + 0.3f * (float)std::sin(wx * time + tau * random(key, 4))),
+                            height * (0.5f + 0.3f * (float)std::sin(wy * time + tau * random(key, 5))));
+    const float depth = 0.70f + 0.14f * (0.5f + 0.5f * (float)std::sin(0.7f * speed * time + tau * random(key, 6)));
+    const float ppm = m_handScale * pixelsPerMeter(width, depth);
+
+    const float anchor = 0.2f + 0.6f * random(key, 1);
+    const float outside = 0.35f * ppm;
+    cv::Point2f shoulder;
+    switch ((int)(random(key, 0) * 4))
+    {
+    case 0: shoulder = { anchor * width, height + outside }; break;
+    case 1: shoulder = { anchor * width, -outside }; break;
+    case 2: shoulder = { -outside, anchor * height }; break;
+    default: shoulder = { width + outside, anchor * height }; break;
+    }
+
+    // the hand points away from the shoulder and turns a little at the wrist
+    const cv::Point2f arm = wrist - shoulder;
+    const float twist = 0.3f * (float)std::sin(1.3f * speed * time + tau * random(key, 8));
+    const float angle = std::atan2(arm.y, arm.x) + twist;
+    const cv::Point2f along(std::cos(angle), std::sin(angle));
+    const float side = random(key, 7) < 0.5f ? 1.0f : -1.0f;       // left and right hands are mirrored
+    const cv::Point2f across = cv::Point2f(-along.y, along.x) * side;
+
+    HandPose pose = (HandPose)(m_pose - 1);
+    if (m_pose == 0)
+    {
+        const double cycle = std::floor(time / std::max(m_poseSeconds, 0.1f) + random(key, 10));
+        pose = (HandPose)(((int)(random(key, 9) * 6) + (int64_t)cycle) % 6);
+    }
+    m_poses.push_back(pose);
+
+    Capsule forearm;
+    forearm.a = shoulder;
+    forearm.b = wrist;
+    forearm.radiusA = 0.055f * ppm;
+    forearm.radiusB = 0.03f * ppm;
+    forearm.depthA = depth - 0.3f;
+    forearm.depthB = depth + 0.01f;
+    forearm.thickness = 0.04f;
+    m_capsules.push_back(forearm);
+
+    Capsule palm;
+    palm.a = wrist + along * (0.025f * ppm);
+    palm.b = wrist + along * (0.075f * ppm);
+    palm.radiusA = palm.radiusB = 0.042f * ppm;
+    palm.depthA = palm.depthB = depth;
+    palm.thickness = 0.02f;
+    m_capsules.push_back(palm);
+
+    // knuckles of the index, middle, ring and pinky finger and the base of the thumb, in meters on the hand
+    const cv::Point2f knuckles[4] = { { 0.095f, 0.028f }, { 0.100f, 0.009f }, { 0.097f, -0.010f }, { 0.088f, -0.028f } };
+    const cv::Point2f thumb(0.03f, 0.035f);
+    const float fingerRadius = 0.009f, thumbRadius = 0.011f;
+
+    auto finger = [&](int f, float degrees, float length)
+    {
+        const float a = degrees * 0.01745329f;
+        const cv::Point2f tip = knuckles[f] + cv::Point2f(std::cos(a), std::sin(a)) * length;
+        addFinger(wrist, along, across, ppm, depth, { knuckles[f], tip }, fingerRadius);
+    };
+    auto extended = [&](int f, float degrees) { finger(f, degrees, f == 1 ? 0.085f : f == 3 ? 0.06f : 0.077f); };
+    auto curled = [&](int f) { finger(f, 0.0f, 0.025f); };
+    auto thumbTo = [&](const cv::Point2f & tip) { addFinger(wrist, along, across, ppm, depth, { thumb, tip }, thumbRadius); };
+    auto thumbFolded = [&]() { thumbTo({ 0.075f, 0.0f }); };
+
+    switch (pose)
+    {
+    case HandPose::Fist:
+        for (int f = 0; f < 4; f++) { curled(f); }
+        thumbFolded();
+        break;
+    case HandPose::HighFive:
+        extended(0, 12); extended(1, 0); extended(2, -12); extended(3, -25);
+        thumbTo(thumb + cv::Point2f(0.037f, 0.053f));
+        break;
+    case HandPose::OK:
+        // thumb and index meet in a ring that leaves a hole in the hand
+        addFinger(wrist, along, across, ppm, depth, { knuckles[0], { 0.145f, 0.06f }, { 0.12f, 0.095f } }, fingerRadius);
+        addFinger(wrist, along, across, ppm, depth, { thumb, { 0.07f, 0.09f }, { 0.12f, 0.095f } }, thumbRadius);
+        extended(1, 0); extended(2, -12); extended(3, -25);
+        break;
+    case HandPose::Peace:
+        extended(0, 14); extended(1, -6); curled(2); curled(3);
+        thumbFolded();
+        break;
+    case HandPose::Rock:
+        extended(0, 8); curled(1); curled(2); extended(3, -20);
+        thumbFolded();
+        break;
+    case HandPose::Judgement:
+        for (int f = 0; f < 4; f++) { curled(f); }
+        thumbTo(thumb + cv::Point2f(-0.006f, 0.065f));
+        break;
+    }
+}
+
+void Source_Synthetic::generate()
+{
+    PROFILE_FUNCTION();
+
+    const int64 start = cv::getTickCount();
+    const int width = m_sand.cols, height = m_sand.rows;
+    const double time = m_frame / (m_fpsSetting == 0 ? 30.0 : 90.0);
+
+    m_capsules.clear();
+    m_poses.clear();
+    m_hands = std::clamp(m_hands, 0, MaxHands);
+    m_pose = std::clamp(m_pose, 0, 6);
+    for (int i = 0; i < m_hands; i++)
+    {
+        addHand(i, time, width, height);
+    }
+
+    // only the rows inside a capsule have to look at it
+    const cv::Rect frame(0, 0, width, height);
+    for (Capsule & c : m_capsules)
+    {
+        const float r = std::max(c.radiusA, c.radiusB);
+        const cv::Point2f low(std::min(c.a.x, c.b.x) - r, std::min(c.a.y, c.b.y) - r);
+        const cv::Point2f high(std::max(c.a.x, c.b.x) + r, std::max(c.a.y, c.b.y) + r);
+        c.bounds = cv::Rect(cv::Point((int)std::floor(low.x), (int)std::floor(low.y)), cv::Point((int)std::ceil(high.x) + 1, (int)std::ceil(high.y) + 1)) & frame;
+    }
+
+    // a new raw depth every frame because frames hand it to processors
+    m_depth16u = cv::Mat(height, width, CV_16U);
+    m_depth32f.create(height, width, CV_32F);
+    const uint32_t frameKey = hash((uint32_t)m_seed ^ hash((uint32_t)m_frame));
+    const float noise = m_depthNoise * 2.0f / 4294967296.0f;
+    cv::parallel_for_(cv::Range(0, height), [&](const cv::Range & range)
+    {
+        for (int y = range.start; y < range.end; y++)
+        {
+            float * depth = m_depth32f.ptr<float>(y);
+            uint16_t * raw = m_depth16u.ptr<uint16_t>(y);
+            std::copy(m_sand.ptr<float>(y), m_sand.ptr<float>(y) + width, depth);
+
+            for (const Capsule & c : m_capsules)
+            {
+                if (y < c.bounds.y || y >= c.bounds.y + c.bounds.height) { continue; }
+
+                const cv::Point2f d = c.b - c.a;
+                const float lengthSq = d.dot(d);
+                const float inverse = lengthSq > 0.0f ? 1.0f / lengthSq : 0.0f;
+                for (int x = c.bounds.x; x < c.bounds.x + c.bounds.width; x++)
+                {
+                    const float px = x - c.a.x, py = y - c.a.y;
+                    const float t = std::clamp((px * d.x + py * d.y) * inverse, 0.0f, 1.0f);
+                    const float ex = px - t * d.x, ey = py - t * d.y;
+                    const float r = c.radiusA + t * (c.radiusB - c.radiusA);
+                    const float distanceSq = ex * ex + ey * ey;
+                    if (distanceSq >= r * r) { continue; }
+
+                    const float z = c.depthA + t * (c.depthB - c.depthA) - c.thickness * std::sqrt(1.0f - distanceSq / (r * r));
+                    depth[x] = std::min(depth[x], z);
+                }
+            }
+
+            // millimeters with sensor noise like the camera delivers them, then back to meters the way Source_Camera does
+            const uint32_t rowKey = frameKey + (uint32_t)y * (uint32_t)width;
+            for (int x = 0; x < width; x++)
+            {
+                const float n = (hash(rowKey + (uint32_t)x) * noise - m_depthNoise);
+                raw[x] = cv::saturate_cast<uint16_t>(depth[x] / DepthUnits + n);
+                depth[x] = raw[x] * DepthUnits;
+            }
+        }
+    });
+    m_generateMS = (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+
+    if (m_detectHands)
+    {
+        PROFILE_SCOPE("Hand Detection");
+        m_handDetection.removeHands(m_depth32f, m_depth32f, m_maxDistance, m_minDistance);
+    }
+
+    // the same normalization as Source_Camera, into a new mat so frames still held by processors stay valid
+    {
+        PROFILE_SCOPE("Threshold and Normalize");
+        cv::Mat normalized = 1.f - (m_depth32f - m_minDistance) / (m_maxDistance - m_minDistance);
+        cv::threshold(normalized, normalized, 0.0, 255, cv::THRESH_TOZERO);
+        cv::threshold(normalized, normalized, 1.0, 255, cv::THRESH_TRUNC);
+        m_topography = normalized;
+    }
+
+    m_frameMS = (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+    m_frame++;
+    m_imageChanged = true;
+}
+
+void Source_Synthetic::imgui()
+{
+    if (ImGui::Button(m_pause ? "Unpause" : "Pause"))
+    {
+        m_pause = !m_pause;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Restart"))
+    {
+        m_frame = 0;
+        m_handDetection.reset();
+    }
+
+    if (ImGui::InputInt("Seed", &m_seed, 1, 1000)) { makeSand(); }
+
+    const char * settings[] = { "1280w 720h 30fps", "848w 480h 90fps" };
+    if (ImGui::Combo("FPS / Resolution", &m_fpsSetting, settings, IM_ARRAYSIZE(settings))) { makeSand(); }
+
+    ImGui::SliderInt("Hands", &m_hands, 0, MaxHands);
+    ImGui::SliderFloat("Speed", &m_speed, 0.0f, 5.0f);
+    const char * poses[] = { "Cycle", "None", "High Five", "OK", "Peace", "Rock", "Judgement" };
+    ImGui::Combo("Pose", &m_pose, poses, IM_ARRAYSIZE(poses));
+    if (m_pose == 0) { ImGui::SliderFloat("Pose Seconds", &m_poseSeconds, 0.1f, 10.0f); }
+    ImGui::SliderFloat("Hand Scale", &m_handScale, 0.5f, 2.0f);
+    ImGui::SliderFloat("Depth Noise (mm)", &m_depthNoise, 0.0f, 10.0f);
+
+    if (ImGui::CollapsingHeader("Thresholds"))
+    {
+        ImGui::Indent();
+        if (ImGui::SliderFloat("Max Distance", &m_maxDistance, 0.0, 2.0)) { m_calibrationVersion++; }
+        if (ImGui::SliderFloat("Min Distance", &m_minDistance, 0.0, 2.0)) { m_calibrationVersion++; }
+        ImGui::Unindent();
+    }
+
+    ImGui::Text("Frame: %zu", m_frame);
+    ImGui::Text("Generate: %.2f ms", m_generateMS);
+    ImGui::Text("Frame: %.2f ms", m_frameMS);
+    for (size_t i = 0; i < m_poses.size(); i++)
+    {
+        ImGui::Text("Hand %zu: %s", i, PoseNames[(int)m_poses[i]]);
+    }
+
+    if (ImGui::CollapsingHeader("Hand Recognition"))
+    {
+        ImGui::Checkbox("Filter Hands", &m_detectHands);
+        ImGui::Checkbox("Show Gesture Recognition", &m_showGestureRecognition);
+        m_handDetection.imgui();
+    }
+}
+
+void Source_Synthetic::render(sf::RenderWindow & window)
+{
+    if (m_imageChanged && !m_topography.empty())
+    {
+        m_image = Tools::matToSfImage(m_topography);
+        m_texture.loadFromImage(m_image);
+        m_sprite.setTexture(m_texture, true);
+        m_imageChanged = false;
+    }
+    window.draw(m_sprite);
+
+    if (m_showGestureRecognition)
+    {
+        auto & texture = m_handDetection.getTexture();
+        m_gestureGraphic.setTexture(texture, true);
+        window.draw(m_gestureGraphic);
+    }
+}
+
+void Source_Synthetic::processEvent(const sf::Event & event, const sf::Vector2f & mouse)
+{
+    if (event.type == sf::Event::KeyPressed)
+    {
+        switch (event.key.code)
+        {
+        case sf::Keyboard::P: { m_pause = !m_pause; break; }
+        case sf::Keyboard::R: { m_frame = 0; m_handDetection.reset(); break; }
+        }
+    }
+    m_handDetection.eventHandling(event);
+}
+
+void Source_Synthetic::save(Save & save) const
+{
+    save.syntheticSeed = m_seed;
+    save.syntheticFpsSetting = m_fpsSetting;
+    save.syntheticHands = m_hands;
+    save.syntheticSpeed = m_speed;
+    save.syntheticPose = m_pose;
+    save.syntheticPoseSeconds = m_poseSeconds;
+    save.syntheticHandScale = m_handScale;
+    save.syntheticDepthNoise = m_depthNoise;
+    save.syntheticMaxDistance = m_maxDistance;
+    save.syntheticMinDistance = m_minDistance;
+    save.syntheticDetectHands = m_detectHands;
+}
+
+void Source_Synthetic::load(const Save & save)
+{
+    m_seed = save.syntheticSeed;
+    m_fpsSetting = save.syntheticFpsSetting;
+    m_hands = save.syntheticHands;
+    m_speed = save.syntheticSpeed;
+    m_pose = save.syntheticPose;
+    m_poseSeconds = save.syntheticPoseSeconds;
+    m_handScale = save.syntheticHandScale;
+    m_depthNoise = save.syntheticDepthNoise;
+    m_maxDistance = save.syntheticMaxDistance;
+    m_minDistance = save.syntheticMinDistance;
+    m_detectHands = save.syntheticDetectHands;
+    m_calibrationVersion++;
+    makeSand();
+}
+
+cv::Mat Source_Synthetic::getTopography()
+{
+    if (!m_pause || m_topography.empty()) { generate(); }
+    return m_topography;
+}
+
+std::vector<Gesture> Source_Synthetic::getGestures()
+{
+    if (m_pause) { return m_handDetection.m_gestures; }
+
+    // the synthetic frame needs no calibration, the whole frame is the sandbox
+    std::vector<cv::Point> box = { { 0, 0 }, { m_sand.cols - 1, 0 }, { m_sand.cols - 1, m_sand.rows - 1 }, { 0, m_sand.rows - 1 } };
+    m_handDetection.identifyGestures(box);
+    return m_handDetection.m_gestures;
+}
+
+cv::Mat Source_Synthetic::getRawDepth()
+{
+    return m_depth16u;
+}
+
+size_t Source_Synthetic::getCalibrationVersion() const
+{
+    return m_calibrationVersion;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Save.hpp"
+#include "TopographySource.h"
+#include "HandDetection.h"
+
+#include <opencv2/opencv.hpp>
+#include <SFML/Graphics.hpp>
+
+// hand shapes the synthetic source can make, in the order of the class labels of HandDetection
+enum class HandPose
+{
+    Fist,           // "None"
+    HighFive,
+    OK,
+    Peace,
+    Rock,
+    Judgement       // fist with the thumb out
+};
+
+// Depth frames of a sandbox with hands and arms moving over it, for testing without a camera or people
+// The sand is fractal noise and the hands are built from rounded capsules for the palm, fingers and arm.
+// Every frame is a function of the seed and the frame number only, so a run can be repeated exactly.
+// The depth is made like the camera makes it: millimeters in a CV_16U raw depth, converted to meters,
+// the hands removed by HandDetection and normalized between the min and max distance.
+class Source_Synthetic : public TopographySource
+{
+    // a segment with a radius that changes along it, in pixels, and the depth of its top in meters
+    struct Capsule
+    {
+        cv::Point2f a, b;
+        float       radiusA = 0.0f, radiusB = 0.0f;
+        float       depthA = 0.0f, depthB = 0.0f;
+        float       thickness = 0.0f;       // how far the middle sticks out above the depth of the segment, in meters
+        cv::Rect    bounds;
+    };
+
+    int                 m_seed = 0;
+    int                 m_fpsSetting = 1;           // like the camera, 0 = 1280x720 at 30 fps, 1 = 848x480 at 90 fps
+    int                 m_hands = 2;
+    float               m_speed = 1.0f;
+    int                 m_pose = 0;                 // 0 cycles through the poses, otherwise the pose + 1
+    float               m_poseSeconds = 2.0f;
+    float               m_handScale = 1.0f;
+    float               m_depthNoise = 1.0f;        // in millimeters
+    float               m_maxDistance = 1.13f;
+    float               m_minDistance = 0.90f;
+    bool                m_detectHands = true;
+    bool                m_pause = false;
+    bool                m_showGestureRecognition = false;
+
+    HandDetection       m_handDetection;
+
+    size_t              m_frame = 0;
+    size_t              m_calibrationVersion = 0;
+    std::vector<Capsule>  m_capsules;
+    std::vector<HandPose> m_poses;              // the pose of every hand in the last frame
+
+    cv::Mat             m_sand;                 // depth of the sand in meters
+    cv::Mat             m_depth16u;
+    cv::Mat             m_depth32f;
+    cv::Mat             m_topography;
+    double              m_generateMS = 0.0;
+    double              m_frameMS = 0.0;
+
+    sf::Image           m_image;
+    sf::Texture         m_texture;
+    sf::Sprite          m_sprite;
+    bool                m_imageChanged = true;
+    sf::Sprite          m_gestureGraphic;
+
+    void makeSand();
+    void addHand(int hand, double time, int width, int height);
+    void addFinger(const cv::Point2f & wrist, const cv::Point2f & along, const cv::Point2f & across, float pixelsPerMeter, float depth,
+                   std::initializer_list<cv::Point2f> joints, float radius);
+    void generate();
+
+public:
+    void init();
+    void imgui();
+    void render(sf::RenderWindow & window);
+    void processEvent(const sf::Event & event, const sf::Vector2f & mouse);
+    void save(Save & save) const;
+    void load(const Save & save);
+
+    cv::Mat getTopography();
+
+    std::vector<Gesture> getGestures();
+    cv::Mat getRawDepth();
+    size_t getCalibrationVersion() const;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that run batches of independent tasks
+// The calling thread takes part in the batch and run() returns once every task is finished
+class TaskPool
+{
+    std::vector<std::thread>        m_workers;
+    std::mutex                      m_lock;
+    std::condition_variable         m_wake;
+    std::condition_variable         m_done;
+
+    std::function<void(size_t)>     m_task;
+    size_t                          m_taskCount = 0;
+    std::atomic<size_t>             m_nextTask = 0;
+    size_t                          m_remaining = 0;
+    size_t                          m_busy = 0;
+    size_t                          m_generation = 0;
+    bool                            m_running = true;
+
+    // grab task indices until the batch is exhausted, returns how many this thread completed
+    size_t work()
+    {
+        size_t completed = 0;
+        size_t i;
+        while ((i = m_nextTask.fetch_add(1)) < m_taskCount)
+        {
+            m_task(i);
+            completed++;
+        }
+        return completed;
+    }
+
+    void finish(size_t completed, bool worker)
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_remaining -= completed;
+        if (worker) { m_busy--; }
+        if (m_remaining == 0 && m_busy == 0) { m_done.notify_all(); }
+    }
+
+    void workerLoop()
+    {
+        size_t seenGeneration = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                m_wake.wait(lock, [&]() { return !m_running || m_generation != seenGeneration; });
+                if (!m_running) { return; }
+                seenGeneration = m_generation;
+                m_busy++;
+            }
+
+            finish(work(), true);
+        }
+    }
+
+public:
+
+    TaskPool(size_t threads = std::max(1u, std::thread::hardware_concurrency()) - 1)
+    {
+        for (size_t i = 0; i < threads; i++)
+        {
+            m_workers.emplace_back(&TaskPool::workerLoop, this);
+        }
+    }
+
+    ~TaskPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_running = false;
+        }
+        m_wake.notify_all();
+        for (auto & worker : m_workers) { worker.join(); }
+    }
+
+    TaskPool(const TaskPool &) = delete;
+    TaskPool & operator=(const TaskPool &) = delete;
+
+    // number of threads that can work on a batch, including the caller
+    size_t size() const
+    {
+        return m_workers.size() + 1;
+    }
+
+    // calls task(i) for every i in [0, count), spread over the pool
+    // only one batch runs at a time, run() must not be called from inside a task
+    void run(size_t count, const std::function<void(size_t)> & task)
+    {
+        if (count == 0) { return; }
+
+        // no point waking anybody up for a single task
+        if (count == 1 || m_workers.empty())
+        {
+            for (size_t i = 0; i < count; i++) { task(i); }
+            return;
+        }
+
+        {
+            // wait for stragglers from the previous batch to leave work() before touching its state
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_done.wait(lock, [&]() { return m_busy == 0; });
+            m_task = task;
+            m_taskCount = count;
+            m_nextTask = 0;
+            m_remaining = count;
+            m_generation++;
+        }
+        m_wake.notify_all();
+
+        finish(work(), false);
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_done.wait(lock, [&]() { return m_remaining == 0; });
+    }
+
+    void run(const std::vector<std::function<void()>> & tasks)
+    {
+        run(tasks.size(), [&](size_t i) { tasks[i](); });
+    }
+};
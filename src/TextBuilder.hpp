@@ -0,0 +1,71 @@
+#pragma once
+
+#include <charconv>
+#include <string>
+
+// Appends text and integers to one string that keeps its memory between uses
+// Request bodies with hundreds of thousands of records are built here instead of in a stringstream,
+// numbers are written with to_chars straight into the string without locales or temporaries
+class TextBuilder
+{
+    std::string m_text;
+
+public:
+
+    TextBuilder(size_t reserve = 0)
+    {
+        m_text.reserve(reserve);
+    }
+
+    inline TextBuilder & operator << (const std::string & text)
+    {
+        m_text.append(text);
+        return *this;
+    }
+
+    inline TextBuilder & operator << (const char * text)
+    {
+        m_text.append(text);
+        return *this;
+    }
+
+    inline TextBuilder & operator << (char c)
+    {
+        m_text.push_back(c);
+        return *this;
+    }
+
+    inline TextBuilder & operator << (int value)
+    {
+        char digits[16];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        m_text.append(digits, result.ptr);
+        return *this;
+    }
+
+    // keeps the memory for the next text
+    inline void clear()
+    {
+        m_text.clear();
+    }
+
+    inline bool empty() const
+    {
+        return m_text.empty();
+    }
+
+    inline size_t size() const
+    {
+        return m_text.size();
+    }
+
+    inline std::string & str()
+    {
+        return m_text;
+    }
+
+    inline const std::string & str() const
+    {
+        return m_text;
+    }
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+#include <opencv2/opencv.hpp>
+
+// Where a tile sits in an unbounded world, in tiles of its level of detail
+struct TileKey
+{
+    int64_t x = 0;
+    int64_t y = 0;
+    int     lod = 0;
+
+    inline bool operator == (const TileKey & other) const
+    {
+        return x == other.x && y == other.y && lod == other.lod;
+    }
+};
+
+struct TileKeyHash
+{
+    inline size_t operator () (const TileKey & key) const
+    {
+        uint64_t h = (uint64_t)key.x * 0x9E3779B97F4A7C15ull;
+        h ^= (uint64_t)key.y * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+        h ^= (uint64_t)key.lod * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+        return (size_t)h;
+    }
+};
+
+// Keeps the most recently used tiles and drops the one used longest ago when it is full
+// Tiles are reference counted mats, a tile that is dropped stays valid for whoever still holds it.
+class TileCache
+{
+    struct Entry
+    {
+        cv::Mat                         tile;
+        std::list<TileKey>::iterator    use;    // its place in m_uses
+    };
+
+    std::unordered_map<TileKey, Entry, TileKeyHash> m_tiles;
+    std::list<TileKey>                              m_uses;     // most recently used first
+    size_t                                          m_capacity = 256;
+
+    void evict()
+    {
+        while (m_tiles.size() > m_capacity)
+        {
+            m_tiles.erase(m_uses.back());
+            m_uses.pop_back();
+        }
+    }
+
+public:
+
+    TileCache(size_t capacity = 256)
+        : m_capacity(capacity)
+    {
+    }
+
+    // the tile or an empty mat, a tile that is found counts as used
+    cv::Mat find(const TileKey & key)
+    {
+        auto it = m_tiles.find(key);
+        if (it == m_tiles.end()) { return cv::Mat(); }
+        m_uses.splice(m_uses.begin(), m_uses, it->second.use);
+        return it->second.tile;
+    }
+
+    void insert(const TileKey & key, const cv::Mat & tile)
+    {
+        auto it = m_tiles.find(key);
+        if (it != m_tiles.end())
+        {
+            it->second.tile = tile;
+            m_uses.splice(m_uses.begin(), m_uses, it->second.use);
+            return;
+        }
+        m_uses.push_front(key);
+        m_tiles[key] = { tile, m_uses.begin() };
+        evict();
+    }
+
+    void clear()
+    {
+        m_tiles.clear();
+        m_uses.clear();
+    }
+
+    void setCapacity(size_t capacity)
+    {
+        m_capacity = std::max<size_t>(capacity, 1);
+        evict();
+    }
+
+    inline size_t capacity() const { return m_capacity; }
+    inline size_t size() const { return m_tiles.size(); }
+};
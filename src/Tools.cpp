@@ -40,4 +40,26 @@ namespace Tools
 
         return image;
     }
-}
\ No newline at end of file
+
+    bool updateTexture(sf::Texture & texture, const cv::Mat & rgba, const std::vector<cv::Rect> & regions)
+    {
+        PROFILE_FUNCTION();
+
+        if (texture.getSize().x != (unsigned)rgba.cols || texture.getSize().y != (unsigned)rgba.rows)
+        {
+            texture.create(rgba.cols, rgba.rows);
+            cv::Mat pixels = rgba.isContinuous() ? rgba : rgba.clone();
+            texture.update(pixels.ptr());
+            return true;
+        }
+
+        for (auto & region : regions)
+        {
+            // sf::Texture wants tightly packed pixels, a region narrower than the image is not
+            cv::Mat pixels = rgba(region);
+            if (!pixels.isContinuous()) { pixels = pixels.clone(); }
+            texture.update(pixels.ptr(), region.width, region.height, region.x, region.y);
+        }
+        return false;
+    }
+}
@@ -10,4 +10,9 @@ namespace Tools
     int getClickedCircleIndex(float mx, float my, std::vector<sf::CircleShape> & circles);
 
     sf::Image matToSfImage(const cv::Mat & mat);
+
+    // uploads regions of an RGBA (CV_8UC4) image to a texture, only those pixels are sent to the GPU
+    // if the texture does not have the size of the image yet it is recreated and the whole image is uploaded
+    // returns true when the texture was recreated, so sprites using it need their texture rect reset
+    bool updateTexture(sf::Texture & texture, const cv::Mat & rgba, const std::vector<cv::Rect> & regions);
 }
\ No newline at end of file
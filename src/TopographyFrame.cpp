@@ -0,0 +1,182 @@
+#include "TopographyFrame.h"
+#include "Profiler.hpp"
+
+#include <chrono>
+
+namespace
+{
+    // the projection matrix the way it is stored in the cache
+    cv::Matx33d toMatx(const cv::Mat & matrix)
+    {
+        cv::Matx33d key;
+        matrix.convertTo(key, CV_64F);
+        return key;
+    }
+
+    // converts [0, 1] floats to grayscale RGBA, when rgba is a region of a larger image it is written in place
+    void floatToRGBA(const cv::Mat & input, cv::Mat & rgba)
+    {
+        cv::Mat gray;
+        input.convertTo(gray, CV_8U, 255.0);
+        cv::cvtColor(gray, rgba, cv::COLOR_GRAY2RGBA);
+    }
+}
+
+TopographyFrame::TopographyFrame(const cv::Mat & topography, const cv::Mat & rawDepth, const std::vector<Gesture> & gestures, size_t id, size_t calibrationVersion, const TileMask & dirtyTiles, const Ptr & previous)
+    : m_topography(topography)
+    , m_rawDepth(rawDepth)
+    , m_gestures(gestures)
+    , m_id(id)
+    , m_calibrationVersion(calibrationVersion)
+    , m_dirtyTiles(dirtyTiles)
+    , m_previous(previous)
+{
+    m_timestamp = std::chrono::time_point_cast<std::chrono::microseconds>(std::chrono::system_clock::now()).time_since_epoch().count();
+    if (previous) { m_previousID = previous->id(); }
+
+    // without a mask that matches the topography nothing can be assumed to be unchanged
+    if (!m_dirtyTiles.covers(m_topography.size()))
+    {
+        m_dirtyTiles = TileMask(m_topography.size(), DirtyTileTracker::TileSize, true);
+    }
+}
+
+const cv::Mat & TopographyFrame::topography8U() const
+{
+    std::call_once(m_topography8UOnce, [&]()
+    {
+        PROFILE_SCOPE("TopographyFrame 8U");
+        m_topography.convertTo(m_topography8U, CV_8U, 255.0);
+    });
+    return m_topography8U;
+}
+
+const cv::Mat & TopographyFrame::rgba() const
+{
+    std::call_once(m_rgbaOnce, [&]()
+    {
+        PROFILE_SCOPE("TopographyFrame RGBA");
+        cv::cvtColor(topography8U(), m_rgba, cv::COLOR_GRAY2RGBA);
+    });
+    return m_rgba;
+}
+
+std::shared_ptr<TopographyFrame::Projection> TopographyFrame::findProjection(const cv::Matx33d & matrix, cv::Size size, bool create) const
+{
+    // the lock only guards the list, the warp itself runs outside of it so different projections can be computed in parallel
+    std::lock_guard<std::mutex> lock(m_projectionLock);
+    for (auto & projection : m_projections)
+    {
+        if (projection->size == size && projection->matrix == matrix) { return projection; }
+    }
+    if (!create) { return nullptr; }
+
+    auto projection = std::make_shared<Projection>();
+    projection->matrix = matrix;
+    projection->size = size;
+    m_projections.push_back(projection);
+    return projection;
+}
+
+// the output rectangles covering every dirty tile once warped
+// the tiles grow by a pixel before and after the warp so the bilinear neighbours of their edges are included
+std::vector<cv::Rect> TopographyFrame::projectDirtyTiles(const cv::Matx33d & matrix, cv::Size size) const
+{
+    std::vector<cv::Rect> rects;
+    const cv::Rect output(cv::Point(0, 0), size);
+    for (auto & tile : m_dirtyTiles.dirtyRects())
+    {
+        std::vector<cv::Point2f> corners = {
+            cv::Point2f((float)tile.x - 1, (float)tile.y - 1),
+            cv::Point2f((float)tile.br().x + 1, (float)tile.y - 1),
+            cv::Point2f((float)tile.x - 1, (float)tile.br().y + 1),
+            cv::Point2f((float)tile.br().x + 1, (float)tile.br().y + 1),
+        };
+        cv::perspectiveTransform(corners, corners, matrix);
+
+        cv::Rect rect = cv::boundingRect(corners);
+        rect = cv::Rect(rect.x - 1, rect.y - 1, rect.width + 2, rect.height + 2) & output;
+        if (!rect.empty()) { rects.push_back(rect); }
+    }
+    return rects;
+}
+
+const cv::Mat & TopographyFrame::projected(const cv::Mat & matrix, cv::Size size) const
+{
+    const cv::Matx33d key = toMatx(matrix);
+    auto projection = findProjection(key, size, true);
+    std::call_once(projection->warpOnce, [&]()
+    {
+        PROFILE_SCOPE("TopographyFrame Projection");
+
+        auto previousFrame = m_previous.lock();
+        auto previous = previousFrame ? previousFrame->findProjection(key, size, false) : nullptr;
+        if (!previous || !previous->warpReady || m_dirtyTiles.all())
+        {
+            cv::warpPerspective(m_topography, projection->warped, key, size);
+            projection->warpChanged = { cv::Rect(cv::Point(0, 0), size) };
+        }
+        else
+        {
+            // start from the previous warp and only warp the regions the dirty tiles land on
+            projection->warpChanged = projectDirtyTiles(key, size);
+            if (projection->warpChanged.empty())
+            {
+                projection->warped = previous->warped;
+            }
+            else
+            {
+                projection->warped = previous->warped.clone();
+                for (auto & rect : projection->warpChanged)
+                {
+                    cv::Matx33d shift(1, 0, -rect.x, 0, 1, -rect.y, 0, 0, 1);
+                    cv::Mat region = projection->warped(rect);
+                    cv::warpPerspective(m_topography, region, shift * key, rect.size());
+                }
+            }
+        }
+        projection->warpReady = true;
+    });
+    return projection->warped;
+}
+
+const cv::Mat & TopographyFrame::projectedRGBA(const cv::Mat & matrix, cv::Size size, std::vector<cv::Rect> * changed) const
+{
+    const cv::Matx33d key = toMatx(matrix);
+    auto projection = findProjection(key, size, true);
+    const cv::Mat & warped = projected(matrix, size);
+    std::call_once(projection->rgbaOnce, [&]()
+    {
+        PROFILE_SCOPE("TopographyFrame Projection RGBA");
+
+        auto previousFrame = m_previous.lock();
+        auto previous = previousFrame ? previousFrame->findProjection(key, size, false) : nullptr;
+        if (!previous || !previous->rgbaReady)
+        {
+            floatToRGBA(warped, projection->rgba);
+            projection->rgbaChanged = { cv::Rect(cv::Point(0, 0), size) };
+        }
+        else
+        {
+            // the previous image went through the previous warp, so the same rectangles changed in both
+            projection->rgbaChanged = projection->warpChanged;
+            if (projection->rgbaChanged.empty())
+            {
+                projection->rgba = previous->rgba;
+            }
+            else
+            {
+                projection->rgba = previous->rgba.clone();
+                for (auto & rect : projection->rgbaChanged)
+                {
+                    cv::Mat region = projection->rgba(rect);
+                    floatToRGBA(warped(rect), region);
+                }
+            }
+        }
+        projection->rgbaReady = true;
+    });
+
+    if (changed) { *changed = projection->rgbaChanged; }
+    return projection->rgba;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "DirtyTiles.h"
+
+#include <opencv2/opencv.hpp>
+#include <SFML/Graphics.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct Gesture
+{
+    char type = 0;
+    cv::Point position;
+};
+
+// One frame of topography data as produced by a source
+// A frame never changes after it is built, so every processor can share the same instance without copying.
+// Derived products are computed the first time somebody asks for them and cached on the frame,
+// so no matter how many processors want the 8 bit image or the same projection it is only computed once.
+// When the previous frame is still alive its products are reused and only the dirty tiles are computed again.
+class TopographyFrame
+{
+    // a cached warp of the topography for one projection matrix and output size
+    struct Projection
+    {
+        cv::Matx33d             matrix;
+        cv::Size                size;
+        std::once_flag          warpOnce;
+        std::once_flag          rgbaOnce;
+        std::atomic<bool>       warpReady = false;
+        std::atomic<bool>       rgbaReady = false;
+        cv::Mat                 warped;
+        cv::Mat                 rgba;
+        std::vector<cv::Rect>   warpChanged;        // output pixels that differ from the previous frame's warp
+        std::vector<cv::Rect>   rgbaChanged;        // and from the previous frame's RGBA image
+    };
+
+    cv::Mat                 m_topography;           // normalized heights, CV_32F in [0, 1]
+    cv::Mat                 m_rawDepth;             // depth as the source measured it, may be empty
+    std::vector<Gesture>    m_gestures;
+    long long               m_timestamp = 0;        // microseconds since epoch
+    size_t                  m_id = 0;
+    size_t                  m_previousID = SIZE_MAX;
+    size_t                  m_calibrationVersion = 0;
+    TileMask                m_dirtyTiles;
+
+    // products of the previous frame are only borrowed while it is still held by somebody else
+    std::weak_ptr<const TopographyFrame> m_previous;
+
+    mutable std::once_flag  m_topography8UOnce;
+    mutable cv::Mat         m_topography8U;
+    mutable std::once_flag  m_rgbaOnce;
+    mutable cv::Mat         m_rgba;
+
+    mutable std::mutex      m_projectionLock;
+    mutable std::vector<std::shared_ptr<Projection>> m_projections;
+
+    std::shared_ptr<Projection> findProjection(const cv::Matx33d & matrix, cv::Size size, bool create) const;
+    std::vector<cv::Rect> projectDirtyTiles(const cv::Matx33d & matrix, cv::Size size) const;
+
+public:
+
+    typedef std::shared_ptr<const TopographyFrame> Ptr;
+
+    TopographyFrame(const cv::Mat & topography,
+                    const cv::Mat & rawDepth = cv::Mat(),
+                    const std::vector<Gesture> & gestures = {},
+                    size_t id = 0,
+                    size_t calibrationVersion = 0,
+                    const TileMask & dirtyTiles = TileMask(),
+                    const Ptr & previous = nullptr);
+
+    TopographyFrame(const TopographyFrame &) = delete;
+    TopographyFrame & operator=(const TopographyFrame &) = delete;
+
+    inline const cv::Mat & topography() const { return m_topography; }
+    inline const cv::Mat & rawDepth() const { return m_rawDepth; }
+    inline const std::vector<Gesture> & gestures() const { return m_gestures; }
+    inline long long timestamp() const { return m_timestamp; }
+    inline size_t id() const { return m_id; }
+    inline size_t previousID() const { return m_previousID; }
+    inline size_t calibrationVersion() const { return m_calibrationVersion; }
+    inline const TileMask & dirtyTiles() const { return m_dirtyTiles; }
+    inline bool empty() const { return m_topography.rows <= 0 || m_topography.cols <= 0; }
+
+    // the topography scaled to [0, 255], CV_8U
+    const cv::Mat & topography8U() const;
+
+    // the topography as grayscale RGBA, CV_8UC4, ready to be uploaded to a texture
+    const cv::Mat & rgba() const;
+
+    // the topography warped by a perspective matrix, cached per (matrix, size)
+    const cv::Mat & projected(const cv::Mat & matrix, cv::Size size) const;
+
+    // the projected topography as grayscale RGBA
+    // changed receives the rectangles that differ from the previous frame's projected image
+    const cv::Mat & projectedRGBA(const cv::Mat & matrix, cv::Size size, std::vector<cv::Rect> * changed = nullptr) const;
+};
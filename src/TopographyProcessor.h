@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Save.hpp"
+#include "TopographyFrame.h"
 
 #include <opencv2/opencv.hpp>
 #include <SFML/Graphics.hpp>
@@ -16,4 +17,15 @@ public:
     virtual void load(const Save & save) = 0;
 
     virtual void processTopography(const cv::Mat & data) = 0;
+
+    // true while the processor changes its output every frame on its own, like a running simulation
+    // the scene keeps processing and stays at full rate while any enabled processor is animating
+    virtual bool isAnimating() const { return false; }
+
+    // called by the scene with the frame shared between all processors
+    // override this to use the derived products cached on the frame instead of computing them again
+    virtual void processFrame(const TopographyFrame::Ptr & frame)
+    {
+        processTopography(frame->topography());
+    }
 };
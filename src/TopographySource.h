@@ -1,16 +1,11 @@
 #pragma once
 
 #include "Save.hpp"
+#include "TopographyFrame.h"
 
 #include <opencv2/opencv.hpp>
 #include <SFML/Graphics.hpp>
 
-struct Gesture
-{
-    char type = 0;
-    cv::Point position;
-};
-
 class TopographySource
 {
 public:
@@ -23,4 +18,10 @@ public:
 
     virtual cv::Mat getTopography() = 0;
     virtual std::vector<Gesture> getGestures() { return {}; };
+
+    // depth as measured before normalization, handed to processors through the frame
+    virtual cv::Mat getRawDepth() { return cv::Mat(); }
+
+    // changes whenever the mapping from raw depth to topography changes
+    virtual size_t getCalibrationVersion() const { return 0; }
 };
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include "WaterGrid.h"
+#include "Profiler.hpp"
+
+#include <opencv2/core.hpp>
+#include <immintrin.h> // For AVX intrinsics
+
+#include <algorithm>
+
+namespace
+{
+    // rows per band handed to one thread, each pass reads one row above and below its band
+    constexpr int BandRows = 16;
+
+    // the grids of one simulation as raw continuous arrays, stride is the row length
+    struct WaterView
+    {
+        const float *   terrain;
+        const float *   depth;
+        float *         nextDepth;
+        float *         left;
+        float *         right;
+        float *         up;
+        float *         down;
+        int             cols;
+        int             rows;
+        float           conductance;
+        float           damping;
+        float           keep;               // 1 - evaporation
+    };
+
+    // the pipes of one cell, a pipe through the border never carries anything
+    inline void flowCell(const WaterView & v, int i, int j)
+    {
+        const size_t c = (size_t)i * v.cols + j;
+        const float h = v.terrain[c] + v.depth[c];
+        auto pipe = [&](float flow, size_t n, bool open)
+        {
+            return open ? std::max(0.0f, flow * v.damping + v.conductance * (h - (v.terrain[n] + v.depth[n]))) : 0.0f;
+        };
+
+        float l = pipe(v.left[c], c - 1, j > 0);
+        float r = pipe(v.right[c], c + 1, j < v.cols - 1);
+        float u = pipe(v.up[c], c - v.cols, i > 0);
+        float d = pipe(v.down[c], c + v.cols, i < v.rows - 1);
+
+        // a cell can't give away more water than it holds
+        float k = std::min(1.0f, v.depth[c] / std::max(l + r + u + d, 1e-12f));
+        v.left[c] = l * k;
+        v.right[c] = r * k;
+        v.up[c] = u * k;
+        v.down[c] = d * k;
+    }
+
+    void flowRow(const WaterView & v, int i)
+    {
+        int j = 0;
+        if (i > 0 && i < v.rows - 1)
+        {
+            flowCell(v, i, 0);
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 tiny = _mm256_set1_ps(1e-12f);
+            const __m256 damping = _mm256_set1_ps(v.damping);
+            const __m256 conductance = _mm256_set1_ps(v.conductance);
+            for (j = 1; j <= v.cols - 9; j += 8)
+            {
+                const size_t c = (size_t)i * v.cols + j;
+                __m256 depth = _mm256_loadu_ps(v.depth + c);
+                __m256 h = _mm256_add_ps(_mm256_loadu_ps(v.terrain + c), depth);
+                auto pipe = [&](const float * flow, size_t n)
+                {
+                    __m256 neighbour = _mm256_add_ps(_mm256_loadu_ps(v.terrain + n), _mm256_loadu_ps(v.depth + n));
+                    __m256 f = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(flow + c), damping), _mm256_mul_ps(conductance, _mm256_sub_ps(h, neighbour)));
+                    return _mm256_max_ps(zero, f);
+                };
+
+                __m256 l = pipe(v.left, c - 1);
+                __m256 r = pipe(v.right, c + 1);
+                __m256 u = pipe(v.up, c - v.cols);
+                __m256 d = pipe(v.down, c + v.cols);
+
+                __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(l, r), u), d);
+                __m256 k = _mm256_min_ps(one, _mm256_div_ps(depth, _mm256_max_ps(sum, tiny)));
+                _mm256_storeu_ps(v.left + c, _mm256_mul_ps(l, k));
+                _mm256_storeu_ps(v.right + c, _mm256_mul_ps(r, k));
+                _mm256_storeu_ps(v.up + c, _mm256_mul_ps(u, k));
+                _mm256_storeu_ps(v.down + c, _mm256_mul_ps(d, k));
+            }
+        }
+
+        // the first and last row and the columns after the last full vector
+        for (; j < v.cols; j++) { flowCell(v, i, j); }
+    }
+
+    // what flows in from the neighbours minus what flows out, pipes into the border are always empty
+    inline void depthCell(const WaterView & v, int i, int j)
+    {
+        const size_t c = (size_t)i * v.cols + j;
+        float in = (j > 0 ? v.right[c - 1] : 0.0f) + (j < v.cols - 1 ? v.left[c + 1] : 0.0f)
+                 + (i > 0 ? v.down[c - v.cols] : 0.0f) + (i < v.rows - 1 ? v.up[c + v.cols] : 0.0f);
+        float out = v.left[c] + v.right[c] + v.up[c] + v.down[c];
+        v.nextDepth[c] = std::max(0.0f, (v.depth[c] + in - out) * v.keep);
+    }
+
+    void depthRow(const WaterView & v, int i)
+    {
+        int j = 0;
+        if (i > 0 && i < v.rows - 1)
+        {
+            depthCell(v, i, 0);
+            const __m256 zero = _mm256_setzero_ps();
+            const __m256 keep = _mm256_set1_ps(v.keep);
+            for (j = 1; j <= v.cols - 9; j += 8)
+            {
+                const size_t c = (size_t)i * v.cols + j;
+                __m256 in = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(v.right + c - 1), _mm256_loadu_ps(v.left + c + 1)),
+                                          _mm256_loadu_ps(v.down + c - v.cols)), _mm256_loadu_ps(v.up + c + v.cols));
+                __m256 out = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(v.left + c), _mm256_loadu_ps(v.right + c)),
+                                           _mm256_loadu_ps(v.up + c)), _mm256_loadu_ps(v.down + c));
+                __m256 depth = _mm256_add_ps(_mm256_loadu_ps(v.depth + c), in);
+                _mm256_storeu_ps(v.nextDepth + c, _mm256_max_ps(zero, _mm256_mul_ps(_mm256_sub_ps(depth, out), keep)));
+            }
+        }
+
+        for (; j < v.cols; j++) { depthCell(v, i, j); }
+    }
+
+    template <class RowFunction>
+    void forEachBand(int rows, RowFunction rowFunction)
+    {
+        const int bands = (rows + BandRows - 1) / BandRows;
+        cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range & range)
+        {
+            for (int b = range.start; b < range.end; b++)
+            {
+                for (int i = b * BandRows; i < std::min((b + 1) * BandRows, rows); i++)
+                {
+                    rowFunction(i);
+                }
+            }
+        });
+    }
+}
+
+int WaterGrid::update(const cv::Mat & topography, int iterations, float budgetMS)
+{
+    PROFILE_FUNCTION();
+
+    if (topography.rows <= 0 || topography.cols <= 0) { return 0; }
+
+    // new water for a new size, everything flows from rest
+    if (m_depth.size() != topography.size())
+    {
+        m_depth = cv::Mat(topography.size(), CV_32F, 0.f);
+        m_nextDepth = cv::Mat(topography.size(), CV_32F, 0.f);
+        m_flowLeft = cv::Mat(topography.size(), CV_32F, 0.f);
+        m_flowRight = cv::Mat(topography.size(), CV_32F, 0.f);
+        m_flowUp = cv::Mat(topography.size(), CV_32F, 0.f);
+        m_flowDown = cv::Mat(topography.size(), CV_32F, 0.f);
+    }
+    topography.convertTo(m_terrain, CV_32F, m_parameters.heightScale);
+
+    const int64 start = cv::getTickCount();
+    int done = 0;
+    for (; done < iterations; done++)
+    {
+        if (budgetMS > 0.0f && (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency() > budgetMS) { break; }
+
+        addWater();
+        updateFlow();
+        updateDepth();
+    }
+    return done;
+}
+
+void WaterGrid::addWater()
+{
+    PROFILE_FUNCTION();
+
+    if (m_parameters.rain != 0.0f)
+    {
+        m_depth += m_parameters.rain;
+    }
+
+    const cv::Rect bounds(0, 0, m_depth.cols, m_depth.rows);
+    for (auto & source : m_sources)
+    {
+        cv::Rect area = source.m_area & bounds;
+        if (area.empty()) { continue; }
+
+        cv::Mat depth = m_depth(area);
+        depth += source.m_rate;
+        if (source.m_rate < 0.0f) { depth = cv::max(depth, 0.0f); }
+    }
+}
+
+void WaterGrid::updateFlow()
+{
+    PROFILE_FUNCTION();
+
+    WaterView view = { m_terrain.ptr<float>(), m_depth.ptr<float>(), m_nextDepth.ptr<float>(),
+        m_flowLeft.ptr<float>(), m_flowRight.ptr<float>(), m_flowUp.ptr<float>(), m_flowDown.ptr<float>(),
+        m_depth.cols, m_depth.rows, m_parameters.conductance, m_parameters.damping, 1.0f - m_parameters.evaporation };
+
+    // every cell only writes its own pipes, so bands don't have to wait for each other
+    forEachBand(m_depth.rows, [&](int i) { flowRow(view, i); });
+}
+
+void WaterGrid::updateDepth()
+{
+    PROFILE_FUNCTION();
+
+    WaterView view = { m_terrain.ptr<float>(), m_depth.ptr<float>(), m_nextDepth.ptr<float>(),
+        m_flowLeft.ptr<float>(), m_flowRight.ptr<float>(), m_flowUp.ptr<float>(), m_flowDown.ptr<float>(),
+        m_depth.cols, m_depth.rows, m_parameters.conductance, m_parameters.damping, 1.0f - m_parameters.evaporation };
+
+    forEachBand(m_depth.rows, [&](int i) { depthRow(view, i); });
+
+    // Swap matrices to avoid copying
+    std::swap(m_depth, m_nextDepth);
+}
+
+void WaterGrid::reset()
+{
+    m_depth.release();
+    m_nextDepth.release();
+    m_normalized.release();
+}
+
+const cv::Mat & WaterGrid::normalizedData(float fullDepth)
+{
+    PROFILE_FUNCTION();
+
+    if (m_depth.empty()) { return m_normalized; }
+    m_normalized = cv::min(m_depth * (1.0f / std::max(fullDepth, 1e-6f)), 1.0f);
+    return m_normalized;
+}
+
+double WaterGrid::volume() const
+{
+    return m_depth.empty() ? 0.0 : cv::sum(m_depth)[0];
+}
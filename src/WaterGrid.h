@@ -0,0 +1,93 @@
+#pragma once
+
+#include "opencv2/core.hpp"
+
+#include <vector>
+
+// Water added to the grid every iteration, a spring when positive, a drain when negative
+struct WaterSource
+{
+    float       m_rate;                 // depth added to every cell of the area per iteration
+    cv::Rect    m_area;
+
+    WaterSource(const cv::Rect & area, const float rate)
+        : m_rate(rate)
+        , m_area(area)
+    {
+
+    }
+
+    bool contains(cv::Point point)
+    {
+        return m_area.contains(point);
+    }
+};
+
+struct WaterParameters
+{
+    float   heightScale = 60.0f;        // terrain height in cells for a topography value of 1
+    float   conductance = 0.2f;         // flux gained per iteration per cell of height difference, dt * g * A / l
+    float   damping = 0.995f;           // fraction of the flux that survives an iteration
+    float   evaporation = 0.0005f;      // fraction of the depth lost per iteration
+    float   rain = 0.0f;                // depth added to every cell per iteration
+};
+
+// Shallow water flow over the sand with the virtual pipes model (O'Brien and Hodgins 1995, Mei et al. 2007)
+// Every cell holds a water depth and the flow through a pipe to each of its four neighbours.
+// The flow through a pipe speeds up with the difference of terrain plus water height and is scaled down
+// where it would take out more water than the cell has, so the depth never goes negative and water is conserved
+// up to evaporation. The grid border is a wall.
+// An iteration is two passes over the grid, one for the pipes and one for the depths, each spread over
+// bands of rows with AVX2 doing 8 cells at a time. Iterations stop early when the time budget runs out.
+class WaterGrid
+{
+    cv::Mat     m_terrain;              // topography times heightScale
+    cv::Mat     m_depth;
+    cv::Mat     m_nextDepth;
+    cv::Mat     m_flowLeft;             // flow out of a cell through each of its pipes
+    cv::Mat     m_flowRight;
+    cv::Mat     m_flowUp;
+    cv::Mat     m_flowDown;
+    cv::Mat     m_normalized;
+    std::vector<WaterSource> m_sources;
+
+    void addWater();
+    void updateFlow();
+    void updateDepth();
+
+public:
+
+    WaterParameters m_parameters;
+
+    WaterGrid() = default;
+
+    // runs up to iterations steps on the topography, stops once budgetMS is used up when it is positive
+    // returns how many iterations ran
+    int update(const cv::Mat & topography, int iterations, float budgetMS);
+
+    // removes all water
+    void reset();
+
+    inline const cv::Mat & depth() const { return m_depth; }
+
+    // the depth divided by fullDepth and clamped to [0, 1] for drawing, as of the last update
+    const cv::Mat & normalizedData(float fullDepth);
+
+    // total water on the grid
+    double volume() const;
+
+    void addSource(const WaterSource & source)
+    {
+        m_sources.push_back(source);
+    }
+
+    std::vector<WaterSource> & getSources()
+    {
+        return m_sources;
+    }
+
+    void clearSources()
+    {
+        m_sources.clear();
+    }
+};
@@ -0,0 +1,246 @@
+#include "Check.hpp"
+
+#include "BlockDelta.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // what a server holds after applying messages, block names of a box of the world, "" where nothing arrived
+    struct World
+    {
+        int     x = 0, y = 0, z = 0;
+        int     sizeX = 0, sizeY = 0, sizeZ = 0;
+        std::vector<std::string> blocks;
+
+        World(int wx, int wy, int wz, int sx, int sy, int sz)
+            : x(wx), y(wy), z(wz), sizeX(sx), sizeY(sy), sizeZ(sz), blocks((size_t)sx * sy * sz)
+        {
+
+        }
+
+        std::string * at(int bx, int by, int bz)
+        {
+            if (bx < x || by < y || bz < z || bx >= x + sizeX || by >= y + sizeY || bz >= z + sizeZ) { return nullptr; }
+            return &blocks[((size_t)(bz - z) * sizeX + (bx - x)) * sizeY + (by - y)];
+        }
+    };
+
+    uint64_t readVarint(const std::string & data, size_t & pos)
+    {
+        uint64_t value = 0;
+        for (int shift = 0; ; shift += 7)
+        {
+            const uint8_t byte = (uint8_t)data.at(pos++);
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (byte < 0x80) { return value; }
+        }
+    }
+
+    int64_t readSigned(const std::string & data, size_t & pos)
+    {
+        const uint64_t value = readVarint(data, pos);
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    size_t readLength(const std::string & data, size_t & pos, size_t length)
+    {
+        if (length < 15) { return length; }
+        uint8_t byte;
+        do
+        {
+            byte = (uint8_t)data.at(pos++);
+            length += byte;
+        } while (byte == 255);
+        return length;
+    }
+
+    // one raw LZ4 block, written from the block format description and not from the compressor
+    std::string lz4Decompress(const std::string & data, size_t pos, size_t size)
+    {
+        std::string out;
+        while (pos < data.size())
+        {
+            const uint8_t token = (uint8_t)data[pos++];
+            const size_t literals = readLength(data, pos, token >> 4);
+            out.append(data, pos, literals);
+            pos += literals;
+            if (pos >= data.size()) { break; }
+
+            const size_t offset = (uint8_t)data.at(pos) | ((size_t)(uint8_t)data.at(pos + 1) << 8);
+            pos += 2;
+            const size_t length = readLength(data, pos, token & 15) + 4;
+            if (offset == 0 || offset > out.size()) { return std::string(); }
+            const size_t start = out.size() - offset;
+            for (size_t i = 0; i < length; i++) { out.push_back(out[start + i]); }
+        }
+        return out.size() == size ? out : std::string();
+    }
+
+    // applies one message to the world, false when it can't be read
+    bool applyMessage(const std::string & message, World & world)
+    {
+        if (message.compare(0, 4, "SBD\x01", 4) != 0 || message.size() < 5) { return false; }
+
+        std::string data;
+        size_t pos = 5;
+        if (message[4] & 1)
+        {
+            const size_t size = readVarint(message, pos);
+            data = lz4Decompress(message, pos, size);
+            if (data.empty()) { return false; }
+        }
+        else
+        {
+            data = message.substr(5);
+        }
+
+        pos = 0;
+        std::vector<std::string> palette(readVarint(data, pos));
+        for (auto & name : palette)
+        {
+            const size_t length = readVarint(data, pos);
+            name = data.substr(pos, length);
+            pos += length;
+        }
+        const int baseY = (int)readSigned(data, pos);
+
+        const size_t sections = readVarint(data, pos);
+        for (size_t s = 0; s < sections; s++)
+        {
+            const int sx = (int)readSigned(data, pos);
+            const int sz = (int)readSigned(data, pos);
+            const size_t columns = readVarint(data, pos);
+            for (size_t c = 0; c < columns; c++)
+            {
+                const uint8_t local = (uint8_t)data.at(pos++);
+                const int bx = sx * 16 + (local & 15), bz = sz * 16 + (local >> 4);
+                const size_t runs = readVarint(data, pos);
+                int by = baseY;
+                for (size_t r = 0; r < runs; r++)
+                {
+                    const size_t length = readVarint(data, pos);
+                    const size_t block = readVarint(data, pos);
+                    for (size_t i = 0; i < length; i++, by++)
+                    {
+                        std::string * cell = world.at(bx, by, bz);
+                        if (!cell) { return false; }
+                        if (block < palette.size()) { *cell = palette[block]; }
+                    }
+                }
+            }
+        }
+        return pos == data.size();
+    }
+
+    // every block of the volume arrived with its name
+    bool matches(World & world, const ColumnCube<uint8_t> & volume, const std::vector<std::string> & names)
+    {
+        for (int vz = 0; vz < (int)volume.sizeZ(); vz++)
+        {
+            for (int vx = 0; vx < (int)volume.sizeX(); vx++)
+            {
+                for (int vy = 0; vy < (int)volume.sizeY(); vy++)
+                {
+                    if (*world.at(world.x + vx, world.y + vy, world.z + vz) != names[volume.get(vx, vy, vz)]) { return false; }
+                }
+            }
+        }
+        return true;
+    }
+
+    // random layers in every column, from a single run up to runs one block high
+    void randomColumns(ColumnCube<uint8_t> & volume, std::mt19937 & rng, size_t blockCount, size_t columns)
+    {
+        for (size_t i = 0; i < columns; i++)
+        {
+            const size_t x = rng() % volume.sizeX(), z = rng() % volume.sizeZ();
+            const int layers = 1 + rng() % 24;
+            for (int l = 0; l < layers; l++)
+            {
+                const int y1 = rng() % volume.sizeY();
+                const int y2 = y1 + (l % 4 == 0 ? 0 : rng() % 12);
+                volume.fill((int)x, y1, (int)z, (int)x, y2, (int)z, (uint8_t)(rng() % blockCount));
+            }
+        }
+    }
+
+    // volumes encoded, compressed or not, and decoded by an independent reader give back every block,
+    // a second encode only sends the columns that changed and brings the world up to date again
+    void roundTrip(bool compress)
+    {
+        const std::vector<std::string> names = { "minecraft:air", "minecraft:stone", "minecraft:dirt", "minecraft:grass_block", "minecraft:water" };
+        const int x = -21, y = -7, z = 13;
+        ColumnCube<uint8_t> volume(40, 70, 37, 1);
+        std::mt19937 rng(compress ? 5 : 6);
+        randomColumns(volume, rng, names.size(), 600);
+
+        mc::BlockDeltaEncoder encoder;
+        World world(x, y, z, 40, 70, 37);
+        bool readable = true;
+        auto send = [&](std::string & message) { readable = applyMessage(message, world) && readable; };
+
+        encoder.encode(volume, names, x, y, z, 2000, compress, send);
+        CHECK(readable);
+        CHECK(encoder.stats().messages > 1);
+        CHECK(encoder.stats().columns == volume.sizeX() * volume.sizeZ());
+        CHECK(matches(world, volume, names));
+
+        ColumnCube<uint8_t> changed = volume;
+        randomColumns(changed, rng, names.size(), 30);
+        size_t differing = 0;
+        for (size_t vz = 0; vz < changed.sizeZ(); vz++)
+        {
+            for (size_t vx = 0; vx < changed.sizeX(); vx++)
+            {
+                bool same = changed.runCount(vx, vz) == volume.runCount(vx, vz);
+                for (size_t r = 0; same && r < changed.runCount(vx, vz); r++)
+                {
+                    same = changed.columnRuns(vx, vz)[r].top == volume.columnRuns(vx, vz)[r].top
+                        && changed.columnRuns(vx, vz)[r].value == volume.columnRuns(vx, vz)[r].value;
+                }
+                differing += same ? 0 : 1;
+            }
+        }
+
+        encoder.encode(changed, names, x, y, z, 2000, compress, send);
+        CHECK(readable);
+        CHECK(encoder.stats().columns == differing);
+        CHECK(matches(world, changed, names));
+
+        // nothing changed, nothing is sent, after reset everything is
+        encoder.encode(changed, names, x, y, z, 2000, compress, send);
+        CHECK(encoder.stats().messages == 0);
+        encoder.reset();
+        encoder.encode(changed, names, x, y, z, 2000, compress, send);
+        CHECK(encoder.stats().columns == changed.sizeX() * changed.sizeZ());
+    }
+
+    // long repeats need the extra length bytes of both literals and matches
+    void longRepeats()
+    {
+        std::string raw;
+        for (int i = 0; i < 300; i++) { raw.push_back((char)(i * 7)); }
+        raw.append(5000, 'a');
+        for (int i = 0; i < 40; i++) { raw.append("sand, stone and grass "); }
+        raw.append(raw, 0, 1000);
+
+        std::string compressed;
+        mc::lz4Compress((const uint8_t *)raw.data(), raw.size(), compressed);
+        CHECK(compressed.size() < raw.size() / 4);
+        CHECK(lz4Decompress(compressed, 0, raw.size()) == raw);
+
+        std::string tiny;
+        mc::lz4Compress((const uint8_t *)"sand", 4, tiny);
+        CHECK(lz4Decompress(tiny, 0, 4) == "sand");
+    }
+}
+
+void blockDeltaTests()
+{
+    roundTrip(true);
+    roundTrip(false);
+    longRepeats();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdio>
+
+// A failed check prints where it is and is counted, the test run goes on with the next one
+namespace Check
+{
+    inline int & failures()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline bool check(bool passed, const char * condition, const char * file, int line)
+    {
+        if (!passed)
+        {
+            std::printf("%s:%d: check failed: %s\n", file, line, condition);
+            failures()++;
+        }
+        return passed;
+    }
+}
+
+#define CHECK(condition) Check::check((condition), #condition, __FILE__, __LINE__)
+
+// every test file adds one function that runs its checks
+void pathfindingTests();
+void blockDeltaTests();
+void columnCubeTests();
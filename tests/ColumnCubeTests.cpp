@@ -0,0 +1,65 @@
+#include "Check.hpp"
+
+#include "ColumnCube.hpp"
+
+#include <vector>
+
+namespace
+{
+    typedef ColumnCube<uint8_t> Volume;
+
+    // the runs of a column start at 0, go up and end at the top of the volume
+    bool validColumn(const Volume & volume, size_t x, size_t z)
+    {
+        const Volume::Run * runs = volume.columnRuns(x, z);
+        const size_t count = volume.runCount(x, z);
+        if (count == 0 || count > Volume::MaxRuns || runs[count - 1].top != volume.sizeY()) { return false; }
+        for (size_t r = 1; r < count; r++)
+        {
+            if (runs[r].top <= runs[r - 1].top) { return false; }
+        }
+        return true;
+    }
+
+    // a column striped one block at a time holds exactly MaxRuns runs, one more stripe is cut off instead of
+    // wrapping the byte count, and the columns around it stay as they were
+    void runLimit()
+    {
+        Volume volume(3, 600, 3, 7);
+        for (size_t y = 0; y + 1 < Volume::MaxRuns; y++) { volume.set(1, y, 1, (uint8_t)(y % 2)); }
+        CHECK(volume.runCount(1, 1) == Volume::MaxRuns);
+        CHECK(validColumn(volume, 1, 1));
+        CHECK(volume.get(1, Volume::MaxRuns - 2, 1) == (Volume::MaxRuns - 2) % 2);
+        CHECK(volume.get(1, 599, 1) == 7);
+
+        for (size_t y = Volume::MaxRuns - 1; y < 400; y++) { volume.set(1, y, 1, (uint8_t)(y % 2)); }
+        CHECK(volume.runCount(1, 1) == Volume::MaxRuns);
+        CHECK(validColumn(volume, 1, 1));
+        bool kept = true;
+        for (size_t y = 0; y + 1 < Volume::MaxRuns; y++) { kept = kept && volume.get(1, y, 1) == y % 2; }
+        CHECK(kept);
+
+        for (size_t z = 0; z < 3; z++)
+        {
+            for (size_t x = 0; x < 3; x++)
+            {
+                if (x == 1 && z == 1) { continue; }
+                CHECK(volume.runCount(x, z) == 1 && volume.get(x, 300, z) == 7);
+            }
+        }
+
+        // setColumn with too many runs keeps the first ones and still covers the column
+        std::vector<Volume::Run> runs;
+        for (uint16_t y = 1; y <= 600; y++) { runs.push_back({ y, (uint8_t)(y % 3) }); }
+        volume.setColumn(0, 2, runs.data(), runs.size());
+        CHECK(volume.runCount(0, 2) == Volume::MaxRuns);
+        CHECK(validColumn(volume, 0, 2));
+        CHECK(volume.get(0, 100, 2) == runs[100].value);
+        CHECK(validColumn(volume, 1, 1));
+    }
+}
+
+void columnCubeTests()
+{
+    runLimit();
+}
@@ -0,0 +1,169 @@
+#include "Check.hpp"
+
+#include "AStar.h"
+#include "HierarchicalPathfinder.h"
+#include "Perlin.hpp"
+#include "RegionMap.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // every step of the path can be taken and the steps add up to cost
+    bool validPath(const Grid<float> & heights, const std::vector<State> & path, State start, State goal, int32_t cost, const TraversalCosts & costs)
+    {
+        if (path.empty() || path.front() != start || path.back() != goal) { return false; }
+
+        int32_t total = 0;
+        for (size_t i = 1; i < path.size(); i++)
+        {
+            const State dir(path[i].x - path[i - 1].x, path[i].y - path[i - 1].y);
+            if (std::abs(dir.x) > 1 || std::abs(dir.y) > 1 || (dir.x == 0 && dir.y == 0)) { return false; }
+
+            const int32_t step = AStar::stepCost(heights, path[i - 1], Action(dir, dir.x != 0 && dir.y != 0 ? 141 : 100), costs);
+            if (step < 0) { return false; }
+            total += step;
+        }
+        return total == cost;
+    }
+
+    // hills like the sand, heights in [0, 1]
+    Grid<float> sandHeights(int width, int height, int seed)
+    {
+        Perlin2DNew perlin(512, 512, seed);
+        Grid<float> noise = perlin.GeneratePerlinNoise(5, 0.5f);
+        Grid<float> heights(width, height, 0.0f);
+        for (int y = 0; y < height; y++)
+        {
+            for (int x = 0; x < width; x++) { heights.set(x, y, noise.get(x, y)); }
+        }
+        return heights;
+    }
+
+    // a graph repaired by update() after random edits has to answer like one built from scratch on the same heights
+    void incrementalMatchesFresh()
+    {
+        TraversalCosts costs;
+        costs.minHeight = 0.3f;
+
+        const int width = 300, height = 140;
+        Grid<float> heights = sandHeights(width, height, 3);
+
+        // scattered rocks leave many places that are only connected diagonally
+        std::mt19937 rng(7);
+        for (int i = 0; i < width * height / 4; i++)
+        {
+            heights.set(rng() % width, rng() % height, costs.minHeight - 1.0f);
+        }
+
+        HierarchicalPathfinder repaired;
+        repaired.update(heights, costs);
+
+        std::vector<State> path;
+        std::vector<State> freshPath;
+        AStar astar(true);
+        int graphMismatches = 0;             // entrances differ from the fresh graph
+        int queryMismatches = 0;
+        for (int edit = 0; edit < 40; edit++)
+        {
+            // a hole, a wall or a slope somewhere, every other one a few cells at a corner of the 16 cell clusters,
+            // where the diagonal steps between four clusters are
+            const bool corner = edit % 2 == 1;
+            const int w = corner ? 1 + rng() % 3 : 1 + rng() % 24, h = corner ? 1 + rng() % 3 : 1 + rng() % 24;
+            const int x0 = corner ? std::clamp(16 * (1 + (int)(rng() % (width / 16 - 1))) - (int)(rng() % 3), 0, width - w) : rng() % (width - w);
+            const int y0 = corner ? std::clamp(16 * (1 + (int)(rng() % (height / 16 - 1))) - (int)(rng() % 3), 0, height - h) : rng() % (height - h);
+            const int kind = rng() % 3;
+            const float base = (rng() % 1000) / 1000.0f;
+            for (int y = y0; y < y0 + h; y++)
+            {
+                for (int x = x0; x < x0 + w; x++)
+                {
+                    float value = kind == 0 ? costs.minHeight - 1.0f : (kind == 1 ? 1.0f : base + 0.02f * (x - x0));
+                    heights.set(x, y, value);
+                }
+            }
+
+            repaired.update(heights, costs);
+            HierarchicalPathfinder fresh;
+            fresh.update(heights, costs);
+            if (repaired.nodeCount() != fresh.nodeCount()) { graphMismatches++; }
+
+            // half of the queries stay near the edit so they cross the borders it changed
+            for (int query = 0; query < 60; query++)
+            {
+                const int range = query % 2 ? 40 : std::max(width, height);
+                auto near = [&](int center, int size) { return std::clamp(center - range / 2 + (int)(rng() % range), 0, size - 1); };
+                const State start(near(x0, width), near(y0, height)), goal(near(x0, width), near(y0, height));
+                if (!AStar::passable(heights, start, costs) || !AStar::passable(heights, goal, costs)) { continue; }
+
+                const bool found = repaired.search(start, goal, path);
+                const int32_t cost = repaired.stats().cost;
+                const bool freshFound = fresh.search(start, goal, freshPath);
+                const bool reachable = astar.search(heights, start, goal, costs, freshPath);
+
+                bool same = found == freshFound && found == reachable;
+                if (same && found) { same = cost == fresh.stats().cost && validPath(heights, path, start, goal, cost, costs); }
+                if (!same) { queryMismatches++; }
+            }
+        }
+        CHECK(graphMismatches == 0);
+        CHECK(queryMismatches == 0);
+    }
+
+    // the regions agree with what A* can reach, and weighted A* finds a path whenever there is one
+    // that costs no more than weight times the cheapest
+    void weightedWithinBound()
+    {
+        TraversalCosts costs;
+        costs.minHeight = 0.3f;
+
+        const int width = 240, height = 120;
+        Grid<float> heights = sandHeights(width, height, 5);
+
+        // rocks leave regions that are only joined diagonally, or not at all where a corner is blocked
+        std::mt19937 rng(11);
+        for (int i = 0; i < width * height / 5; i++)
+        {
+            heights.set(rng() % width, rng() % height, costs.minHeight - 1.0f);
+        }
+
+        RegionMap regions;
+        regions.update(heights, costs);
+
+        AStar astar(true);
+        AStar weighted(true);
+        weighted.setWeight(3.0f);
+        std::vector<State> path;
+        int regionMismatches = 0;
+        int weightedMismatches = 0;
+        int unreachable = 0;
+        for (int query = 0; query < 300; query++)
+        {
+            const State start((int)(rng() % width), (int)(rng() % height)), goal((int)(rng() % width), (int)(rng() % height));
+            if (!AStar::passable(heights, start, costs) || !AStar::passable(heights, goal, costs)) { continue; }
+
+            const bool reachable = astar.search(heights, start, goal, costs, path);
+            const int32_t cheapest = astar.stats().cost;
+            if (regions.connected(start, goal) != reachable) { regionMismatches++; }
+            unreachable += reachable ? 0 : 1;
+
+            const bool found = weighted.search(heights, start, goal, costs, path);
+            const int32_t cost = weighted.stats().cost;
+            bool same = found == reachable;
+            if (same && found) { same = cost >= cheapest && cost <= 3 * cheapest && validPath(heights, path, start, goal, cost, costs); }
+            if (!same) { weightedMismatches++; }
+        }
+        CHECK(regions.regionCount() > 1);
+        CHECK(unreachable > 0);
+        CHECK(regionMismatches == 0);
+        CHECK(weightedMismatches == 0);
+    }
+}
+
+void pathfindingTests()
+{
+    incrementalMatchesFresh();
+    weightedWithinBound();
+}
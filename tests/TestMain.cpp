@@ -0,0 +1,18 @@
+// Tests of the code that builds without SFML or OpenCV, run from the repository root:
+//     make test
+// Every failed check is printed, the exit code is the number of failures.
+
+#include "Check.hpp"
+
+#include <cstdio>
+
+int main()
+{
+    pathfindingTests();
+    blockDeltaTests();
+    columnCubeTests();
+
+    if (Check::failures() == 0) { std::printf("All tests passed\n"); }
+    else                        { std::printf("%d checks failed\n", Check::failures()); }
+    return Check::failures();
+}
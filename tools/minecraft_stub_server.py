@@ -0,0 +1,292 @@
+"""Stand-in for the Minecraft HTTP interface on localhost, for testing MinecraftInterface without a server
+
+Answers PUT /blocks (a json list of blocks) and POST /commands (one command per line) the way the
+real interface does and counts what arrives. GET /stats returns the counts as json, POST /reset clears them.
+PUT /blocks also takes the binary column format of BlockDeltaEncoder (src/BlockDelta.h), decode_delta
+below is the reference decoder for it.
+With --apply the blocks are also kept, GET /world lists every block that is not air as [x, y, z, id].
+--delay makes every request take longer and --kbps limits the bandwidth, to see how the sender copes with a slow link.
+
+    python tools/minecraft_stub_server.py [--port 9000] [--quiet] [--apply] [--delay seconds] [--kbps rate]
+"""
+
+import argparse
+import json
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+stats_lock = threading.Lock()
+
+
+def empty_stats():
+    return {"requests": 0, "bytes": 0, "blocks": 0, "commands": 0, "fill_volume": 0, "sections": 0, "columns": 0,
+            "raw_bytes": 0, "seconds": 0.0}
+
+
+stats = empty_stats()
+world = {}
+
+
+def apply_box(x1, y1, z1, x2, y2, z2, block):
+    for x in range(min(x1, x2), max(x1, x2) + 1):
+        for y in range(min(y1, y2), max(y1, y2) + 1):
+            for z in range(min(z1, z2), max(z1, z2) + 1):
+                if block == "minecraft:air":
+                    world.pop((x, y, z), None)
+                else:
+                    world[(x, y, z)] = block
+
+
+def apply_command(command):
+    parts = command.split()
+    if parts[0] == "setblock":
+        x, y, z = (int(p) for p in parts[1:4])
+        apply_box(x, y, z, x, y, z, parts[4])
+    elif parts[0] == "fill" and len(parts) == 8:
+        x1, y1, z1, x2, y2, z2 = (int(p) for p in parts[1:7])
+        apply_box(x1, y1, z1, x2, y2, z2, parts[7])
+
+
+def read_varint(data, pos):
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if byte < 0x80:
+            return value, pos
+
+
+def read_signed(data, pos):
+    value, pos = read_varint(data, pos)
+    return (value >> 1) ^ -(value & 1), pos
+
+
+def lz4_decompress(data, size):
+    """one raw LZ4 block, no frame"""
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        token = data[pos]
+        pos += 1
+        literals = token >> 4
+        if literals == 15:
+            while True:
+                literals += data[pos]
+                pos += 1
+                if data[pos - 1] != 255:
+                    break
+        out += data[pos:pos + literals]
+        pos += literals
+        if pos >= len(data):
+            break
+        offset = data[pos] | (data[pos + 1] << 8)
+        pos += 2
+        length = token & 15
+        if length == 15:
+            while True:
+                length += data[pos]
+                pos += 1
+                if data[pos - 1] != 255:
+                    break
+        length += 4
+        start = len(out) - offset
+        for i in range(length):
+            out.append(out[start + i])
+    if len(out) != size:
+        raise ValueError(f"lz4 block gave {len(out)} bytes instead of {size}")
+    return bytes(out)
+
+
+def decode_delta(body):
+    """returns the uncompressed size, the section count and a list of (x, z, base y, [(length, block name or None)]) columns"""
+    if body[:4] != b"SBD\x01":
+        raise ValueError("not a block delta message")
+    flags = body[4]
+    data = body[5:]
+    if flags & 1:
+        size, pos = read_varint(data, 0)
+        data = lz4_decompress(data[pos:], size)
+
+    pos = 0
+    count, pos = read_varint(data, pos)
+    palette = []
+    for _ in range(count):
+        length, pos = read_varint(data, pos)
+        palette.append(data[pos:pos + length].decode("utf-8"))
+        pos += length
+    base_y, pos = read_signed(data, pos)
+    sections, pos = read_varint(data, pos)
+
+    columns = []
+    for _ in range(sections):
+        sx, pos = read_signed(data, pos)
+        sz, pos = read_signed(data, pos)
+        count, pos = read_varint(data, pos)
+        for _ in range(count):
+            local = data[pos]
+            pos += 1
+            run_count, pos = read_varint(data, pos)
+            runs = []
+            for _ in range(run_count):
+                length, pos = read_varint(data, pos)
+                block, pos = read_varint(data, pos)
+                runs.append((length, palette[block] if block < len(palette) else None))
+            columns.append((sx * 16 + (local & 15), sz * 16 + (local >> 4), base_y, runs))
+    return len(data), sections, columns
+
+
+def apply_column(x, z, y, runs):
+    for length, block in runs:
+        if block is not None:
+            apply_box(x, y, z, x, y + length - 1, z, block)
+        y += length
+
+
+def fill_volume(command):
+    """blocks changed by a fill or setblock command with absolute coordinates"""
+    parts = command.split()
+    try:
+        if parts[0] == "setblock":
+            return 1
+        if parts[0] == "fill":
+            x1, y1, z1, x2, y2, z2 = (int(p) for p in parts[1:7])
+            return (abs(x2 - x1) + 1) * (abs(y2 - y1) + 1) * (abs(z2 - z1) + 1)
+    except (IndexError, ValueError):
+        pass
+    return 0
+
+
+class Handler(BaseHTTPRequestHandler):
+    quiet = False
+    apply = False
+    delay = 0.0
+    kbps = 0.0
+
+    def read_body(self):
+        length = int(self.headers.get("Content-Length", 0))
+        return self.rfile.read(length)
+
+    def reply(self, body, content_type="application/json"):
+        data = body.encode("utf-8")
+        self.send_response(200)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+        self.wfile.write(data)
+
+    def wait(self, size):
+        seconds = self.delay
+        if self.kbps > 0:
+            seconds += size * 8 / (self.kbps * 1000)
+        time.sleep(seconds)
+
+    def count(self, start, size, **counts):
+        with stats_lock:
+            stats["requests"] += 1
+            stats["bytes"] += size
+            for key, value in counts.items():
+                stats[key] += value
+            stats["seconds"] += time.perf_counter() - start
+
+    def do_PUT(self):
+        if not self.path.startswith("/blocks"):
+            self.send_error(404)
+            return
+        start = time.perf_counter()
+        body = self.read_body()
+        if body.startswith(b"SBD"):
+            self.put_delta(start, body)
+            return
+        blocks = json.loads(body)
+        if self.apply:
+            with stats_lock:
+                for b in blocks:
+                    apply_box(b["x"], b["y"], b["z"], b["x"], b["y"], b["z"], b["id"])
+        self.wait(len(body))
+        self.count(start, len(body), blocks=len(blocks))
+        self.reply("\n".join("1" for _ in blocks), "text/plain")
+        if not self.quiet:
+            print(f"PUT /blocks: {len(blocks)} blocks, {len(body)} bytes")
+
+    def put_delta(self, start, body):
+        try:
+            raw_size, sections, columns = decode_delta(body)
+        except (ValueError, IndexError) as e:
+            self.send_error(400, str(e))
+            return
+        blocks = sum(length for _, _, _, runs in columns for length, _ in runs)
+        if self.apply:
+            with stats_lock:
+                for x, z, y, runs in columns:
+                    apply_column(x, z, y, runs)
+        self.wait(len(body))
+        self.count(start, len(body), blocks=blocks, sections=sections, columns=len(columns), raw_bytes=raw_size)
+        self.reply("1", "text/plain")
+        if not self.quiet:
+            print(f"PUT /blocks: {len(columns)} columns in {sections} sections, {len(body)} bytes ({raw_size} uncompressed)")
+
+    def do_POST(self):
+        if self.path.startswith("/reset"):
+            with stats_lock:
+                stats.update(empty_stats())
+                world.clear()
+            self.reply("{}")
+            return
+        if not self.path.startswith("/commands"):
+            self.send_error(404)
+            return
+        start = time.perf_counter()
+        body = self.read_body()
+        commands = [line for line in body.decode("utf-8").split("\n") if line.strip()]
+        volume = sum(fill_volume(c) for c in commands)
+        if self.apply:
+            with stats_lock:
+                for c in commands:
+                    apply_command(c)
+        self.wait(len(body))
+        self.count(start, len(body), commands=len(commands), fill_volume=volume)
+        self.reply("\n".join("1" for _ in commands), "text/plain")
+        if not self.quiet:
+            print(f"POST /commands: {len(commands)} commands for {volume} blocks, {len(body)} bytes")
+
+    def do_GET(self):
+        if self.path.startswith("/stats"):
+            with stats_lock:
+                self.reply(json.dumps(stats))
+            return
+        if self.path.startswith("/world"):
+            with stats_lock:
+                self.reply(json.dumps([[x, y, z, block] for (x, y, z), block in sorted(world.items())]))
+            return
+        self.send_error(404)
+
+    def log_message(self, format, *args):
+        pass
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=9000)
+    parser.add_argument("--quiet", action="store_true")
+    parser.add_argument("--apply", action="store_true", help="keep the blocks for GET /world")
+    parser.add_argument("--delay", type=float, default=0.0, help="seconds added to every request")
+    parser.add_argument("--kbps", type=float, default=0.0, help="bandwidth of the simulated link in kilobits per second")
+    args = parser.parse_args()
+
+    Handler.quiet = args.quiet
+    Handler.apply = args.apply
+    Handler.delay = args.delay
+    Handler.kbps = args.kbps
+    server = ThreadingHTTPServer(("localhost", args.port), Handler)
+    print(f"Minecraft stub listening on http://localhost:{args.port}")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()